@@ -9,15 +9,34 @@ unsigned int binary::BinaryHashtable::hash(std::string value)
     return hasher.hashWithTop8BitsMasked();
 }
 
+unsigned int binary::BinaryHashtable::bucketIndex(const std::string& jsName)
+{
+    return this->hash(jsName) % this->size();
+}
+
 void binary::BinaryHashtable::add(std::string jsName, binary::MetaFileOffset offset)
 {
-    unsigned int tableIndex = this->hash(jsName) % this->size();
+    unsigned int tableIndex = this->bucketIndex(jsName);
     this->elements[tableIndex].push_back(std::make_tuple(jsName, offset));
 }
 
+void binary::BinaryHashtable::expect(const std::string& jsName)
+{
+    this->expectedSizes[this->bucketIndex(jsName)]++;
+}
+
+void binary::BinaryHashtable::reserve(const std::string& jsName, binary::BinaryWriter& heapWriter)
+{
+    unsigned int tableIndex = this->bucketIndex(jsName);
+    if (this->reservedBuckets.count(tableIndex) == 0) {
+        std::vector<MetaFileOffset> placeholders(this->expectedSizes[tableIndex], 0);
+        this->reservedBuckets.emplace(tableIndex, heapWriter.push_binaryArray(placeholders));
+    }
+}
+
 binary::MetaFileOffset binary::BinaryHashtable::get(const std::string& jsName)
 {
-    unsigned int tableIndex = this->hash(jsName) % this->size();
+    unsigned int tableIndex = this->bucketIndex(jsName);
 
     for (std::tuple<std::string, MetaFileOffset>& tuple : this->elements[tableIndex]) {
         if (std::get<0>(tuple) == jsName) {
@@ -33,18 +52,29 @@ unsigned int binary::BinaryHashtable::size()
     return (unsigned int)this->elements.size();
 }
 
-std::vector<binary::MetaFileOffset> binary::BinaryHashtable::serialize(binary::BinaryWriter& heapWriter)
+std::vector<binary::MetaFileOffset> binary::BinaryHashtable::serialize(std::shared_ptr<utils::MemoryStream> heap)
 {
+    binary::BinaryWriter heapWriter(heap);
     std::vector<binary::MetaFileOffset> offsets;
 
-    for (std::vector<std::tuple<std::string, MetaFileOffset> > element : this->elements) {
+    for (unsigned int i = 0; i < this->elements.size(); i++) {
+        std::vector<std::tuple<std::string, MetaFileOffset> >& element = this->elements[i];
         if (element.size() > 0) {
             std::vector<MetaFileOffset> elementOffsets;
             for (std::tuple<std::string, MetaFileOffset>& tuple : element) {
                 elementOffsets.push_back(std::get<1>(tuple));
             }
 
-            offsets.push_back(heapWriter.push_binaryArray(elementOffsets));
+            std::map<unsigned int, MetaFileOffset>::iterator reserved = this->reservedBuckets.find(i);
+            if (reserved != this->reservedBuckets.end() && this->expectedSizes[i] == (MetaArrayCount)element.size()) {
+                // The bucket is written in the same format in a separate stream and then copied over its placeholder
+                std::shared_ptr<utils::MemoryStream> bucket(new utils::MemoryStream());
+                binary::BinaryWriter(bucket).push_binaryArray(elementOffsets);
+                heap->overwrite(reserved->second, *bucket);
+                offsets.push_back(reserved->second);
+            } else {
+                offsets.push_back(heapWriter.push_binaryArray(elementOffsets));
+            }
         } else {
             offsets.push_back(0);
         }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "binaryStructures.h"
+#include "Utils/memoryStream.h"
+#include <map>
 #include <string>
 #include <vector>
 
@@ -14,9 +16,15 @@ namespace binary {
 class BinaryHashtable {
 private:
     std::vector<std::vector<std::tuple<std::string, MetaFileOffset> > > elements;
+    // The number of keys which are expected to be added to each bucket, see expect
+    std::map<unsigned int, MetaArrayCount> expectedSizes;
+    // The offsets of the buckets whose arrays were reserved before the offsets of their keys were known
+    std::map<unsigned int, MetaFileOffset> reservedBuckets;
 
     unsigned int hash(std::string value);
 
+    unsigned int bucketIndex(const std::string& jsName);
+
 public:
     /*
          * \brief Constructs \c BinaryHashtable with the specified size.
@@ -41,6 +49,20 @@ public:
          */
     MetaFileOffset get(const std::string& jsName);
 
+    /*
+         * \brief Counts a key which will be added later, so that its bucket can be reserved before the offset of the key is known.
+         * \param jsName The jsName of the element
+         */
+    void expect(const std::string& jsName);
+
+    /*
+         * \brief Writes a placeholder for the bucket of the key, so that \c serialize writes the bucket there instead of at the end of the heap.
+         * The bucket is sized for the keys passed to \c expect. If it gets a different number of keys, it's written at the end of the heap as usual.
+         * \param jsName The jsName of the element
+         * \param heapWriter Reference to a \c BinaryWriter that will be used for serialization
+         */
+    void reserve(const std::string& jsName, BinaryWriter& heapWriter);
+
     /*
          * \brief Returns the number of keys in this hashtable.
          */
@@ -50,9 +72,9 @@ public:
          * \brief Serializes this hashtable in binary format.
          * The inner representation is serialized as a vectors of vectors in the heap and
          * pointers to this vectors are returned.
-         * \param heapWriter Reference to a \c BinaryWriter that will be used for serialization
+         * \param heap The heap in which the reserved buckets are written
          * \returns vector of offsets pointing to vectors in the heap
          */
-    std::vector<MetaFileOffset> serialize(BinaryWriter& heapWriter);
+    std::vector<MetaFileOffset> serialize(std::shared_ptr<utils::MemoryStream> heap);
 };
 }
@@ -0,0 +1,45 @@
+#include "binaryMembersIndex.h"
+#include "Utils/StringHasher.h"
+#include "binaryWriter.h"
+#include <algorithm>
+
+unsigned int binary::BinaryMembersIndex::hash(const std::string& jsName)
+{
+    StringHasher hasher;
+    hasher.addCharactersAssumingAligned(jsName.c_str(), jsName.size());
+    return hasher.hashWithTop8BitsMasked();
+}
+
+uint16_t binary::BinaryMembersIndex::getBucketsCount(size_t membersCount)
+{
+    // Two members per bucket on average keep both the index and the scanned buckets small
+    uint16_t bucketsCount = 1;
+    while (bucketsCount < membersCount / 2 && bucketsCount < (1 << 15)) {
+        bucketsCount <<= 1;
+    }
+    return bucketsCount;
+}
+
+binary::MetaFileOffset binary::BinaryMembersIndex::save(binary::BinaryWriter& writer)
+{
+    uint16_t bucketsCount = getBucketsCount(this->_entries.size());
+    unsigned int mask = bucketsCount - 1;
+
+    // Members in the same bucket keep their serialized order
+    std::stable_sort(this->_entries.begin(), this->_entries.end(), [mask](const Entry& entry1, const Entry& entry2) {
+        return (entry1.hash & mask) < (entry2.hash & mask);
+    });
+
+    binary::MetaFileOffset offset = writer.push_short((int16_t)bucketsCount);
+    size_t end = 0;
+    for (unsigned int bucket = 0; bucket < bucketsCount; bucket++) {
+        while (end < this->_entries.size() && (this->_entries[end].hash & mask) == bucket) {
+            end++;
+        }
+        writer.push_short((int16_t)end);
+    }
+    for (const Entry& entry : this->_entries) {
+        writer.push_short((int16_t)entry.member);
+    }
+    return offset;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "binaryStructures.h"
+#include <string>
+#include <vector>
+
+namespace binary {
+/*
+     * \class BinaryMembersIndex
+     * \brief A hash index of the methods and properties of an interface or a protocol by jsName.
+     *
+     * The index is written in the heap as 16 bit numbers:
+     *  - the number of buckets, which is a power of two
+     *  - the end of each bucket in the entries, a bucket starts at the end of the previous one
+     *  - an entry for each member: the member array in the upper 2 bits and the index in it in the lower 14 bits
+     *
+     * A member is in bucket <tt>hash(jsName) & (bucketsCount - 1)</tt>, hashed like the global symbols tables.
+     */
+class BinaryMembersIndex {
+public:
+    enum MemberArray : uint8_t {
+        InstanceMethods,
+        StaticMethods,
+        InstanceProperties,
+        StaticProperties
+    };
+
+    // Classes with fewer members are scanned as fast as they are looked up in an index
+    static const size_t MinimumMembersCount = 16;
+
+    static const size_t MaximumArraySize = (1 << 14) - 1;
+
+    static unsigned int hash(const std::string& jsName);
+
+    static uint16_t getBucketsCount(size_t membersCount);
+
+    /*
+         * \brief Adds the members of one of the arrays in their serialized order.
+         * \return \c false if the array is too large to be indexed
+         */
+    template <class T>
+    bool add(MemberArray array, const std::vector<T*>& members)
+    {
+        if (members.size() > MaximumArraySize) {
+            return false;
+        }
+        for (size_t i = 0; i < members.size(); i++) {
+            this->_entries.push_back({ hash(members[i]->jsName), (uint16_t)((array << 14) | i) });
+        }
+        return true;
+    }
+
+    size_t size() const
+    {
+        return this->_entries.size();
+    }
+
+    MetaFileOffset save(BinaryWriter& writer);
+
+private:
+    struct Entry {
+        unsigned int hash;
+        uint16_t member;
+    };
+
+    std::vector<Entry> _entries;
+};
+}
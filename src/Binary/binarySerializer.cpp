@@ -1,12 +1,9 @@
 #include "binarySerializer.h"
 #include "Meta/Utils.h"
+#include "binaryMembersIndex.h"
 #include "binarySerializerPrivate.h"
-#include <clang/Basic/FileManager.h>
-#include <llvm/Object/Binary.h>
-#include <llvm/Object/MachO.h>
-#include <llvm/Object/MachOUniversal.h>
-#include <llvm/Support/Path.h>
 #include <sstream>
+#include <unordered_set>
 
 uint8_t convertVersion(Meta::Version version)
 {
@@ -55,17 +52,7 @@ void binary::BinarySerializer::serializeBase(::Meta::Meta* meta, binary::Meta& b
         flags |= BinaryFlags::IsIosAppExtensionAvailable;
 
     // module
-    clang::Module* topLevelModule = meta->module->getTopLevelModule();
-    std::string topLevelModuleName = topLevelModule->getFullModuleName();
-    MetaFileOffset moduleOffset = this->file->getFromTopLevelModulesTable(topLevelModuleName);
-    if (moduleOffset != 0)
-        binaryMetaStruct._topLevelModule = moduleOffset;
-    else {
-        binary::ModuleMeta moduleMeta{};
-        serializeModule(topLevelModule, moduleMeta);
-        binaryMetaStruct._topLevelModule = moduleMeta.save(this->heapWriter);
-        this->file->registerInTopLevelModulesTable(topLevelModuleName, binaryMetaStruct._topLevelModule);
-    }
+    binaryMetaStruct._topLevelModule = this->serializeTopLevelModule(meta->module->getTopLevelModule());
 
     // introduced in
     binaryMetaStruct._introduced = convertVersion(meta->introducedIn);
@@ -77,29 +64,32 @@ void binary::BinarySerializer::serializeBaseClass(::Meta::BaseClassMeta* meta, b
 
     std::vector<MetaFileOffset> offsets;
 
+    // The members are sorted for the lookups of the runtime in copies of their arrays, so the other outputs keep their order
+    std::vector< ::Meta::MethodMeta*> instanceMethods = meta->instanceMethods;
+    std::vector< ::Meta::MethodMeta*> staticMethods = meta->staticMethods;
+    std::vector< ::Meta::PropertyMeta*> instanceProperties = meta->instanceProperties;
+    std::vector< ::Meta::PropertyMeta*> staticProperties = meta->staticProperties;
+    std::vector< ::Meta::ProtocolMeta*> protocols = meta->protocols;
+
     // instance methods
-    std::sort(meta->instanceMethods.begin(), meta->instanceMethods.end(), compareMetasByJsName< ::Meta::MethodMeta>);
-    for (::Meta::MethodMeta* methodMeta : meta->instanceMethods) {
-        binary::MethodMeta binaryMeta;
-        this->serializeMethod(methodMeta, binaryMeta);
-        offsets.push_back(binaryMeta.save(this->heapWriter));
+    ::Meta::Utils::sortMetasForLookup(instanceMethods);
+    for (::Meta::MethodMeta* methodMeta : instanceMethods) {
+        offsets.push_back(this->saveMethod(methodMeta));
     }
     binaryMetaStruct._instanceMethods = this->heapWriter.push_binaryArray(offsets);
     offsets.clear();
 
     // static methods
-    std::sort(meta->staticMethods.begin(), meta->staticMethods.end(), compareMetasByJsName< ::Meta::MethodMeta>);
-    for (::Meta::MethodMeta* methodMeta : meta->staticMethods) {
-        binary::MethodMeta binaryMeta;
-        this->serializeMethod(methodMeta, binaryMeta);
-        offsets.push_back(binaryMeta.save(this->heapWriter));
+    ::Meta::Utils::sortMetasForLookup(staticMethods);
+    for (::Meta::MethodMeta* methodMeta : staticMethods) {
+        offsets.push_back(this->saveMethod(methodMeta));
     }
     binaryMetaStruct._staticMethods = this->heapWriter.push_binaryArray(offsets);
     offsets.clear();
 
     // instance properties
-    std::sort(meta->instanceProperties.begin(), meta->instanceProperties.end(), compareMetasByJsName< ::Meta::PropertyMeta>);
-    for (::Meta::PropertyMeta* propertyMeta : meta->instanceProperties) {
+    ::Meta::Utils::sortMetasForLookup(instanceProperties);
+    for (::Meta::PropertyMeta* propertyMeta : instanceProperties) {
         binary::PropertyMeta binaryMeta;
         this->serializeProperty(propertyMeta, binaryMeta);
         offsets.push_back(binaryMeta.save(this->heapWriter));
@@ -108,8 +98,8 @@ void binary::BinarySerializer::serializeBaseClass(::Meta::BaseClassMeta* meta, b
     offsets.clear();
 
     // static properties
-    std::sort(meta->staticProperties.begin(), meta->staticProperties.end(), compareMetasByJsName< ::Meta::PropertyMeta>);
-    for (::Meta::PropertyMeta* propertyMeta : meta->staticProperties) {
+    ::Meta::Utils::sortMetasForLookup(staticProperties);
+    for (::Meta::PropertyMeta* propertyMeta : staticProperties) {
         binary::PropertyMeta binaryMeta;
         this->serializeProperty(propertyMeta, binaryMeta);
         offsets.push_back(binaryMeta.save(this->heapWriter));
@@ -118,8 +108,8 @@ void binary::BinarySerializer::serializeBaseClass(::Meta::BaseClassMeta* meta, b
     offsets.clear();
 
     // protocols
-    std::sort(meta->protocols.begin(), meta->protocols.end(), compareMetasByJsName< ::Meta::ProtocolMeta>);
-    for (::Meta::ProtocolMeta* protocol : meta->protocols) {
+    ::Meta::Utils::sortMetasForLookup(protocols);
+    for (::Meta::ProtocolMeta* protocol : protocols) {
         offsets.push_back(this->heapWriter.push_string(protocol->jsName));
     }
     binaryMetaStruct._protocols = this->heapWriter.push_binaryArray(offsets);
@@ -127,13 +117,35 @@ void binary::BinarySerializer::serializeBaseClass(::Meta::BaseClassMeta* meta, b
 
     // first initializer index
     int16_t firstInitializerIndex = -1;
-    for (std::vector< ::Meta::MethodMeta*>::iterator it = meta->instanceMethods.begin(); it != meta->instanceMethods.end(); ++it) {
+    for (std::vector< ::Meta::MethodMeta*>::iterator it = instanceMethods.begin(); it != instanceMethods.end(); ++it) {
         if ((*it)->getFlags(::Meta::MetaFlags::MethodIsInitializer)) {
-            firstInitializerIndex = (int16_t)std::distance(meta->instanceMethods.begin(), it);
+            firstInitializerIndex = (int16_t)std::distance(instanceMethods.begin(), it);
             break;
         }
     }
     binaryMetaStruct._initializersStartIndex = firstInitializerIndex;
+
+    if (this->file->version() >= BinaryFormatMembersIndex) {
+        binaryMetaStruct._membersIndex = this->serializeMembersIndex(instanceMethods, staticMethods, instanceProperties, staticProperties);
+        if (binaryMetaStruct._membersIndex != 0) {
+            binaryMetaStruct._flags |= BinaryFlags::BaseClassHasMembersIndex;
+        }
+    }
+}
+
+binary::MetaFileOffset binary::BinarySerializer::serializeMembersIndex(const std::vector< ::Meta::MethodMeta*>& instanceMethods, const std::vector< ::Meta::MethodMeta*>& staticMethods,
+    const std::vector< ::Meta::PropertyMeta*>& instanceProperties, const std::vector< ::Meta::PropertyMeta*>& staticProperties)
+{
+    // The entries reference the members by their indices in the sorted member arrays
+    BinaryMembersIndex index;
+    bool canIndex = index.add(BinaryMembersIndex::InstanceMethods, instanceMethods)
+        && index.add(BinaryMembersIndex::StaticMethods, staticMethods)
+        && index.add(BinaryMembersIndex::InstanceProperties, instanceProperties)
+        && index.add(BinaryMembersIndex::StaticProperties, staticProperties);
+    if (!canIndex || index.size() < BinaryMembersIndex::MinimumMembersCount) {
+        return 0;
+    }
+    return index.save(this->heapWriter);
 }
 
 void binary::BinarySerializer::serializeMember(::Meta::Meta* meta, binary::MemberMeta& binaryMetaStruct)
@@ -171,16 +183,32 @@ void binary::BinarySerializer::serializeProperty(::Meta::PropertyMeta* meta, bin
 
     if (meta->getter) {
         binaryMetaStruct._flags |= BinaryFlags::PropertyHasGetter;
-        binary::MethodMeta binaryMeta;
-        this->serializeMethod(meta->getter, binaryMeta);
-        binaryMetaStruct._getter = binaryMeta.save(this->heapWriter);
+        binaryMetaStruct._getter = this->saveMethod(meta->getter);
     }
     if (meta->setter) {
         binaryMetaStruct._flags |= BinaryFlags::PropertyHasSetter;
-        binary::MethodMeta binaryMeta;
-        this->serializeMethod(meta->setter, binaryMeta);
-        binaryMetaStruct._setter = binaryMeta.save(this->heapWriter);
+        binaryMetaStruct._setter = this->saveMethod(meta->setter);
+    }
+}
+
+binary::MetaFileOffset binary::BinarySerializer::saveMethod(::Meta::MethodMeta* meta)
+{
+    // Accessors are usually listed in the methods of the same class, which are serialized before its properties
+    bool shareMethods = this->file->version() >= BinaryFormatSharedMembers;
+    if (shareMethods) {
+        std::unordered_map< ::Meta::MethodMeta*, MetaFileOffset>::iterator it = this->methodOffsets.find(meta);
+        if (it != this->methodOffsets.end()) {
+            return it->second;
+        }
     }
+
+    binary::MethodMeta binaryMeta;
+    this->serializeMethod(meta, binaryMeta);
+    MetaFileOffset offset = binaryMeta.save(this->heapWriter);
+    if (shareMethods) {
+        this->methodOffsets.emplace(meta, offset);
+    }
+    return offset;
 }
 
 void binary::BinarySerializer::serializeRecord(::Meta::RecordMeta* meta, binary::RecordMeta& binaryMetaStruct)
@@ -199,102 +227,84 @@ void binary::BinarySerializer::serializeRecord(::Meta::RecordMeta* meta, binary:
     binaryMetaStruct._fieldsEncodings = this->typeEncodingSerializer.visit(typeEncodings);
 }
 
-void binary::BinarySerializer::serializeContainer(std::vector<std::pair<clang::Module*, std::vector< ::Meta::Meta*> > >& container)
+binary::MetaFileOffset binary::BinarySerializer::serializeTopLevelModule(clang::Module* topLevelModule)
 {
-    this->start(container);
-    for (std::pair<clang::Module*, std::vector< ::Meta::Meta*> >& module : container) {
-        for (::Meta::Meta* meta : module.second) {
-            meta->visit(this);
-        }
+    std::string topLevelModuleName = topLevelModule->getFullModuleName();
+    MetaFileOffset moduleOffset = this->file->getFromTopLevelModulesTable(topLevelModuleName);
+    if (moduleOffset == 0) {
+        binary::ModuleMeta moduleMeta{};
+        serializeModule(topLevelModule, moduleMeta);
+        moduleOffset = moduleMeta.save(this->heapWriter);
+        this->file->registerInTopLevelModulesTable(topLevelModuleName, moduleOffset);
     }
-    this->finish(container);
+    return moduleOffset;
 }
 
-static llvm::ErrorOr<llvm::SmallString<128>> getFrameworkLib(clang::Module* framework, const std::string& library) {
-    using namespace llvm;
-    using namespace llvm::sys;
-
-    SmallString<128> path;
-    if (!path::is_absolute(library)) {
-        path::append(path, framework->Directory->getName());
-    }
-    path::append(path, library);
-    
-    if (!fs::exists(path)) {
-        path.append(".tbd");
-        if (fs::exists(path)) {
-            // A TBD file is a text-based file used by Apple. It contains information about a .DYLIB library.
-            // TBD files were introduced in Xcode 7 in September 2015 in order to reduce the size of SDKs
-            // that come with Xcode by linking to DYLIB libraries instead of storing the actual, larger DYLIB libraries.
-            return path;
-        }
-        
-        return errc::no_such_file_or_directory;
-    }
-    
-    return path;
+void binary::BinarySerializer::startCluster()
+{
+    this->heapWriter.clearInternedStrings();
+    this->typeEncodingSerializer.clearSharedEncodings();
+    this->methodOffsets.clear();
 }
 
-static llvm::ErrorOr<bool> isStaticFramework(clang::Module* framework)
+void binary::BinarySerializer::serializeContainer(std::vector<std::pair<clang::Module*, std::vector< ::Meta::Meta*> > >& container)
 {
-    using namespace llvm;
-    using namespace llvm::object;
-    using namespace llvm::sys;
+    this->start(container);
 
-    llvm::ErrorOr<SmallString<128>> path = getFrameworkLib(framework, framework->Name);
-    
-    if(path.getError()) {
-        if (framework->LinkLibraries.size() == 0) {
-            return errc::no_such_file_or_directory;
+    std::vector< ::Meta::Meta*> orderedMetas;
+    std::unordered_set< ::Meta::Meta*> visitedMetas;
+    if (!this->orderedSymbols.empty() || this->reserveAllBuckets) {
+        // The sizes of all buckets are needed before the ones of the ordered symbols are reserved
+        std::unordered_map<std::string, ::Meta::Meta*> metasByJsName;
+        for (std::pair<clang::Module*, std::vector< ::Meta::Meta*> >& module : container) {
+            for (::Meta::Meta* meta : module.second) {
+                if (!meta->is(::Meta::MetaType::Category)) {
+                    this->file->expectInGlobalTables(*meta);
+                    metasByJsName.emplace(meta->jsName, meta);
+                }
+            }
+        }
+
+        for (const std::string& jsName : this->orderedSymbols) {
+            std::unordered_map<std::string, ::Meta::Meta*>::iterator it = metasByJsName.find(jsName);
+            if (it != metasByJsName.end() && visitedMetas.insert(it->second).second) {
+                orderedMetas.push_back(it->second);
+                this->file->reserveInGlobalTables(*it->second);
+            }
         }
-        
-        path = getFrameworkLib(framework, framework->LinkLibraries[0].Library);
     }
 
-    if (path.getError()) {
-        return path.getError();
-    } else if (path.get().endswith(".tbd")) {
-        return true;
+    for (::Meta::Meta* meta : orderedMetas) {
+        if (this->layout == BinaryLayout::Clustered) {
+            this->startCluster();
+        }
+        meta->visit(this);
     }
 
-    auto isDylib = [](MachOObjectFile* machObjectFile) -> bool {
-        uint32_t filetype = (machObjectFile->is64Bit() ? machObjectFile->getHeader64().filetype : machObjectFile->getHeader().filetype);
-        return (filetype == MachO::MH_DYLIB || filetype == MachO::MH_DYLIB_STUB || filetype == MachO::MH_DYLINKER);
-    };
-
-    auto isObjFile = [](MachOObjectFile* machObjectFile) -> bool {
-        uint32_t filetype = (machObjectFile->is64Bit() ? machObjectFile->getHeader64().filetype : machObjectFile->getHeader().filetype);
-        return (filetype == MachO::MH_OBJECT);
-    };
-
-    if (Expected<OwningBinary<Binary> > binaryOrErr = createBinary(path.get())) {
-        Binary& binary = *binaryOrErr.get().getBinary();
-
-        if (MachOUniversalBinary* machoBinary = dyn_cast<MachOUniversalBinary>(&binary)) {
-            for (const MachOUniversalBinary::ObjectForArch& object : machoBinary->objects()) {
-                if (Expected<std::unique_ptr<MachOObjectFile> > objectFile = object.getAsObjectFile()) {
-                    if (MachOObjectFile* machObjectFile = dyn_cast<MachOObjectFile>(objectFile.get().get())) {
-                        if (isDylib(machObjectFile)) {
-                            return false;
-                        } else if (isObjFile(machObjectFile)) {
-                            return true;
-                        }
-                    }
-                } else if (Expected<std::unique_ptr<Archive> > archive = object.getAsArchive()) {
-                    return true;
+    // The buckets of the ordered symbols are already next to their records
+    if (this->reserveAllBuckets) {
+        for (std::pair<clang::Module*, std::vector< ::Meta::Meta*> >& module : container) {
+            for (::Meta::Meta* meta : module.second) {
+                if (!meta->is(::Meta::MetaType::Category) && visitedMetas.count(meta) == 0) {
+                    this->file->reserveInGlobalTables(*meta);
                 }
             }
-            // fallthrough and return error (no static, or dynamic library is detected inside the universal binary)
-        } else if (MachOObjectFile* machObjectFile = dyn_cast<MachOObjectFile>(&binary)) {
-            if (isDylib(machObjectFile)) {
-                return false;
-            }
-        } else if (Archive* archive = dyn_cast<Archive>(&binary)) {
-            return true;
         }
     }
+    this->orderedSymbolsEnd = this->heapWriter.currentPosition();
 
-    return errc::invalid_argument;
+    for (std::pair<clang::Module*, std::vector< ::Meta::Meta*> >& module : container) {
+        for (::Meta::Meta* meta : module.second) {
+            if (visitedMetas.count(meta) != 0) {
+                continue;
+            }
+            if (this->layout == BinaryLayout::Clustered) {
+                this->startCluster();
+            }
+            meta->visit(this);
+        }
+    }
+    this->finish(container);
 }
 
 void binary::BinarySerializer::serializeModule(clang::Module* module, binary::ModuleMeta& binaryModule)
@@ -306,7 +316,7 @@ void binary::BinarySerializer::serializeModule(clang::Module* module, binary::Mo
         if (module->IsSystem) {
             flags |= 1;
         } else {
-            llvm::ErrorOr<bool> isStatic = isStaticFramework(module);
+            llvm::ErrorOr<bool> isStatic = this->frameworkLinkageDetector.isStaticFramework(module);
             assert(isStatic.getError().value() == 0);
 
             bool isDynamic = isStatic.getError().value() == 0 && !isStatic.get();
@@ -342,6 +352,22 @@ void binary::BinarySerializer::serializeLibrary(clang::Module::LinkLibrary* libr
 
 void binary::BinarySerializer::start(std::vector<std::pair<clang::Module*, std::vector< ::Meta::Meta*> > >& container)
 {
+    // Probe the binaries of all non-system frameworks upfront, so that serializeModule only hits the cache
+    std::vector<clang::Module*> frameworks;
+    for (std::pair<clang::Module*, std::vector< ::Meta::Meta*> >& module : container) {
+        clang::Module* topLevelModule = module.first->getTopLevelModule();
+        if (topLevelModule->isPartOfFramework() && !topLevelModule->IsSystem) {
+            frameworks.push_back(topLevelModule);
+        }
+    }
+    this->frameworkLinkageDetector.probe(frameworks);
+
+    if (this->layout == BinaryLayout::Clustered) {
+        // All module records are referenced while the runtime starts, so they are kept together at the beginning of the heap
+        for (std::pair<clang::Module*, std::vector< ::Meta::Meta*> >& module : container) {
+            this->serializeTopLevelModule(module.first->getTopLevelModule());
+        }
+    }
 }
 
 void binary::BinarySerializer::finish(std::vector<std::pair<clang::Module*, std::vector< ::Meta::Meta*> > >& container)
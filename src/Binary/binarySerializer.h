@@ -3,9 +3,23 @@
 #include "Meta/MetaEntities.h"
 #include "metaFile.h"
 #include "binaryTypeEncodingSerializer.h"
+#include "frameworkLinkageDetector.h"
 #include <map>
+#include <unordered_map>
 
 namespace binary {
+/*
+ * \brief The order in which the records are written in the heap.
+ */
+enum class BinaryLayout {
+    // Every record is written where it's first referenced and strings and encodings are shared by the whole file
+    Sequential,
+    // The module records are written first and each top level meta is followed by its members, encodings and
+    // strings, so the first lookup of a symbol touches as few pages as possible. Strings and encodings are shared
+    // only within the cluster of a meta, which makes the file larger.
+    Clustered
+};
+
 /*
      * \class BinarySerializer
      * \brief Applies the Visitor pattern for serializing \c Meta::Meta objects in binary format.
@@ -13,8 +27,18 @@ namespace binary {
 class BinarySerializer : public ::Meta::MetaVisitor {
 private:
     MetaFile* file;
+    BinaryLayout layout;
     BinaryWriter heapWriter;
     BinaryTypeEncodingSerializer typeEncodingSerializer;
+    FrameworkLinkageDetector frameworkLinkageDetector;
+    // The offsets of the already serialized method records, if they are shared by the properties
+    std::unordered_map< ::Meta::MethodMeta*, MetaFileOffset> methodOffsets;
+    // The JS names of the symbols which are written first, see setSymbolsOrder
+    std::vector<std::string> orderedSymbols;
+    // The heap size after the module records, the ordered symbols and the reserved buckets are written
+    MetaFileOffset orderedSymbolsEnd = 0;
+    // Whether the buckets of all global tables are written before the records of the symbols which aren't ordered
+    bool reserveAllBuckets = false;
 
     void serializeBase(::Meta::Meta* Meta, binary::Meta& binaryMetaStruct);
 
@@ -24,24 +48,74 @@ private:
 
     void serializeMethod(::Meta::MethodMeta* Meta, binary::MethodMeta& binaryMetaStruct);
 
+    /*
+     * \brief Writes the record of a method, or returns the offset of its existing record if the file shares members.
+     */
+    MetaFileOffset saveMethod(::Meta::MethodMeta* meta);
+
     void serializeProperty(::Meta::PropertyMeta* Meta, binary::PropertyMeta& binaryMetaStruct);
 
+    /*
+     * \brief Writes the hash index of the members of a class, if it is large enough to need one.
+     * The members are given in the order in which their arrays are written.
+     * \return The offset of the index or 0 if it isn't written
+     */
+    MetaFileOffset serializeMembersIndex(const std::vector< ::Meta::MethodMeta*>& instanceMethods, const std::vector< ::Meta::MethodMeta*>& staticMethods,
+        const std::vector< ::Meta::PropertyMeta*>& instanceProperties, const std::vector< ::Meta::PropertyMeta*>& staticProperties);
+
     void serializeRecord(::Meta::RecordMeta* Meta, binary::RecordMeta& binaryMetaStruct);
 
     void serializeModule(clang::Module* module, binary::ModuleMeta& binaryMetaStruct);
 
     void serializeLibrary(clang::Module::LinkLibrary* library, binary::LibraryMeta& binaryLib);
 
+    MetaFileOffset serializeTopLevelModule(clang::Module* module);
+
+    /*
+     * \brief Forgets the strings, encodings and methods written so far, so the next meta doesn't reference them.
+     */
+    void startCluster();
+
 public:
-    BinarySerializer(MetaFile* file)
-        : heapWriter(file->heap_writer())
-        , typeEncodingSerializer(heapWriter)
+    BinarySerializer(MetaFile* file, BinaryLayout layout = BinaryLayout::Sequential)
+        : layout(layout)
+        , heapWriter(file->heap_writer())
+        , typeEncodingSerializer(heapWriter, file->version() >= BinaryFormatSharedMembers)
     {
         this->file = file;
     }
 
     void serializeContainer(std::vector<std::pair<clang::Module*, std::vector< ::Meta::Meta*> > >& container);
 
+    /*
+     * \brief Sets the JS names of the symbols whose records are written at the beginning of the heap, in this order.
+     *
+     * The buckets of the global tables in which they are registered are written before them, so resolving the listed symbols
+     * touches the first pages of the heap only. Names of symbols which aren't in the container are ignored.
+     */
+    void setSymbolsOrder(const std::vector<std::string>& jsNames)
+    {
+        this->orderedSymbols = jsNames;
+    }
+
+    /*
+     * \brief Makes the buckets of all global tables precede the records of the symbols which aren't ordered, so that they are
+     * within \c getOrderedSymbolsEnd and looking up any symbol reads only the beginning of the heap.
+     */
+    void setReserveAllBuckets(bool reserve)
+    {
+        this->reserveAllBuckets = reserve;
+    }
+
+    /*
+     * \brief Returns the size of the beginning of the heap which holds the records needed at startup - the ordered symbols,
+     * the reserved buckets and, in the clustered layout, the modules.
+     */
+    MetaFileOffset getOrderedSymbolsEnd() const
+    {
+        return this->orderedSymbolsEnd;
+    }
+
     void start(std::vector<std::pair<clang::Module*, std::vector< ::Meta::Meta*> > >& container);
 
     void finish(std::vector<std::pair<clang::Module*, std::vector< ::Meta::Meta*> > >& container);
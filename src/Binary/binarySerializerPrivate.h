@@ -3,8 +3,3 @@
 #include "Meta/MetaEntities.h"
 
 uint8_t convertVersion(Meta::Version version);
-template <typename T>
-bool compareMetasByJsName(T* meta1, T* meta2)
-{
-    return meta1->jsName < meta2->jsName;
-}
\ No newline at end of file
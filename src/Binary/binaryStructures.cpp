@@ -71,10 +71,25 @@ binary::MetaFileOffset binary::BaseClassMeta::save(BinaryWriter& writer)
     return offset;
 }
 
+void binary::BaseClassMeta::saveMembersIndex(BinaryWriter& writer)
+{
+    if (this->_flags & BinaryFlags::BaseClassHasMembersIndex) {
+        writer.push_pointer(this->_membersIndex);
+    }
+}
+
+binary::MetaFileOffset binary::ProtocolMeta::save(BinaryWriter& writer)
+{
+    binary::MetaFileOffset offset = BaseClassMeta::save(writer);
+    this->saveMembersIndex(writer);
+    return offset;
+}
+
 binary::MetaFileOffset binary::InterfaceMeta::save(BinaryWriter& writer)
 {
     binary::MetaFileOffset offset = BaseClassMeta::save(writer);
     writer.push_pointer(this->_baseName);
+    this->saveMembersIndex(writer);
     return offset;
 }
 
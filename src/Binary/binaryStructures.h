@@ -60,6 +60,39 @@ enum BinaryMetaType : uint8_t {
     Protocol
 };
 
+// The version of the binary format is stored in the first byte of the heap. Heap offset 0 is
+// a null reference, so readers which don't know about versions aren't affected by it.
+enum BinaryFormatVersion : uint8_t {
+    // Every method and property has its own method records and type encodings
+    BinaryFormatLegacy = 0,
+    // Property accessors point to the records of the same methods and equal type encodings are stored once
+    BinaryFormatSharedMembers = 1,
+    // Large interfaces and protocols have a hash index of their members at the end of their records
+    BinaryFormatMembersIndex = 2,
+    BinaryFormatLatest = BinaryFormatMembersIndex
+};
+
+/*
+ * \brief The header of a metadata file whose heap is split in independently compressed blocks.
+ *
+ * The file starts with the magic number, which can't be the size of the first global table of an
+ * uncompressed file because it's negative. The header is followed by the index of the blocks - the
+ * file offset and the compressed size of each block - then the uncompressed global tables, the
+ * uncompressed beginning of the heap and the compressed blocks. All fields are 32 bit little-endian
+ * integers. Each block holds \c blockSize bytes of the heap, except the last one, and is compressed
+ * with zlib, unless its compressed size is equal to its size, in which case it's stored as is.
+ */
+struct CompressedMetaFileHeader {
+    static const uint32_t Magic = 0x5a444dff; // "\xffMDZ"
+
+    uint32_t globalTablesSize = 0;
+    uint32_t heapSize = 0;
+    // The number of bytes at the beginning of the heap which are stored uncompressed
+    uint32_t rawHeapSize = 0;
+    uint32_t blockSize = 0;
+    uint32_t blocksCount = 0;
+};
+
 enum BinaryFlags : uint16_t {
     // Common
     HasDemangledName = 1 << 8,
@@ -79,7 +112,9 @@ enum BinaryFlags : uint16_t {
     MethodHasErrorOutParameter = 1 << 5,
     // Property
     PropertyHasGetter = 1 << 2,
-    PropertyHasSetter = 1 << 3
+    PropertyHasSetter = 1 << 3,
+    // Interface and protocol
+    BaseClassHasMembersIndex = 1 << 3
 };
 
 #pragma pack(push, 1)
@@ -199,8 +234,13 @@ public:
     MetaFileOffset _staticProperties = 0;
     MetaFileOffset _protocols = 0;
     int16_t _initializersStartIndex = -1;
+    // Written after all other fields of the record, so readers which don't know about it aren't affected
+    MetaFileOffset _membersIndex = 0;
 
     virtual MetaFileOffset save(BinaryWriter& writer) override;
+
+protected:
+    void saveMembersIndex(BinaryWriter& writer);
 };
 
 struct ProtocolMeta : BaseClassMeta {
@@ -209,6 +249,8 @@ public:
         : BaseClassMeta(BinaryMetaType::Protocol)
     {
     }
+
+    virtual MetaFileOffset save(BinaryWriter& writer) override;
 };
 
 struct InterfaceMeta : BaseClassMeta {
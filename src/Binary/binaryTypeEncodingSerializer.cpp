@@ -1,5 +1,6 @@
 #include "binaryTypeEncodingSerializer.h"
 #include "../Meta/MetaEntities.h"
+#include "Utils/memoryStream.h"
 #include <llvm/ADT/STLExtras.h>
 
 binary::MetaFileOffset binary::BinaryTypeEncodingSerializer::visit(std::vector< ::Meta::Type*>& types)
@@ -10,10 +11,34 @@ binary::MetaFileOffset binary::BinaryTypeEncodingSerializer::visit(std::vector<
         binaryEncodings.push_back(std::move(binaryEncoding));
     }
 
-    binary::MetaFileOffset offset = this->_heapWriter.push_arrayCount(types.size());
+    if (!this->_shareEncodings) {
+        binary::MetaFileOffset offset = this->_heapWriter.push_arrayCount(types.size());
+        for (unique_ptr<binary::TypeEncoding>& binaryEncoding : binaryEncodings) {
+            binaryEncoding->save(this->_heapWriter);
+        }
+        return offset;
+    }
+
+    // Encodings contain only pointers to already written names and protocols, so they
+    // can be compared byte by byte before they are written in the heap
+    std::shared_ptr<utils::MemoryStream> encodingsStream(new utils::MemoryStream());
+    binary::BinaryWriter encodingsWriter(encodingsStream);
+    encodingsWriter.push_arrayCount(types.size());
     for (unique_ptr<binary::TypeEncoding>& binaryEncoding : binaryEncodings) {
-        binaryEncoding->save(this->_heapWriter);
+        binaryEncoding->save(encodingsWriter);
+    }
+
+    std::string bytes(encodingsStream->begin(), encodingsStream->end());
+    std::map<std::string, binary::MetaFileOffset>::iterator it = this->_sharedEncodings.find(bytes);
+    if (it != this->_sharedEncodings.end()) {
+        return it->second;
+    }
+
+    binary::MetaFileOffset offset = this->_heapWriter.currentPosition();
+    for (char byte : bytes) {
+        this->_heapWriter.push_byte((uint8_t)byte);
     }
+    this->_sharedEncodings.emplace(std::move(bytes), offset);
     return offset;
 }
 
@@ -3,6 +3,8 @@
 #include "Meta/TypeEntities.h"
 #include "binaryStructures.h"
 #include "binaryWriter.h"
+#include <map>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -15,17 +17,33 @@ namespace binary {
 class BinaryTypeEncodingSerializer : public ::Meta::TypeVisitor<unique_ptr<binary::TypeEncoding> > {
 private:
     BinaryWriter _heapWriter;
+    bool _shareEncodings;
+    // Serialized encoding arrays mapped to their offsets in the heap
+    std::map<std::string, MetaFileOffset> _sharedEncodings;
 
     unique_ptr<TypeEncoding> serializeRecordEncoding(const binary::BinaryTypeEncodingType encodingType, const std::vector< ::Meta::RecordField>& fields);
 
 public:
-    BinaryTypeEncodingSerializer(BinaryWriter& heapWriter)
+    /*
+     * \param shareEncodings Specifies whether an encoding array equal to a previously serialized one references it instead of being written again.
+     */
+    BinaryTypeEncodingSerializer(BinaryWriter& heapWriter, bool shareEncodings = false)
         : _heapWriter(heapWriter)
+        , _shareEncodings(shareEncodings)
     {
     }
 
     MetaFileOffset visit(std::vector< ::Meta::Type*>& types);
 
+    /*
+     * \brief Forgets the encoding arrays and strings written so far, so the next equal ones are written again.
+     */
+    void clearSharedEncodings()
+    {
+        this->_sharedEncodings.clear();
+        this->_heapWriter.clearInternedStrings();
+    }
+
     virtual unique_ptr<TypeEncoding> visitVoid() override;
 
     virtual unique_ptr<TypeEncoding> visitBool() override;
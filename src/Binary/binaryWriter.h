@@ -41,6 +41,14 @@ public:
          */
     MetaFileOffset push_string(const std::string& str, bool shouldIntern = true);
 
+    /*
+         * \brief Forgets the interned strings, so the next \c push_string of each of them writes it again.
+         */
+    void clearInternedStrings()
+    {
+        this->uniqueStrings.clear();
+    }
+
     /*
          * \brief Writes a pointer.
          * \param offset
@@ -0,0 +1,213 @@
+#include "frameworkLinkageDetector.h"
+#include <clang/Basic/FileManager.h>
+#include <cstring>
+#include <fstream>
+#include <llvm/BinaryFormat/MachO.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/Errc.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/ThreadPool.h>
+#include <set>
+
+namespace {
+enum class SliceKind {
+    Unknown,
+    Dylib,
+    Object,
+    Archive
+};
+
+const char ArchiveMagic[] = "!<arch>\n";
+const size_t ArchiveMagicSize = sizeof(ArchiveMagic) - 1;
+
+llvm::ErrorOr<llvm::SmallString<128> > getFrameworkLib(clang::Module* framework, const std::string& library)
+{
+    using namespace llvm;
+    using namespace llvm::sys;
+
+    SmallString<128> path;
+    if (!path::is_absolute(library)) {
+        // Modules loaded from a snapshot have no directory if it doesn't exist anymore
+        if (framework->Directory == nullptr) {
+            return errc::no_such_file_or_directory;
+        }
+        path::append(path, framework->Directory->getName());
+    }
+    path::append(path, library);
+
+    if (!fs::exists(path)) {
+        path.append(".tbd");
+        if (fs::exists(path)) {
+            // A TBD file is a text-based file used by Apple. It contains information about a .DYLIB library.
+            // TBD files were introduced in Xcode 7 in September 2015 in order to reduce the size of SDKs
+            // that come with Xcode by linking to DYLIB libraries instead of storing the actual, larger DYLIB libraries.
+            return path;
+        }
+
+        return errc::no_such_file_or_directory;
+    }
+
+    return path;
+}
+
+llvm::ErrorOr<std::string> getFrameworkBinary(clang::Module* framework)
+{
+    llvm::ErrorOr<llvm::SmallString<128> > path = getFrameworkLib(framework, framework->Name);
+
+    if (path.getError()) {
+        if (framework->LinkLibraries.size() == 0) {
+            return llvm::errc::no_such_file_or_directory;
+        }
+
+        path = getFrameworkLib(framework, framework->LinkLibraries[0].Library);
+    }
+
+    if (path.getError()) {
+        return path.getError();
+    }
+
+    return path.get().str().str();
+}
+
+size_t readAt(std::ifstream& file, uint64_t offset, char* buffer, size_t size)
+{
+    file.clear();
+    file.seekg(offset);
+    file.read(buffer, size);
+    return (size_t)file.gcount();
+}
+
+// Reads only the header of the Mach-O file or archive which starts at the given offset
+SliceKind classifySlice(std::ifstream& file, uint64_t offset)
+{
+    using namespace llvm;
+
+    char header[sizeof(MachO::mach_header)];
+    size_t headerSize = readAt(file, offset, header, sizeof(header));
+
+    if (headerSize >= ArchiveMagicSize && std::memcmp(header, ArchiveMagic, ArchiveMagicSize) == 0) {
+        return SliceKind::Archive;
+    }
+    if (headerSize < sizeof(MachO::mach_header)) {
+        return SliceKind::Unknown;
+    }
+
+    // mach_header is a prefix of mach_header_64, so filetype is at the same offset in both
+    MachO::mach_header machHeader;
+    std::memcpy(&machHeader, header, sizeof(machHeader));
+    if (machHeader.magic == MachO::MH_CIGAM || machHeader.magic == MachO::MH_CIGAM_64) {
+        MachO::swapStruct(machHeader);
+    } else if (machHeader.magic != MachO::MH_MAGIC && machHeader.magic != MachO::MH_MAGIC_64) {
+        return SliceKind::Unknown;
+    }
+
+    switch (machHeader.filetype) {
+    case MachO::MH_DYLIB:
+    case MachO::MH_DYLIB_STUB:
+    case MachO::MH_DYLINKER:
+        return SliceKind::Dylib;
+    case MachO::MH_OBJECT:
+        return SliceKind::Object;
+    default:
+        return SliceKind::Unknown;
+    }
+}
+
+llvm::ErrorOr<bool> classifyFile(const std::string& path)
+{
+    using namespace llvm;
+    using namespace llvm::support;
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        return errc::no_such_file_or_directory;
+    }
+
+    char fatHeader[sizeof(MachO::fat_header)];
+    if (readAt(file, 0, fatHeader, sizeof(fatHeader)) == sizeof(fatHeader)) {
+        // Fat headers and arch tables are always big endian
+        uint32_t magic = endian::read32be(fatHeader);
+        if (magic == MachO::FAT_MAGIC || magic == MachO::FAT_MAGIC_64) {
+            bool is64Bit = magic == MachO::FAT_MAGIC_64;
+            uint32_t archCount = endian::read32be(fatHeader + 4);
+            size_t archSize = is64Bit ? sizeof(MachO::fat_arch_64) : sizeof(MachO::fat_arch);
+
+            for (uint32_t i = 0; i < archCount; i++) {
+                char arch[sizeof(MachO::fat_arch_64)];
+                if (readAt(file, sizeof(MachO::fat_header) + i * archSize, arch, archSize) != archSize) {
+                    break;
+                }
+
+                // cputype, cpusubtype, offset (32 or 64 bit), size, align
+                uint64_t offset = is64Bit ? endian::read64be(arch + 8) : endian::read32be(arch + 8);
+                switch (classifySlice(file, offset)) {
+                case SliceKind::Dylib:
+                    return false;
+                case SliceKind::Object:
+                case SliceKind::Archive:
+                    return true;
+                case SliceKind::Unknown:
+                    break;
+                }
+            }
+            // fallthrough and return error (no static, or dynamic library is detected inside the universal binary)
+            return errc::invalid_argument;
+        }
+    }
+
+    switch (classifySlice(file, 0)) {
+    case SliceKind::Dylib:
+        return false;
+    case SliceKind::Archive:
+        return true;
+    default:
+        return errc::invalid_argument;
+    }
+}
+}
+
+llvm::ErrorOr<bool> binary::FrameworkLinkageDetector::isStaticFramework(clang::Module* framework)
+{
+    llvm::ErrorOr<std::string> path = getFrameworkBinary(framework);
+    if (path.getError()) {
+        return path.getError();
+    }
+
+    return this->isStaticBinary(path.get());
+}
+
+void binary::FrameworkLinkageDetector::probe(const std::vector<clang::Module*>& frameworks)
+{
+    std::set<std::string> paths;
+    for (clang::Module* framework : frameworks) {
+        llvm::ErrorOr<std::string> path = getFrameworkBinary(framework);
+        if (!path.getError()) {
+            paths.insert(path.get());
+        }
+    }
+
+    llvm::ThreadPool pool;
+    for (const std::string& path : paths) {
+        pool.async([this, path]() {
+            this->isStaticBinary(path);
+        });
+    }
+    pool.wait();
+}
+
+llvm::ErrorOr<bool> binary::FrameworkLinkageDetector::isStaticBinary(const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_cacheMutex);
+        std::unordered_map<std::string, llvm::ErrorOr<bool> >::iterator it = this->_cache.find(path);
+        if (it != this->_cache.end()) {
+            return it->second;
+        }
+    }
+
+    llvm::ErrorOr<bool> result = llvm::StringRef(path).endswith(".tbd") ? llvm::ErrorOr<bool>(true) : classifyFile(path);
+
+    std::lock_guard<std::mutex> lock(this->_cacheMutex);
+    return this->_cache.insert(std::make_pair(path, result)).first->second;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <clang/Basic/Module.h>
+#include <llvm/Support/ErrorOr.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace binary {
+/*
+     * \class FrameworkLinkageDetector
+     * \brief Detects whether the binary of a framework is a static or a dynamic library.
+     *
+     * Only the Mach-O header and the fat arch table of universal binaries are read from disk.
+     * Results are cached per binary path, so each framework binary is probed at most once.
+     */
+class FrameworkLinkageDetector {
+public:
+    /*
+         * \brief Returns whether the given framework module is linked statically.
+         * \param framework The framework module
+         */
+    llvm::ErrorOr<bool> isStaticFramework(clang::Module* framework);
+
+    /*
+         * \brief Probes the binaries of the given framework modules concurrently and caches the results.
+         * \param frameworks The framework modules which will be queried later
+         */
+    void probe(const std::vector<clang::Module*>& frameworks);
+
+private:
+    llvm::ErrorOr<bool> isStaticBinary(const std::string& path);
+
+    std::mutex _cacheMutex;
+    std::unordered_map<std::string, llvm::ErrorOr<bool> > _cache;
+};
+}
@@ -1,5 +1,8 @@
 #include "metaFile.h"
 #include "Utils/fileStream.h"
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Error.h>
 
 unsigned int binary::MetaFile::size()
 {
@@ -8,15 +11,24 @@ unsigned int binary::MetaFile::size()
 
 void binary::MetaFile::registerInGlobalTables(const ::Meta::Meta& meta, binary::MetaFileOffset offset)
 {
-    this->_globalTableSymbolsJs->add(meta.jsName, offset);
-    
-    auto& nativeTable = (meta.type == ::Meta::MetaType::Protocol) ? this->_globalTableSymbolsNativeProtocols : this->_globalTableSymbolsNativeInterfaces;
-    
-    nativeTable->add(meta.name, offset);
-    
-    if (!meta.demangledName.empty()) {
-        nativeTable->add(meta.demangledName, offset);
-    }
+    this->forEachGlobalTableKey(meta, [offset](BinaryHashtable& table, const std::string& key) {
+        table.add(key, offset);
+    });
+}
+
+void binary::MetaFile::expectInGlobalTables(const ::Meta::Meta& meta)
+{
+    this->forEachGlobalTableKey(meta, [](BinaryHashtable& table, const std::string& key) {
+        table.expect(key);
+    });
+}
+
+void binary::MetaFile::reserveInGlobalTables(const ::Meta::Meta& meta)
+{
+    BinaryWriter heapWriter = this->heap_writer();
+    this->forEachGlobalTableKey(meta, [&heapWriter](BinaryHashtable& table, const std::string& key) {
+        table.reserve(key, heapWriter);
+    });
 }
 
 binary::MetaFileOffset binary::MetaFile::getFromGlobalTable(const std::string& jsName)
@@ -52,27 +64,95 @@ void binary::MetaFile::save(string filename)
     fileStream->close();
 }
 
-void binary::MetaFile::save(std::shared_ptr<utils::Stream> stream)
+void binary::MetaFile::saveGlobalTables(BinaryWriter& globalTableStreamWriter)
 {
-    // dump global table
-    BinaryWriter globalTableStreamWriter = BinaryWriter(stream);
-    BinaryWriter heapWriter = this->heap_writer();							
-    std::vector<binary::MetaFileOffset> jsOffsets = this->_globalTableSymbolsJs->serialize(heapWriter);
+    std::vector<binary::MetaFileOffset> jsOffsets = this->_globalTableSymbolsJs->serialize(this->_heap);
     globalTableStreamWriter.push_binaryArray(jsOffsets);
 
-    std::vector<binary::MetaFileOffset> nativeProtocolOffsets = this->_globalTableSymbolsNativeProtocols->serialize(heapWriter);
+    std::vector<binary::MetaFileOffset> nativeProtocolOffsets = this->_globalTableSymbolsNativeProtocols->serialize(this->_heap);
     globalTableStreamWriter.push_binaryArray(nativeProtocolOffsets);
 
-    std::vector<binary::MetaFileOffset> nativeInterfaceOffsets = this->_globalTableSymbolsNativeInterfaces->serialize(heapWriter);
+    std::vector<binary::MetaFileOffset> nativeInterfaceOffsets = this->_globalTableSymbolsNativeInterfaces->serialize(this->_heap);
     globalTableStreamWriter.push_binaryArray(nativeInterfaceOffsets);
 
     std::vector<MetaFileOffset> modulesOffsets;
     for (std::pair<std::string, MetaFileOffset> pair : this->_topLevelModules)
         modulesOffsets.push_back(pair.second);
     globalTableStreamWriter.push_binaryArray(modulesOffsets);
+}
+
+void binary::MetaFile::save(std::shared_ptr<utils::Stream> stream)
+{
+    if (this->_compressionBlockSize != 0) {
+        this->saveCompressed(stream);
+        return;
+    }
+
+    // dump global table
+    BinaryWriter globalTableStreamWriter = BinaryWriter(stream);
+    this->saveGlobalTables(globalTableStreamWriter);
 
     // dump heap
     for (auto byteIter = this->_heap->begin(); byteIter != this->_heap->end(); ++byteIter) {
         stream->push_byte(*byteIter);
     }
 }
+
+void binary::MetaFile::saveCompressed(std::shared_ptr<utils::Stream> stream)
+{
+    if (!llvm::zlib::isAvailable()) {
+        throw std::runtime_error("The binary metadata can't be compressed, because LLVM is built without zlib.");
+    }
+
+    // The global tables add the buckets to the heap, so they are serialized before the heap is compressed
+    std::shared_ptr<utils::MemoryStream> globalTables(new utils::MemoryStream());
+    BinaryWriter globalTablesWriter(globalTables);
+    this->saveGlobalTables(globalTablesWriter);
+
+    std::string heap(this->_heap->begin(), this->_heap->end());
+    CompressedMetaFileHeader header;
+    header.globalTablesSize = (uint32_t)globalTables->size();
+    header.heapSize = (uint32_t)heap.size();
+    header.rawHeapSize = std::min(this->_rawHeapSize, header.heapSize);
+    header.blockSize = this->_compressionBlockSize;
+
+    std::vector<std::string> blocks;
+    for (size_t offset = header.rawHeapSize; offset < heap.size(); offset += header.blockSize) {
+        llvm::StringRef block(heap.data() + offset, std::min<size_t>(header.blockSize, heap.size() - offset));
+        llvm::SmallVector<char, 0> compressedBlock;
+        llvm::Error error = llvm::zlib::compress(block, compressedBlock);
+        if (error) {
+            throw std::runtime_error("Unable to compress the binary metadata: " + llvm::toString(std::move(error)));
+        }
+        // Blocks which don't get smaller are stored as is
+        blocks.push_back(compressedBlock.size() < block.size() ? std::string(compressedBlock.begin(), compressedBlock.end()) : block.str());
+    }
+    header.blocksCount = (uint32_t)blocks.size();
+
+    BinaryWriter writer(stream);
+    writer.push_int((int32_t)CompressedMetaFileHeader::Magic);
+    writer.push_int(header.globalTablesSize);
+    writer.push_int(header.heapSize);
+    writer.push_int(header.rawHeapSize);
+    writer.push_int(header.blockSize);
+    writer.push_int(header.blocksCount);
+
+    uint32_t blockOffset = 6 * sizeof(uint32_t) + header.blocksCount * 2 * sizeof(uint32_t) + header.globalTablesSize + header.rawHeapSize;
+    for (const std::string& block : blocks) {
+        writer.push_int(blockOffset);
+        writer.push_int((uint32_t)block.size());
+        blockOffset += block.size();
+    }
+
+    for (auto byteIter = globalTables->begin(); byteIter != globalTables->end(); ++byteIter) {
+        stream->push_byte(*byteIter);
+    }
+    for (size_t i = 0; i < header.rawHeapSize; i++) {
+        stream->push_byte((uint8_t)heap[i]);
+    }
+    for (const std::string& block : blocks) {
+        for (char c : block) {
+            stream->push_byte((uint8_t)c);
+        }
+    }
+}
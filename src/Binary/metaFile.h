@@ -30,20 +30,44 @@ private:
 
     std::map<std::string, MetaFileOffset> _topLevelModules;
     std::shared_ptr<utils::MemoryStream> _heap;
+    BinaryFormatVersion _version;
+    uint32_t _compressionBlockSize = 0;
+    uint32_t _rawHeapSize = 0;
+
+    void saveGlobalTables(BinaryWriter& writer);
+
+    void saveCompressed(std::shared_ptr<utils::Stream> stream);
+
+    /*
+         * \brief Calls the function with each global table in which the meta is registered and its key in that table.
+         */
+    template <class Function>
+    void forEachGlobalTableKey(const ::Meta::Meta& meta, Function function)
+    {
+        function(*this->_globalTableSymbolsJs, meta.jsName);
+
+        BinaryHashtable& nativeTable = (meta.type == ::Meta::MetaType::Protocol) ? *this->_globalTableSymbolsNativeProtocols : *this->_globalTableSymbolsNativeInterfaces;
+        function(nativeTable, meta.name);
+        if (!meta.demangledName.empty()) {
+            function(nativeTable, meta.demangledName);
+        }
+    }
 
 public:
     /*
          * \brief Constructs a \c MetaFile with the given size
          * \param size The number of meta objects this file will contain
+         * \param version The version of the binary format in which the meta objects are serialized
          */
-    MetaFile(int size)
+    MetaFile(int size, BinaryFormatVersion version = BinaryFormatLatest)
+        : _version(version)
     {
         size = std::max(size, 100);
         this->_globalTableSymbolsJs = std::unique_ptr<BinaryHashtable>(new BinaryHashtable(size));
         this->_globalTableSymbolsNativeProtocols = std::unique_ptr<BinaryHashtable>(new BinaryHashtable(size/10));
         this->_globalTableSymbolsNativeInterfaces = std::unique_ptr<BinaryHashtable>(new BinaryHashtable(size/10));
         this->_heap = std::shared_ptr<utils::MemoryStream>(new utils::MemoryStream());
-        this->_heap->push_byte(0); // mark heap
+        this->_heap->push_byte(version); // mark heap
     }
     MetaFile()
         : MetaFile(10)
@@ -55,6 +79,11 @@ public:
          */
     unsigned int size();
 
+    BinaryFormatVersion version() const
+    {
+        return this->_version;
+    }
+
     /// global table
     /*
          * \brief Adds an entry to the global table
@@ -63,6 +92,20 @@ public:
          */
     void registerInGlobalTables(const ::Meta::Meta& meta, MetaFileOffset offset);
 
+    /*
+         * \brief Counts the entries which \c registerInGlobalTables will add for the meta.
+         *
+         * All metas have to be counted before any bucket is reserved, so that the reserved buckets fit all of their entries.
+         */
+    void expectInGlobalTables(const ::Meta::Meta& meta);
+
+    /*
+         * \brief Writes placeholders at the current end of the heap for the buckets of the global tables in which the meta will be registered.
+         *
+         * The buckets are written in their placeholders when the file is saved, so they are next to each other and to the records written after them.
+         */
+    void reserveInGlobalTables(const ::Meta::Meta& meta);
+
     /*
          * \brief Returns the offset to which the specified jsName is mapped in the global table.
          * \param jsName The jsName of the element
@@ -95,6 +138,17 @@ public:
          */
     BinaryReader heap_reader();
 
+    /*
+         * \brief Makes \c save split the heap in independently compressed blocks, see \c CompressedMetaFileHeader.
+         * \param blockSize The number of heap bytes in each block, 0 writes the file uncompressed
+         * \param rawHeapSize The number of bytes at the beginning of the heap which are written uncompressed, e.g. the records of the hot symbols
+         */
+    void setCompression(uint32_t blockSize, uint32_t rawHeapSize)
+    {
+        this->_compressionBlockSize = blockSize;
+        this->_rawHeapSize = rawHeapSize;
+    }
+
     /// I/O
     /*
          * \brief Writes this file to the filesystem with the specified name.
@@ -0,0 +1,568 @@
+#include "metaFileReader.h"
+#include "binaryMembersIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Error.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+const char* getEncodingName(uint8_t type)
+{
+    static const char* names[] = {
+        "void", "bool", "short", "ushort", "int", "uint", "long", "ulong", "longlong", "ulonglong",
+        "char", "uchar", "unichar", "chars", "cstring", "float", "double", nullptr, nullptr, nullptr,
+        nullptr, "va_list", "SEL", "Class", "Protocol", "instancetype"
+    };
+    return type < sizeof(names) / sizeof(*names) ? names[type] : nullptr;
+}
+
+std::string formatHex(uint32_t value)
+{
+    std::ostringstream stream;
+    stream << "0x" << std::hex << value;
+    return stream.str();
+}
+
+std::string formatVersion(uint8_t version)
+{
+    if (version == 0) {
+        return "";
+    }
+    return std::to_string(version >> 3) + "." + std::to_string(version & 0x7);
+}
+
+std::string join(const std::vector<std::string>& values, const char* separator)
+{
+    std::string result;
+    for (size_t i = 0; i < values.size(); i++) {
+        result += (i == 0 ? "" : separator) + values[i];
+    }
+    return result;
+}
+
+uint32_t readUInt32(const uint8_t* position)
+{
+    return position[0] | (position[1] << 8) | (position[2] << 16) | ((uint32_t)position[3] << 24);
+}
+
+// Reads one of the binary arrays which precede the heap in the file
+std::vector<binary::MetaFileOffset> readGlobalTable(const uint8_t*& position, const uint8_t* end)
+{
+    auto readInt = [&]() {
+        if (end - position < 4) {
+            throw std::runtime_error("Unexpected end of the global tables");
+        }
+        uint32_t n = readUInt32(position);
+        position += 4;
+        return (int32_t)n;
+    };
+
+    int32_t count = readInt();
+    if (count < 0 || (end - position) / 4 < count) {
+        throw std::runtime_error("Invalid global table size " + std::to_string(count));
+    }
+    std::vector<binary::MetaFileOffset> offsets;
+    offsets.reserve(count);
+    for (int32_t i = 0; i < count; i++) {
+        offsets.push_back(readInt());
+    }
+    return offsets;
+}
+}
+
+llvm::ErrorOr<std::unique_ptr<binary::MetaFileReader> > binary::MetaFileReader::open(const std::string& filename)
+{
+    // Large files are memory mapped instead of being read, no null terminator is needed
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > buffer = llvm::MemoryBuffer::getFile(filename, -1, false);
+    if (!buffer) {
+        return buffer.getError();
+    }
+    return std::unique_ptr<MetaFileReader>(new MetaFileReader(std::move(buffer.get())));
+}
+
+binary::MetaFileReader::MetaFileReader(std::unique_ptr<llvm::MemoryBuffer> buffer)
+    : _buffer(std::move(buffer))
+{
+    const uint8_t* position = reinterpret_cast<const uint8_t*>(_buffer->getBufferStart());
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(_buffer->getBufferEnd());
+    bool isCompressed = end - position >= 4 && readUInt32(position) == CompressedMetaFileHeader::Magic;
+    if (isCompressed) {
+        position = this->decompress(position, end);
+    }
+
+    _jsSymbolsBuckets = readGlobalTable(position, end);
+    _nativeProtocolsBuckets = readGlobalTable(position, end);
+    _nativeInterfacesBuckets = readGlobalTable(position, end);
+    _modules = readGlobalTable(position, end);
+
+    if (isCompressed) {
+        _heap = _decompressedHeap.data();
+        _heapSize = _decompressedHeap.size();
+    } else {
+        _heap = position;
+        _heapSize = end - position;
+        _rawHeapSize = _heapSize;
+    }
+}
+
+const uint8_t* binary::MetaFileReader::decompress(const uint8_t* start, const uint8_t* end)
+{
+    if (!llvm::zlib::isAvailable()) {
+        throw std::runtime_error("The file is compressed, but LLVM is built without zlib");
+    }
+
+    size_t fileSize = end - start;
+    const size_t headerSize = 6 * sizeof(uint32_t);
+    if (fileSize < headerSize) {
+        throw std::runtime_error("Unexpected end of the compressed file header");
+    }
+    CompressedMetaFileHeader header;
+    header.globalTablesSize = readUInt32(start + 4);
+    header.heapSize = readUInt32(start + 8);
+    header.rawHeapSize = readUInt32(start + 12);
+    header.blockSize = readUInt32(start + 16);
+    header.blocksCount = readUInt32(start + 20);
+
+    size_t globalTablesOffset = headerSize + (size_t)header.blocksCount * 2 * sizeof(uint32_t);
+    if (header.rawHeapSize > header.heapSize || globalTablesOffset > fileSize || fileSize - globalTablesOffset < (size_t)header.globalTablesSize + header.rawHeapSize) {
+        throw std::runtime_error("Invalid compressed file header");
+    }
+    if (header.rawHeapSize < header.heapSize && (header.blockSize == 0 || header.blocksCount != (header.heapSize - header.rawHeapSize + header.blockSize - 1) / header.blockSize)) {
+        throw std::runtime_error("The compressed blocks don't cover the heap");
+    }
+
+    const uint8_t* globalTables = start + globalTablesOffset;
+    const uint8_t* rawHeap = globalTables + header.globalTablesSize;
+    _decompressedHeap.assign(rawHeap, rawHeap + header.rawHeapSize);
+    _decompressedHeap.resize(header.heapSize);
+
+    for (uint32_t i = 0; i < header.blocksCount; i++) {
+        uint32_t blockOffset = readUInt32(start + headerSize + i * 2 * sizeof(uint32_t));
+        uint32_t compressedSize = readUInt32(start + headerSize + i * 2 * sizeof(uint32_t) + sizeof(uint32_t));
+        if (blockOffset > fileSize || fileSize - blockOffset < compressedSize) {
+            throw std::runtime_error("Compressed block " + std::to_string(i) + " is out of bounds");
+        }
+
+        size_t heapOffset = header.rawHeapSize + (size_t)i * header.blockSize;
+        size_t size = std::min<size_t>(header.blockSize, header.heapSize - heapOffset);
+        char* destination = reinterpret_cast<char*>(_decompressedHeap.data() + heapOffset);
+        if (compressedSize == size) {
+            // Blocks which don't get smaller when compressed are stored as is
+            std::memcpy(destination, start + blockOffset, size);
+            continue;
+        }
+
+        size_t decompressedSize = size;
+        llvm::Error error = llvm::zlib::uncompress(llvm::StringRef(reinterpret_cast<const char*>(start + blockOffset), compressedSize), destination, decompressedSize);
+        if (error) {
+            throw std::runtime_error("Compressed block " + std::to_string(i) + " is corrupted: " + llvm::toString(std::move(error)));
+        }
+        if (decompressedSize != size) {
+            throw std::runtime_error("Compressed block " + std::to_string(i) + " has " + std::to_string(decompressedSize) + " bytes instead of " + std::to_string(size));
+        }
+    }
+
+    _compressedBlocksCount = header.blocksCount;
+    _rawHeapSize = header.rawHeapSize;
+    return globalTables;
+}
+
+const uint8_t* binary::MetaFileReader::bytes(MetaFileOffset offset, size_t count) const
+{
+    if (offset < 0 || (size_t)offset > _heapSize || _heapSize - offset < count) {
+        throw std::runtime_error("Heap offset " + std::to_string(offset) + " is out of bounds");
+    }
+    return _heap + offset;
+}
+
+std::string binary::MetaFileReader::readString(MetaFileOffset offset, size_t& size) const
+{
+    const uint8_t* start = this->bytes(offset, 1);
+    const void* terminator = std::memchr(start, '\0', _heapSize - offset);
+    if (terminator == nullptr) {
+        throw std::runtime_error("Unterminated string at heap offset " + std::to_string(offset));
+    }
+    size_t length = static_cast<const uint8_t*>(terminator) - start;
+    size += length + 1;
+    return std::string(reinterpret_cast<const char*>(start), length);
+}
+
+std::vector<binary::MetaFileOffset> binary::MetaFileReader::readArray(MetaFileOffset offset, size_t& size) const
+{
+    MetaArrayCount count = this->readNumber<MetaArrayCount>(offset, size);
+    if (count < 0) {
+        throw std::runtime_error("Invalid array size at heap offset " + std::to_string(offset - sizeof(MetaArrayCount)));
+    }
+    this->bytes(offset, (size_t)count * sizeof(MetaFileOffset));
+
+    std::vector<MetaFileOffset> elements;
+    elements.reserve(count);
+    for (MetaArrayCount i = 0; i < count; i++) {
+        elements.push_back(this->readPointer(offset, size));
+    }
+    return elements;
+}
+
+std::string binary::MetaFileReader::readStringArray(MetaFileOffset offset, size_t& size) const
+{
+    std::vector<std::string> values;
+    for (MetaFileOffset element : this->readArray(offset, size)) {
+        values.push_back(this->readString(element, size));
+    }
+    return join(values, ", ");
+}
+
+std::string binary::MetaFileReader::readEncoding(MetaFileOffset& offset, size_t& size) const
+{
+    uint8_t type = this->readNumber<uint8_t>(offset, size);
+    switch (type) {
+    case BinaryTypeEncodingType::Id: {
+        std::string protocols = this->readStringArray(this->readPointer(offset, size), size);
+        return protocols.empty() ? "id" : "id<" + protocols + ">";
+    }
+    case BinaryTypeEncodingType::InterfaceDeclarationReference: {
+        std::string name = this->readString(this->readPointer(offset, size), size);
+        std::string protocols = this->readStringArray(this->readPointer(offset, size), size);
+        return protocols.empty() ? name : name + "<" + protocols + ">";
+    }
+    case BinaryTypeEncodingType::StructDeclarationReference:
+        return "struct " + this->readString(this->readPointer(offset, size), size);
+    case BinaryTypeEncodingType::UnionDeclarationReference:
+        return "union " + this->readString(this->readPointer(offset, size), size);
+    case BinaryTypeEncodingType::Pointer:
+        return this->readEncoding(offset, size) + "*";
+    case BinaryTypeEncodingType::IncompleteArray:
+        return this->readEncoding(offset, size) + "[]";
+    case BinaryTypeEncodingType::ConstantArray: {
+        int32_t arraySize = this->readNumber<int32_t>(offset, size);
+        return this->readEncoding(offset, size) + "[" + std::to_string(arraySize) + "]";
+    }
+    case BinaryTypeEncodingType::Vector: {
+        int32_t vectorSize = this->readNumber<int32_t>(offset, size);
+        return "vector<" + this->readEncoding(offset, size) + ", " + std::to_string(vectorSize) + ">";
+    }
+    case BinaryTypeEncodingType::Block:
+    case BinaryTypeEncodingType::FunctionPointer: {
+        uint8_t count = this->readNumber<uint8_t>(offset, size);
+        std::string signature = this->readEncodings(offset, count, size);
+        return (type == BinaryTypeEncodingType::Block ? "block(" : "function(") + signature + ")";
+    }
+    case BinaryTypeEncodingType::AnonymousStruct:
+    case BinaryTypeEncodingType::AnonymousUnion: {
+        uint8_t count = this->readNumber<uint8_t>(offset, size);
+        std::vector<std::string> fields;
+        for (uint8_t i = 0; i < count; i++) {
+            fields.push_back(this->readString(this->readPointer(offset, size), size));
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            fields[i] += ": " + this->readEncoding(offset, size);
+        }
+        return (type == BinaryTypeEncodingType::AnonymousStruct ? "struct { " : "union { ") + join(fields, "; ") + " }";
+    }
+    default:
+        if (const char* name = getEncodingName(type)) {
+            return name;
+        }
+        throw std::runtime_error("Unknown type encoding " + std::to_string(type) + " at heap offset " + std::to_string(offset - 1));
+    }
+}
+
+std::string binary::MetaFileReader::readEncodings(MetaFileOffset& offset, size_t count, size_t& size) const
+{
+    std::vector<std::string> encodings;
+    for (size_t i = 0; i < count; i++) {
+        encodings.push_back(this->readEncoding(offset, size));
+    }
+    return join(encodings, ", ");
+}
+
+void binary::MetaFileReader::readNames(MetaFileOffset names, uint16_t flags, SymbolDescription& symbol, size_t& size) const
+{
+    // see BinarySerializer::serializeBase
+    if (!(flags & (BinaryFlags::HasName | BinaryFlags::HasDemangledName))) {
+        symbol.jsName = symbol.name = this->readString(names, size);
+        return;
+    }
+
+    if (flags & BinaryFlags::HasName) {
+        symbol.jsName = this->readString(this->readPointer(names, size), size);
+    }
+    symbol.name = this->readString(this->readPointer(names, size), size);
+    if (!(flags & BinaryFlags::HasName)) {
+        symbol.jsName = symbol.name;
+    }
+    if (flags & BinaryFlags::HasDemangledName) {
+        symbol.demangledName = this->readString(this->readPointer(names, size), size);
+    }
+}
+
+const std::string& binary::MetaFileReader::readModuleName(MetaFileOffset offset)
+{
+    auto it = _moduleNames.find(offset);
+    if (it == _moduleNames.end()) {
+        // The module is shared by many metas, so its size is not attributed to them
+        size_t size = 0;
+        MetaFileOffset nameOffset = offset + 1;
+        it = _moduleNames.emplace(offset, this->readString(this->readPointer(nameOffset, size), size)).first;
+    }
+    return it->second;
+}
+
+void binary::MetaFileReader::readModules(std::map<std::string, ModuleDescription>& modules)
+{
+    for (MetaFileOffset offset : _modules) {
+        ModuleDescription module;
+        MetaFileOffset cursor = offset;
+        module.flags = this->readNumber<uint8_t>(cursor, module.size);
+        std::string name = this->readString(this->readPointer(cursor, module.size), module.size);
+
+        for (MetaFileOffset library : this->readArray(this->readPointer(cursor, module.size), module.size)) {
+            uint8_t libraryFlags = this->readNumber<uint8_t>(library, module.size);
+            std::string libraryName = this->readString(this->readPointer(library, module.size), module.size);
+            module.libraries.push_back((libraryFlags & 1) ? libraryName + " (framework)" : libraryName);
+        }
+        modules[name] = std::move(module);
+    }
+}
+
+void binary::MetaFileReader::readSymbols(std::map<std::string, SymbolDescription>& symbols)
+{
+    for (MetaFileOffset bucket : _jsSymbolsBuckets) {
+        if (bucket == 0) {
+            continue;
+        }
+        size_t tableSize = 0;
+        for (MetaFileOffset offset : this->readArray(bucket, tableSize)) {
+            SymbolDescription symbol;
+            this->readSymbol(offset, symbol);
+            std::string key = symbol.jsName;
+            symbols.emplace(std::move(key), std::move(symbol));
+        }
+    }
+}
+
+size_t binary::MetaFileReader::countCompressedBuckets() const
+{
+    size_t count = 0;
+    for (const std::vector<MetaFileOffset>* buckets : { &_jsSymbolsBuckets, &_nativeProtocolsBuckets, &_nativeInterfacesBuckets }) {
+        for (MetaFileOffset bucket : *buckets) {
+            if (bucket == 0) {
+                continue;
+            }
+            size_t size = 0;
+            this->readArray(bucket, size);
+            if ((size_t)bucket + size > _rawHeapSize) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void binary::MetaFileReader::readNativeNames(std::set<std::string>& protocols, std::set<std::string>& interfaces)
+{
+    auto readTable = [this](const std::vector<MetaFileOffset>& buckets, std::set<std::string>& names) {
+        size_t size = 0;
+        for (MetaFileOffset bucket : buckets) {
+            if (bucket == 0) {
+                continue;
+            }
+            for (MetaFileOffset offset : this->readArray(bucket, size)) {
+                // see MetaFile::registerInGlobalTables
+                SymbolDescription symbol;
+                MetaFileOffset namesOffset = this->readPointer(offset, size);
+                offset += sizeof(MetaFileOffset);
+                uint16_t flags = this->readNumber<uint16_t>(offset, size);
+                this->readNames(namesOffset, flags, symbol, size);
+                names.insert(symbol.name);
+                if (!symbol.demangledName.empty()) {
+                    names.insert(symbol.demangledName);
+                }
+            }
+        }
+    };
+
+    readTable(_nativeProtocolsBuckets, protocols);
+    readTable(_nativeInterfacesBuckets, interfaces);
+}
+
+void binary::MetaFileReader::readSymbol(MetaFileOffset offset, SymbolDescription& symbol)
+{
+    size_t& size = symbol.size;
+    MetaFileOffset names = this->readPointer(offset, size);
+    MetaFileOffset module = this->readPointer(offset, size);
+    uint16_t flags = this->readNumber<uint16_t>(offset, size);
+    uint8_t introduced = this->readNumber<uint8_t>(offset, size);
+
+    this->readNames(names, flags, symbol, size);
+    symbol.module = module == 0 ? "" : this->readModuleName(module);
+    symbol.type = (BinaryMetaType)(flags & 0x7);
+    uint16_t ignoredFlags = BinaryFlags::HasName | BinaryFlags::HasDemangledName | 0x7;
+    if (symbol.type == BinaryMetaType::Interface || symbol.type == BinaryMetaType::Protocol) {
+        // The members index is verified, but it doesn't change the decoded members
+        ignoredFlags |= BinaryFlags::BaseClassHasMembersIndex;
+    }
+    symbol.attributes["flags"] = formatHex(flags & ~ignoredFlags);
+    symbol.attributes["introduced"] = formatVersion(introduced);
+    if (!symbol.demangledName.empty()) {
+        symbol.attributes["demangledName"] = symbol.demangledName;
+    }
+
+    switch (symbol.type) {
+    case BinaryMetaType::Struct:
+    case BinaryMetaType::Union: {
+        std::vector<std::string> fields;
+        for (MetaFileOffset field : this->readArray(this->readPointer(offset, size), size)) {
+            fields.push_back(this->readString(field, size));
+        }
+        MetaFileOffset encodings = this->readPointer(offset, size);
+        MetaArrayCount count = this->readNumber<MetaArrayCount>(encodings, size);
+        if (count < 0 || (size_t)count != fields.size()) {
+            throw std::runtime_error("Mismatched fields of record " + symbol.jsName);
+        }
+        for (std::string& field : fields) {
+            field += ": " + this->readEncoding(encodings, size);
+        }
+        symbol.attributes["fields"] = join(fields, "; ");
+        break;
+    }
+    case BinaryMetaType::Function: {
+        MetaFileOffset encodings = this->readPointer(offset, size);
+        MetaArrayCount count = this->readNumber<MetaArrayCount>(encodings, size);
+        symbol.attributes["signature"] = this->readEncodings(encodings, count, size);
+        break;
+    }
+    case BinaryMetaType::JsCode:
+        symbol.attributes["jsCode"] = this->readString(this->readPointer(offset, size), size);
+        break;
+    case BinaryMetaType::Var: {
+        MetaFileOffset encoding = this->readPointer(offset, size);
+        symbol.attributes["type"] = this->readEncoding(encoding, size);
+        break;
+    }
+    case BinaryMetaType::Interface:
+    case BinaryMetaType::Protocol: {
+        std::vector<std::string> memberNames[4];
+        this->readMembers(this->readPointer(offset, size), "instance method ", symbol, memberNames[BinaryMembersIndex::InstanceMethods]);
+        this->readMembers(this->readPointer(offset, size), "static method ", symbol, memberNames[BinaryMembersIndex::StaticMethods]);
+        this->readMembers(this->readPointer(offset, size), "instance property ", symbol, memberNames[BinaryMembersIndex::InstanceProperties]);
+        this->readMembers(this->readPointer(offset, size), "static property ", symbol, memberNames[BinaryMembersIndex::StaticProperties]);
+        symbol.attributes["protocols"] = this->readStringArray(this->readPointer(offset, size), size);
+        symbol.attributes["initializersStartIndex"] = std::to_string(this->readNumber<int16_t>(offset, size));
+        if (symbol.type == BinaryMetaType::Interface) {
+            MetaFileOffset baseName = this->readPointer(offset, size);
+            symbol.attributes["base"] = baseName == 0 ? "" : this->readString(baseName, size);
+        }
+        if (flags & BinaryFlags::BaseClassHasMembersIndex) {
+            this->verifyMembersIndex(this->readPointer(offset, size), memberNames, symbol);
+        }
+        break;
+    }
+    default:
+        throw std::runtime_error("Unknown meta type " + std::to_string((int)symbol.type) + " of " + symbol.jsName);
+    }
+}
+
+void binary::MetaFileReader::verifyMembersIndex(MetaFileOffset offset, const std::vector<std::string> (&memberNames)[4], SymbolDescription& symbol)
+{
+    size_t membersCount = 0;
+    for (const std::vector<std::string>& names : memberNames) {
+        membersCount += names.size();
+    }
+
+    uint16_t bucketsCount = this->readNumber<uint16_t>(offset, symbol.size);
+    if (bucketsCount != BinaryMembersIndex::getBucketsCount(membersCount)) {
+        throw std::runtime_error("Invalid members index size of " + symbol.jsName);
+    }
+    std::vector<uint16_t> bucketEnds;
+    for (uint16_t bucket = 0; bucket < bucketsCount; bucket++) {
+        bucketEnds.push_back(this->readNumber<uint16_t>(offset, symbol.size));
+    }
+    if (bucketEnds.back() != membersCount) {
+        throw std::runtime_error("Invalid members index size of " + symbol.jsName);
+    }
+
+    // Every member must be in the bucket of its jsName exactly once
+    std::set<uint16_t> indexedMembers;
+    uint16_t start = 0;
+    for (uint16_t bucket = 0; bucket < bucketsCount; start = bucketEnds[bucket], bucket++) {
+        if (bucketEnds[bucket] < start) {
+            throw std::runtime_error("Invalid members index buckets of " + symbol.jsName);
+        }
+        for (uint16_t i = start; i < bucketEnds[bucket]; i++) {
+            uint16_t member = this->readNumber<uint16_t>(offset, symbol.size);
+            const std::vector<std::string>& names = memberNames[member >> 14];
+            size_t index = member & (BinaryMembersIndex::MaximumArraySize);
+            if (index >= names.size() || (BinaryMembersIndex::hash(names[index]) & (bucketsCount - 1)) != bucket || !indexedMembers.insert(member).second) {
+                throw std::runtime_error("Invalid members index entry of " + symbol.jsName);
+            }
+        }
+    }
+}
+
+void binary::MetaFileReader::readMembers(MetaFileOffset array, const char* kind, SymbolDescription& symbol, std::vector<std::string>& memberNames)
+{
+    bool isProperty = std::strstr(kind, "property") != nullptr;
+    for (MetaFileOffset offset : this->readArray(array, symbol.size)) {
+        SymbolDescription member;
+        std::string description = isProperty ? this->readProperty(offset, member, symbol.size) : this->readMethod(offset, member, symbol.size);
+        memberNames.push_back(member.jsName);
+
+        // Members with the same jsName are kept apart by their position
+        std::string key = kind + member.jsName;
+        for (int i = 2; symbol.members.count(key); i++) {
+            key = kind + member.jsName + " #" + std::to_string(i);
+        }
+        symbol.members.emplace(std::move(key), std::move(description));
+    }
+}
+
+std::string binary::MetaFileReader::readMethod(MetaFileOffset offset, SymbolDescription& member, size_t& size) const
+{
+    MetaFileOffset names = this->readPointer(offset, size);
+    offset += sizeof(MetaFileOffset); // the top level module of members is not used
+    size += sizeof(MetaFileOffset);
+    uint16_t flags = this->readNumber<uint16_t>(offset, size);
+    uint8_t introduced = this->readNumber<uint8_t>(offset, size);
+    this->readNames(names, flags, member, size);
+
+    MetaFileOffset encodings = this->readPointer(offset, size);
+    MetaArrayCount count = this->readNumber<MetaArrayCount>(encodings, size);
+    std::string signature = this->readEncodings(encodings, count, size);
+    std::string constructorTokens = this->readString(this->readPointer(offset, size), size);
+
+    std::string description = member.name + " (" + signature + ") flags=" + formatHex(flags & ~(BinaryFlags::HasName | BinaryFlags::HasDemangledName));
+    if (introduced != 0) {
+        description += " introduced=" + formatVersion(introduced);
+    }
+    if (!constructorTokens.empty()) {
+        description += " constructorTokens=" + constructorTokens;
+    }
+    return description;
+}
+
+std::string binary::MetaFileReader::readProperty(MetaFileOffset offset, SymbolDescription& member, size_t& size) const
+{
+    MetaFileOffset names = this->readPointer(offset, size);
+    offset += sizeof(MetaFileOffset);
+    size += sizeof(MetaFileOffset);
+    uint16_t flags = this->readNumber<uint16_t>(offset, size);
+    uint8_t introduced = this->readNumber<uint8_t>(offset, size);
+    this->readNames(names, flags, member, size);
+
+    std::string description = member.name + " flags=" + formatHex(flags & ~(BinaryFlags::HasName | BinaryFlags::HasDemangledName));
+    if (introduced != 0) {
+        description += " introduced=" + formatVersion(introduced);
+    }
+    // see PropertyMeta::save, only the present accessors are written
+    SymbolDescription accessor;
+    if (flags & BinaryFlags::PropertyHasGetter) {
+        description += " getter=" + this->readMethod(this->readPointer(offset, size), accessor, size);
+    }
+    if (flags & BinaryFlags::PropertyHasSetter) {
+        description += " setter=" + this->readMethod(this->readPointer(offset, size), accessor, size);
+    }
+    return description;
+}
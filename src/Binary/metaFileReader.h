@@ -0,0 +1,174 @@
+#pragma once
+
+#include "binaryStructures.h"
+#include <llvm/Support/MemoryBuffer.h>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace binary {
+/*
+ * \brief The decoded contents of a top level module entry in a binary metadata file.
+ */
+struct ModuleDescription {
+    uint8_t flags = 0;
+    std::vector<std::string> libraries;
+
+    // Number of heap bytes taken by the module entry and its libraries
+    size_t size = 0;
+};
+
+/*
+ * \brief The decoded contents of a top level meta in a binary metadata file.
+ *
+ * All values are rendered as canonical strings, so that two files can be compared
+ * regardless of the heap offsets at which the metas and their strings are stored.
+ */
+struct SymbolDescription {
+    std::string jsName;
+    std::string name;
+    std::string demangledName;
+    std::string module;
+    BinaryMetaType type = BinaryMetaType::Undefined;
+
+    // The flags, introduced version, encodings, etc. of the meta, keyed by attribute name
+    std::map<std::string, std::string> attributes;
+
+    // The methods and properties of interfaces and protocols, keyed by kind and jsName
+    std::map<std::string, std::string> members;
+
+    // Number of heap bytes reachable from the meta. Interned strings are counted for every meta referencing them.
+    size_t size = 0;
+};
+
+/*
+ * \class MetaFileReader
+ * \brief Decodes a binary metadata file written by \c MetaFile::save.
+ *
+ * The file is memory mapped and read in place, so large files can be inspected without
+ * copying them. The heap of a compressed file (see \c CompressedMetaFileHeader) is decompressed
+ * in memory when it's opened. Malformed files are reported with \c std::runtime_error.
+ */
+class MetaFileReader {
+public:
+    /*
+     * \brief Maps the specified file in memory and reads its global tables.
+     * \return The error of opening the file, if it can't be read.
+     */
+    static llvm::ErrorOr<std::unique_ptr<MetaFileReader> > open(const std::string& filename);
+
+    size_t fileSize() const
+    {
+        return _buffer->getBufferSize();
+    }
+
+    size_t heapSize() const
+    {
+        return _heapSize;
+    }
+
+    /*
+     * \brief Returns the number of compressed blocks of the heap, which is 0 for uncompressed files.
+     */
+    size_t compressedBlocksCount() const
+    {
+        return _compressedBlocksCount;
+    }
+
+    /*
+     * \brief Counts the buckets of the symbols tables which aren't in the uncompressed beginning of the heap,
+     * i.e. the ones whose lookups have to decompress a block. It is 0 for uncompressed files.
+     */
+    size_t countCompressedBuckets() const;
+
+    /*
+     * \brief Returns the version of the binary format, which is stored in the first byte of the heap.
+     */
+    uint8_t binaryFormatVersion() const
+    {
+        return _heapSize == 0 ? 0 : _heap[0];
+    }
+
+    /*
+     * \brief Decodes the top level modules table, keyed by module name.
+     */
+    void readModules(std::map<std::string, ModuleDescription>& modules);
+
+    /*
+     * \brief Decodes all metas in the jsName symbols table, keyed by jsName.
+     */
+    void readSymbols(std::map<std::string, SymbolDescription>& symbols);
+
+    /*
+     * \brief Collects the keys of the native protocols and native interfaces symbols tables.
+     */
+    void readNativeNames(std::set<std::string>& protocols, std::set<std::string>& interfaces);
+
+private:
+    explicit MetaFileReader(std::unique_ptr<llvm::MemoryBuffer> buffer);
+
+    /*
+     * \brief Decompresses the heap of a compressed file and returns the position of its global tables.
+     */
+    const uint8_t* decompress(const uint8_t* start, const uint8_t* end);
+
+    const uint8_t* bytes(MetaFileOffset offset, size_t count) const;
+
+    template <typename T>
+    T readNumber(MetaFileOffset& offset, size_t& size) const
+    {
+        const uint8_t* data = this->bytes(offset, sizeof(T));
+        uint32_t n = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            n |= (uint32_t)data[i] << (8 * i);
+        }
+        offset += sizeof(T);
+        size += sizeof(T);
+        return (T)n;
+    }
+
+    MetaFileOffset readPointer(MetaFileOffset& offset, size_t& size) const
+    {
+        return this->readNumber<MetaFileOffset>(offset, size);
+    }
+
+    std::string readString(MetaFileOffset offset, size_t& size) const;
+
+    std::vector<MetaFileOffset> readArray(MetaFileOffset offset, size_t& size) const;
+
+    std::string readStringArray(MetaFileOffset offset, size_t& size) const;
+
+    std::string readEncoding(MetaFileOffset& offset, size_t& size) const;
+
+    std::string readEncodings(MetaFileOffset& offset, size_t count, size_t& size) const;
+
+    void readNames(MetaFileOffset names, uint16_t flags, SymbolDescription& symbol, size_t& size) const;
+
+    const std::string& readModuleName(MetaFileOffset offset);
+
+    void readSymbol(MetaFileOffset offset, SymbolDescription& symbol);
+
+    void readMembers(MetaFileOffset array, const char* kind, SymbolDescription& symbol, std::vector<std::string>& memberNames);
+
+    void verifyMembersIndex(MetaFileOffset offset, const std::vector<std::string> (&memberNames)[4], SymbolDescription& symbol);
+
+    std::string readMethod(MetaFileOffset offset, SymbolDescription& member, size_t& size) const;
+
+    std::string readProperty(MetaFileOffset offset, SymbolDescription& member, size_t& size) const;
+
+    std::unique_ptr<llvm::MemoryBuffer> _buffer;
+    const uint8_t* _heap;
+    size_t _heapSize;
+    // The size of the beginning of the heap which is stored uncompressed, the whole heap for uncompressed files
+    size_t _rawHeapSize;
+    size_t _compressedBlocksCount = 0;
+    std::vector<uint8_t> _decompressedHeap;
+    std::vector<MetaFileOffset> _jsSymbolsBuckets;
+    std::vector<MetaFileOffset> _nativeProtocolsBuckets;
+    std::vector<MetaFileOffset> _nativeInterfacesBuckets;
+    std::vector<MetaFileOffset> _modules;
+    std::unordered_map<MetaFileOffset, std::string> _moduleNames;
+};
+}
@@ -6,7 +6,10 @@
 #include <clang/Tooling/Tooling.h>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <llvm/ADT/StringSwitch.h>
+#include <llvm/Support/Chrono.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
 
 using namespace clang;
@@ -83,7 +86,7 @@ static std::error_code collectModuleHeaderIncludes(FileManager& fileMgr, ModuleM
     return std::error_code();
 }
 
-static std::error_code CreateUmbrellaHeaderForAmbientModules(const std::vector<std::string>& args, std::vector<SmallString<256>>& umbrellaHeaders, std::vector<std::string>& includePaths)
+static std::error_code CreateUmbrellaHeaderForAmbientModules(const std::vector<std::string>& args, const std::vector<std::string>& targetModules, std::vector<SmallString<256>>& umbrellaHeaders, std::vector<std::string>& includePaths)
 {
     std::unique_ptr<clang::ASTUnit> ast = clang::tooling::buildASTFromCodeWithArgs("", args, "umbrella.h");
     if (!ast)
@@ -93,7 +96,19 @@ static std::error_code CreateUmbrellaHeaderForAmbientModules(const std::vector<s
 
     clang::SmallVector<clang::Module*, 64> modules;
     HeaderSearch& headerSearch = ast->getPreprocessor().getHeaderSearchInfo();
-    headerSearch.collectAllModules(modules);
+    if (targetModules.empty()) {
+        headerSearch.collectAllModules(modules);
+    }
+    else {
+        // Only the module maps of the targets are loaded, the rest of the SDK isn't searched
+        for (const std::string& moduleName : targetModules) {
+            clang::Module* module = headerSearch.lookupModule(moduleName);
+            if (module == nullptr) {
+                throw std::runtime_error("Target module " + moduleName + " not found.");
+            }
+            modules.push_back(module);
+        }
+    }
 
     ModuleMap& moduleMap = headerSearch.getModuleMap();
     FileManager& fileManager = ast->getFileManager();
@@ -132,11 +147,11 @@ int headerPriority(SmallString<256> h) {
 }
 
 
-std::string CreateUmbrellaHeader(const std::vector<std::string>& clangArgs, std::vector<std::string>& includePaths)
+std::string CreateUmbrellaHeader(const std::vector<std::string>& clangArgs, std::vector<std::string>& includePaths, const std::vector<std::string>& targetModules)
 {
     // Generate umbrella header for all modules from the sdk
     std::vector<SmallString<256>> umbrellaHeaders;
-    CreateUmbrellaHeaderForAmbientModules(clangArgs, umbrellaHeaders, includePaths);
+    CreateUmbrellaHeaderForAmbientModules(clangArgs, targetModules, umbrellaHeaders, includePaths);
 
     std::stable_sort(umbrellaHeaders.begin(), umbrellaHeaders.end(), [](const SmallString<256>& h1, const SmallString<256>& h2) {
         return headerPriority(h1) < headerPriority(h2);
@@ -149,3 +164,82 @@ std::string CreateUmbrellaHeader(const std::vector<std::string>& clangArgs, std:
 
     return umbrellaHeaderContents.str();
 }
+
+// The modification time in nanoseconds, so that edits within the same second are detected
+static int64_t getModificationTime(const fs::file_status& status)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(status.getLastModificationTime().time_since_epoch()).count();
+}
+
+void collectInputFiles(const clang::SourceManager& sourceManager, std::vector<InputFile>& files)
+{
+    // The modules are built by other compiler instances, which share the file manager but not the source manager
+    SmallVector<const FileEntry*, 0> fileEntries;
+    sourceManager.getFileManager().GetUniqueIDMapping(fileEntries);
+    for (const FileEntry* file : fileEntries) {
+        // The umbrella header only exists in memory and the module cache is an output of the parse
+        if (file == nullptr || !fs::exists(file->getName()) || path::extension(file->getName()) == ".pcm") {
+            continue;
+        }
+        // The file entry only keeps the modification time in seconds, so the full one is read again. If the file has changed
+        // since it was parsed, it is recorded with an invalid time, which makes the next comparison fail.
+        fs::file_status status;
+        if (fs::status(file->getName(), status)) {
+            continue;
+        }
+        bool isParsedVersion = status.getSize() == (uint64_t)file->getSize() && llvm::sys::toTimeT(status.getLastModificationTime()) == file->getModificationTime();
+        files.push_back({ file->getName().str(), status.getSize(), isParsedVersion ? getModificationTime(status) : -1 });
+    }
+}
+
+void addInputFile(const std::string& path, std::vector<InputFile>& files)
+{
+    fs::file_status status;
+    if (!path.empty() && !fs::status(path, status) && fs::exists(status)) {
+        files.push_back({ path, status.getSize(), getModificationTime(status) });
+    }
+}
+
+std::vector<std::string> getChangedInputFiles(const std::vector<InputFile>& files)
+{
+    std::vector<std::string> changedFiles;
+    for (const InputFile& file : files) {
+        fs::file_status status;
+        if (file.modificationTime < 0 || fs::status(file.path, status) || status.getSize() != file.size || getModificationTime(status) != file.modificationTime) {
+            changedFiles.push_back(file.path);
+        }
+    }
+    return changedFiles;
+}
+
+static void collectModuleImports(const Module* module, ModuleDependencies& dependencies)
+{
+    const std::string& moduleName = module->getTopLevelModule()->Name;
+    for (Module* imported : module->Imports) {
+        const std::string& importedName = imported->getTopLevelModule()->Name;
+        if (importedName != moduleName) {
+            dependencies.dependentModules[importedName].insert(moduleName);
+        }
+    }
+    for (Module::submodule_const_iterator it = module->submodule_begin(); it != module->submodule_end(); ++it) {
+        collectModuleImports(*it, dependencies);
+    }
+}
+
+void collectModuleDependencies(const SourceManager& sourceManager, HeaderSearch& headerSearch, llvm::ArrayRef<Module*> modules, ModuleDependencies& dependencies)
+{
+    SmallVector<const FileEntry*, 0> fileEntries;
+    sourceManager.getFileManager().GetUniqueIDMapping(fileEntries);
+    for (const FileEntry* file : fileEntries) {
+        if (file == nullptr) {
+            continue;
+        }
+        if (Module* module = headerSearch.findModuleForHeader(file).getModule()) {
+            dependencies.headerModules[file->getName().str()] = module->getTopLevelModule()->Name;
+        }
+    }
+
+    for (const Module* module : modules) {
+        collectModuleImports(module, dependencies);
+    }
+}
@@ -1,8 +1,51 @@
 #pragma once
 
+#include <cstdint>
+#include <llvm/ADT/ArrayRef.h>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
+namespace clang {
+class HeaderSearch;
+class Module;
+class SourceManager;
+}
+
 std::vector<std::string> parsePaths(std::string& paths);
 
-std::string CreateUmbrellaHeader(const std::vector<std::string>& clangArgs, std::vector<std::string>& includePaths);
+// Creates an umbrella header for all available modules, or only for the target modules if any are given.
+// The modules imported by the target modules are parsed through their headers' own imports.
+std::string CreateUmbrellaHeader(const std::vector<std::string>& clangArgs, std::vector<std::string>& includePaths, const std::vector<std::string>& targetModules = std::vector<std::string>());
+
+// A file read during the generation, with its size and modification time at the time it was read
+struct InputFile {
+    std::string path;
+    uint64_t size;
+    // In nanoseconds since the epoch, or -1 if the file has changed while it was being read
+    int64_t modificationTime;
+};
+
+// Appends the files on disk which were read through the file manager of the source manager, i.e. the parsed headers and
+// module maps, including the ones read while building the imported modules. Precompiled modules aren't inputs.
+void collectInputFiles(const clang::SourceManager& sourceManager, std::vector<InputFile>& files);
+
+// Appends the file at the given path, if it exists
+void addInputFile(const std::string& path, std::vector<InputFile>& files);
+
+// Returns the paths of the files which have changed or have been removed since they were read
+std::vector<std::string> getChangedInputFiles(const std::vector<InputFile>& files);
+
+// The top level modules of the parsed headers and the top level modules whose metadata depends on each module
+struct ModuleDependencies {
+    // The top level module of each parsed header which belongs to a module
+    std::map<std::string, std::string> headerModules;
+
+    // The top level modules which import a module, directly or through their submodules
+    std::map<std::string, std::set<std::string> > dependentModules;
+};
+
+// Adds the top level modules of the headers read through the file manager of the source manager,
+// and the imports of the given modules and their submodules
+void collectModuleDependencies(const clang::SourceManager& sourceManager, clang::HeaderSearch& headerSearch, llvm::ArrayRef<clang::Module*> modules, ModuleDependencies& dependencies);
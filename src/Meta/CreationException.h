@@ -4,12 +4,15 @@
 #pragma once
 #include "MetaEntities.h"
 #include "TypeEntities.h"
+#include <cassert>
 #include <clang/AST/Type.h>
+#include <functional>
+#include <memory>
 #include <string>
 
 
 #define DEFINE_POLYMORPHIC_THROW \
-virtual void polymorhicThrow() override { \
+virtual void polymorhicThrow() const override { \
     throw *this; \
 }
 
@@ -21,6 +24,29 @@ virtual void polymorhicThrow() override { \
 } while(false)
 
 namespace Meta {
+/*
+ * \brief A compact code describing why the metadata or the type of a declaration could not be created.
+ */
+enum class CreationFailureReason : uint8_t {
+    InvalidDeclaration,
+    MetadataNotCreated,
+    UnknownFile,
+    UnknownModule,
+    AnonymousDeclaration,
+    Unavailable,
+    ForwardDeclaration,
+    DefinedInHeaders,
+    Variadic,
+    Union,
+    NotAStruct,
+    NestedVar,
+    UnsupportedConstantValue,
+    UnsupportedType,
+    InvalidType,
+    MetaDependency,
+    TypeDependency
+};
+
 class CreationException {
 public:
     static std::string constructMessage(std::string outerMessage, std::string innerMessage)
@@ -28,19 +54,51 @@ public:
         return outerMessage + " --> " + innerMessage;
     }
 
-    CreationException(std::string message, bool isError)
-        : _message(message)
+    /*
+     * \brief Creates an exception whose message is a string literal. No string is built until the message is requested.
+     */
+    CreationException(CreationFailureReason reason, const char* message, bool isError)
+        : _reason(reason)
+        , _message(message)
+        , _isError(isError)
+    {
+    }
+
+    /*
+     * \brief Creates an exception whose message is extended with details which are formatted only if the message is requested.
+     */
+    CreationException(CreationFailureReason reason, const char* message, std::function<std::string()> details, bool isError)
+        : _reason(reason)
+        , _message(message)
+        , _details(std::move(details))
         , _isError(isError)
     {
     }
-    
+
+    /*
+     * \brief Creates an exception which is caused by the failed creation of a dependency.
+     */
+    CreationException(CreationFailureReason reason, std::shared_ptr<const CreationException> cause)
+        : _reason(reason)
+        , _message(reason == CreationFailureReason::TypeDependency ? "Can't create type dependency." : "Can't create meta dependency.")
+        , _cause(std::move(cause))
+        , _isError(_cause->isError())
+    {
+    }
+
     virtual ~CreationException() { }
 
-    virtual void polymorhicThrow() = 0;
-    
+    virtual void polymorhicThrow() const = 0;
+
+    CreationFailureReason getReason() const
+    {
+        return _reason;
+    }
+
     std::string getMessage() const
     {
-        return _message;
+        std::string message = _details ? constructMessage(_message, _details()) : std::string(_message);
+        return _cause ? constructMessage(message, _cause->getDetailedMessage()) : message;
     }
 
     virtual std::string getDetailedMessage() const
@@ -54,14 +112,73 @@ public:
     }
 
 private:
-    std::string _message;
+    CreationFailureReason _reason;
+    const char* _message;
+    std::function<std::string()> _details;
+    std::shared_ptr<const CreationException> _cause;
     bool _isError;
 };
 
+typedef std::shared_ptr<const CreationException> CreationFailure;
+
+/*
+ * \class CreationResult
+ * \brief The outcome of a metadata or type creation. It holds either the created value or the (cached) failure,
+ * so that expected failures (e.g. unsupported or unavailable declarations) are reported without throwing.
+ */
+template <class T>
+class CreationResult {
+public:
+    CreationResult(T value)
+        : _value(std::move(value))
+        , _failure()
+    {
+    }
+
+    CreationResult(CreationFailure failure)
+        : _value()
+        , _failure(std::move(failure))
+    {
+        assert(_failure != nullptr);
+    }
+
+    explicit operator bool() const
+    {
+        return _failure == nullptr;
+    }
+
+    T& get()
+    {
+        assert(_failure == nullptr);
+        return _value;
+    }
+
+    const CreationFailure& getFailure() const
+    {
+        return _failure;
+    }
+
+private:
+    T _value;
+    CreationFailure _failure;
+};
+
 class MetaCreationException : public CreationException {
 public:
-    MetaCreationException(const Meta* meta, std::string message, bool isError)
-        : CreationException(message, isError)
+    MetaCreationException(const Meta* meta, CreationFailureReason reason, const char* message, bool isError)
+        : CreationException(reason, message, isError)
+        , _meta(meta)
+    {
+    }
+
+    MetaCreationException(const Meta* meta, CreationFailureReason reason, const char* message, std::function<std::string()> details, bool isError)
+        : CreationException(reason, message, std::move(details), isError)
+        , _meta(meta)
+    {
+    }
+
+    MetaCreationException(const Meta* meta, CreationFailureReason reason, CreationFailure cause)
+        : CreationException(reason, std::move(cause))
         , _meta(meta)
     {
     }
@@ -71,7 +188,7 @@ public:
         return _meta->identificationString() + " : " + this->getMessage();
     }
 
-    const Meta* getMeta()
+    const Meta* getMeta() const
     {
         return _meta;
     }
@@ -84,8 +201,14 @@ private:
 
 class TypeCreationException : public CreationException {
 public:
-    TypeCreationException(const clang::Type* type, std::string message, bool isError)
-        : CreationException(message, isError)
+    TypeCreationException(const clang::Type* type, CreationFailureReason reason, const char* message, bool isError)
+        : CreationException(reason, message, isError)
+        , _type(type)
+    {
+    }
+
+    TypeCreationException(const clang::Type* type, CreationFailureReason reason, CreationFailure cause)
+        : CreationException(reason, std::move(cause))
         , _type(type)
     {
     }
@@ -95,7 +218,7 @@ public:
         return std::string("[Type ") + (_type == nullptr ? "" : _type->getTypeClassName()) + "] : " + this->getMessage();
     }
 
-    const clang::Type* getType()
+    const clang::Type* getType() const
     {
         return _type;
     }
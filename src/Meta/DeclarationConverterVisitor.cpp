@@ -1,8 +1,117 @@
 #include "DeclarationConverterVisitor.h"
-#include <iostream>
 
 using namespace std;
 
+void Meta::DeclarationConverterVisitor::convertDeclarations()
+{
+    // Metadata creation recurses into dependencies through the shared MetaFactory cache, allocates types in the
+    // ASTContext and lazily deserializes declarations from the module files. None of these is thread-safe, so the
+    // declarations are converted sequentially, in the order of their collection.
+    for (const clang::Decl* declaration : _declarations) {
+        // Recreate the cached meta if any of the dependant types which have been pending
+        // when it was cached the 1st time has failed since then, to have a chance to process the errors.
+        // If we have the following (inspired from Tcl_HashTable):
+        // struct HashTable;
+        //
+        // struct HashEntry {
+        //  HashTable*table;
+        //  union {
+        //  }
+        // }
+        //
+        // struct HashTable {
+        //  HashEntry **entries;
+        // }
+        // We do not support unions, so HashEntry is not included in the metadata.
+        // But before recreating metas with failed dependencies we were leaving HashTable
+        // and it caused crashes if accessed at runtime.
+        CreationResult<Meta*> result = this->_metaFactory.tryCreate(*declaration, /*resetCached*/ true);
+        if (!result) {
+            // The messages of the failures are built only when they are logged
+            const CreationException& failure = *result.getFailure();
+            if (failure.isError()) {
+                _diagnostics.log(DiagnosticLevel::Verbose, [&](llvm::raw_ostream& os) {
+                    os << "Exception " << failure.getDetailedMessage();
+                });
+            } else {
+                _diagnostics.log(DiagnosticLevel::Debug, [&](llvm::raw_ostream& os) {
+                    auto namedDecl = clang::dyn_cast<clang::NamedDecl>(declaration);
+                    os << "Skipping " << (namedDecl ? namedDecl->getNameAsString() : "<unknown>") << ": " << failure.getMessage();
+                });
+            }
+
+            if (_diagnostics.isReportEnabled()) {
+                // The cached meta may be only partially populated, so the row is built from the declaration itself
+                const clang::NamedDecl& namedDecl = clang::cast<clang::NamedDecl>(*declaration);
+                std::string name;
+                std::string jsName;
+                MetaFactory::calculateNames(namedDecl, name, jsName);
+                _diagnostics.reportSkippedSymbol(_metaFactory.findModule(namedDecl), name, jsName, failure);
+            }
+            continue;
+        }
+
+        Meta* meta = result.get();
+        std::string whitelistRule;
+        std::string blacklistRule;
+        // Never blacklist NSObject - it's special and always needed by both the {N} runtime and the MDG
+        if (meta->name != "NSObject" && meta->module && _modulesBlacklist.shouldBlacklist(meta->module->getFullModuleName(), meta->name.empty() ? meta->jsName : meta->name, /*r*/ whitelistRule, /*r*/ blacklistRule)) {
+            logSymbolAction(SymbolAction::Blacklisted, meta, whitelistRule, blacklistRule);
+        } else {
+            _metaContainer.push_back(meta);
+            logSymbolAction(SymbolAction::Included, meta, whitelistRule, blacklistRule);
+        }
+    }
+    _declarations.clear();
+}
+
+bool Meta::DeclarationConverterVisitor::isInTargetModules(const clang::Decl& decl)
+{
+    // Declarations of unknown modules fail to be created, so they are skipped as well
+    const clang::Module* module = _metaFactory.findModule(decl);
+    if (module == nullptr) {
+        return false;
+    }
+
+    std::unordered_map<const clang::Module*, bool>::iterator it = _isTargetModule.find(module);
+    if (it == _isTargetModule.end()) {
+        bool isTarget = _targetModules.count(module->getTopLevelModule()->getFullModuleName()) > 0;
+        it = _isTargetModule.emplace(module, isTarget).first;
+    }
+    return it->second;
+}
+
+void Meta::DeclarationConverterVisitor::logSymbolAction(SymbolAction action, const Meta* meta, const std::string& whitelistRule, const std::string& blacklistRule)
+{
+    _diagnostics.reportSymbol(action, meta, whitelistRule, blacklistRule);
+
+    _diagnostics.log(DiagnosticLevel::Verbose, [&](llvm::raw_ostream& os) {
+        os << (action == SymbolAction::Included ? "Included" : "Blacklisted") << " ";
+
+        if (!meta->name.empty() && meta->name != meta->jsName) {
+            os << meta->name << " (JS: " << meta->jsName << ")";
+        } else {
+            os << meta->jsName;
+        }
+
+        os << " from " << meta->module->getFullModuleName();
+
+        if (!whitelistRule.empty() || !blacklistRule.empty()) {
+            os << " (";
+            if (!whitelistRule.empty()) {
+                os << "enabled by '" << whitelistRule << "'";
+                if (!blacklistRule.empty()) {
+                    os << ", ";
+                }
+            }
+            if (!blacklistRule.empty()) {
+                os << "disabled by '" << blacklistRule << "'";
+            }
+            os << ")";
+        }
+    });
+}
+
 bool Meta::DeclarationConverterVisitor::VisitFunctionDecl(clang::FunctionDecl* function)
 {
     return Visit<clang::FunctionDecl>(function);
@@ -1,29 +1,30 @@
 #pragma once
 
 #include "CreationException.h"
+#include "Diagnostics.h"
 #include "MetaFactory.h"
 #include "Filters/ModulesBlacklist.h"
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Frontend/ASTUnit.h>
 #include <clang/Lex/HeaderSearch.h>
 #include <clang/Lex/Preprocessor.h>
-#include <iostream>
-#include <sstream>
 
 namespace Meta {
 class DeclarationConverterVisitor : public clang::RecursiveASTVisitor<DeclarationConverterVisitor> {
 public:
-    explicit DeclarationConverterVisitor(clang::SourceManager& sourceManager, clang::HeaderSearch& headerSearch, bool verbose, ModulesBlacklist& modulesBlacklist)
+    explicit DeclarationConverterVisitor(clang::SourceManager& sourceManager, clang::HeaderSearch& headerSearch, Diagnostics& diagnostics, ModulesBlacklist& modulesBlacklist)
         : _metaContainer()
         , _metaFactory(sourceManager, headerSearch)
-        , _verbose(verbose)
+        , _diagnostics(diagnostics)
         , _modulesBlacklist(modulesBlacklist)
     {
     }
 
     std::list<Meta*>& generateMetadata(clang::TranslationUnitDecl* translationUnit)
     {
+        // The AST traversal only collects the declarations. They are converted afterwards.
         this->TraverseDecl(translationUnit);
+        this->convertDeclarations();
         return _metaContainer;
     }
 
@@ -32,6 +33,16 @@ public:
         return this->_metaFactory;
     }
 
+    /*
+     * \brief Restricts the collected declarations to the ones written in the given top level modules.
+     * The declarations of other modules are created only if a collected declaration depends on them.
+     * \param targetModules The names of the top level modules. All modules are collected if it is empty.
+     */
+    void setTargetModules(const std::vector<std::string>& targetModules)
+    {
+        this->_targetModules = std::unordered_set<std::string>(targetModules.begin(), targetModules.end());
+    }
+
     // RecursiveASTVisitor methods
     bool VisitFunctionDecl(clang::FunctionDecl* function);
 
@@ -53,88 +64,30 @@ private:
     template <class T>
     bool Visit(T* decl)
     {
-        try {
-            // Remove from cache if present to have a chance to process any errors
-            // in dependant types which have been pending when it was cached the 1st time.
-            // If we have the following (inspired from Tcl_HashTable):
-            // struct HashTable;
-            //
-            // struct HashEntry {
-            //  HashTable*table;
-            //  union {
-            //  }
-            // }
-            //
-            // struct HashTable {
-            //  HashEntry **entries;
-            // }
-            // We do not support unions, so HashEntry is not included in the metadata.
-            // But before the cache purge we were leaving HashTable and it caused crashes
-            // if accessed at runtime.
-
-            Meta* meta = this->_metaFactory.create(*decl, /*resetCached*/ true);
-            std::string whitelistRule, blacklistRule;
-            // Never blacklist NSObject - it's special and always needed by both the {N} runtime and the MDG
-            if (meta->name != "NSObject" && meta->module && _modulesBlacklist.shouldBlacklist(meta->module->getFullModuleName(), meta->name.empty() ? meta->jsName : meta->name, /*r*/whitelistRule, /*r*/blacklistRule)) {
-                logSymbolAction("Blacklisted", meta, whitelistRule, blacklistRule);
-            } else {
-                _metaContainer.push_back(meta);
-                logSymbolAction("Included", meta, whitelistRule, blacklistRule);
-            }
-        } catch (MetaCreationException& e) {
-            if (e.isError()) {
-                log(std::stringstream() << "Exception " << e.getDetailedMessage());
-            } else {
-                  // Uncomment for maximum verbosity when debugging metadata generation issues
-//                auto namedDecl = clang::dyn_cast<clang::NamedDecl>(decl);
-//                auto name = namedDecl ? namedDecl->getNameAsString() : "<unknown>";
-//                log(std::stringstream() << "Skipping " << name << ": " << e.getMessage());
-            }
+        if (_targetModules.empty() || this->isInTargetModules(*decl)) {
+            _declarations.push_back(decl);
         }
         return true;
     }
 
-    void logSymbolAction(const std::string& action, const Meta *meta, const std::string &whitelistRule, const std::string &blacklistRule) {
-        std::stringstream ss;
-        ss << action << " ";
-        
-        if (!meta->name.empty() && meta->name != meta->jsName) {
-            ss << meta->name << " (JS: " << meta->jsName << ")";
-        } else {
-            ss << meta->jsName;
-        }
-        
-        ss << " from " << meta->module->getFullModuleName();
-
-        if (!whitelistRule.empty() || !blacklistRule.empty()) {
-            ss << " (";
-            if (!whitelistRule.empty()) {
-                ss << "enabled by '" << whitelistRule << "'";
-                if (!blacklistRule.empty()) {
-                    ss << ", ";
-                }
-            }
-            if (!blacklistRule.empty()) {
-                ss << "disabled by '" << blacklistRule << "'";
-            }
-            ss << ")";
-        }
-        log(ss);
-    }
-    
-    inline void log(const std::stringstream& s) {
-        this->log(s.str());
-    }
-    
-    inline void log(std::string str) {
-        if (this->_verbose) {
-            std::cerr << "verbose: " << str << std::endl;
-        }
-    }
-    
+    bool isInTargetModules(const clang::Decl& decl);
+
+    /*
+     * \brief Creates the metadata of all collected declarations and fills the meta container in the order of their collection.
+     * The declarations are converted on the calling thread. The MetaFactory, its TypeFactory and the Clang AST they read
+     * aren't thread-safe, so concurrent generations (e.g. for multiple target triples) each use their own visitor.
+     */
+    void convertDeclarations();
+
+    void logSymbolAction(SymbolAction action, const Meta* meta, const std::string& whitelistRule, const std::string& blacklistRule);
+
+    std::vector<const clang::Decl*> _declarations;
+    std::unordered_set<std::string> _targetModules;
+    // Whether the declarations of a module are in the target modules
+    std::unordered_map<const clang::Module*, bool> _isTargetModule;
     std::list<Meta*> _metaContainer;
     MetaFactory _metaFactory;
-    bool _verbose;
+    Diagnostics& _diagnostics;
     ModulesBlacklist& _modulesBlacklist;
 };
 } // namespace Meta
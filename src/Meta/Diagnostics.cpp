@@ -0,0 +1,145 @@
+#include "Diagnostics.h"
+#include <iostream>
+#include <llvm/Support/FileSystem.h>
+
+namespace {
+const char* getLevelPrefix(Meta::DiagnosticLevel level)
+{
+    switch (level) {
+    case Meta::DiagnosticLevel::Error:
+        return "error: ";
+    case Meta::DiagnosticLevel::Warning:
+        return "warning: ";
+    case Meta::DiagnosticLevel::Verbose:
+        return "verbose: ";
+    case Meta::DiagnosticLevel::Debug:
+        return "debug: ";
+    }
+    return "";
+}
+
+const char* getActionName(Meta::SymbolAction action)
+{
+    switch (action) {
+    case Meta::SymbolAction::Included:
+        return "included";
+    case Meta::SymbolAction::Blacklisted:
+        return "blacklisted";
+    case Meta::SymbolAction::Skipped:
+        return "skipped";
+    }
+    return "";
+}
+
+// Report fields are tab separated, so tabs, new lines and backslashes in values are escaped
+void writeField(llvm::raw_ostream& os, llvm::StringRef value)
+{
+    for (char c : value) {
+        switch (c) {
+        case '\t':
+            os << "\\t";
+            break;
+        case '\n':
+            os << "\\n";
+            break;
+        case '\\':
+            os << "\\\\";
+            break;
+        default:
+            os << c;
+        }
+    }
+}
+}
+
+const char* Meta::Diagnostics::getReasonName(CreationFailureReason reason)
+{
+    switch (reason) {
+    case CreationFailureReason::InvalidDeclaration:
+        return "invalid-declaration";
+    case CreationFailureReason::MetadataNotCreated:
+        return "metadata-not-created";
+    case CreationFailureReason::UnknownFile:
+        return "unknown-file";
+    case CreationFailureReason::UnknownModule:
+        return "unknown-module";
+    case CreationFailureReason::AnonymousDeclaration:
+        return "anonymous-declaration";
+    case CreationFailureReason::Unavailable:
+        return "unavailable";
+    case CreationFailureReason::ForwardDeclaration:
+        return "forward-declaration";
+    case CreationFailureReason::DefinedInHeaders:
+        return "defined-in-headers";
+    case CreationFailureReason::Variadic:
+        return "variadic";
+    case CreationFailureReason::Union:
+        return "union";
+    case CreationFailureReason::NotAStruct:
+        return "not-a-struct";
+    case CreationFailureReason::NestedVar:
+        return "nested-var";
+    case CreationFailureReason::UnsupportedConstantValue:
+        return "unsupported-constant-value";
+    case CreationFailureReason::UnsupportedType:
+        return "unsupported-type";
+    case CreationFailureReason::InvalidType:
+        return "invalid-type";
+    case CreationFailureReason::MetaDependency:
+        return "meta-dependency";
+    case CreationFailureReason::TypeDependency:
+        return "type-dependency";
+    }
+    return "";
+}
+
+void Meta::Diagnostics::write(DiagnosticLevel level, const std::string& message)
+{
+    std::cerr << getLevelPrefix(level) << message << std::endl;
+}
+
+bool Meta::Diagnostics::openReport(const std::string& reportPath)
+{
+    std::error_code error;
+    std::unique_ptr<llvm::raw_fd_ostream> report(new llvm::raw_fd_ostream(reportPath, error, llvm::sys::fs::F_Text));
+    if (error) {
+        this->log(DiagnosticLevel::Error, [&](llvm::raw_ostream& os) {
+            os << "Unable to create symbols report " << reportPath << ": " << error.message();
+        });
+        return false;
+    }
+
+    *report << "action\tmodule\tname\tjsName\treason\twhitelistRule\tblacklistRule\n";
+    _report = std::move(report);
+    return true;
+}
+
+void Meta::Diagnostics::reportSymbol(SymbolAction action, const Meta* meta, const std::string& whitelistRule, const std::string& blacklistRule)
+{
+    if (_report) {
+        this->writeReportLine(action, meta->module, meta->name, meta->jsName, "", whitelistRule, blacklistRule);
+    }
+}
+
+void Meta::Diagnostics::reportSkippedSymbol(const clang::Module* module, const std::string& name, const std::string& jsName, const CreationException& failure)
+{
+    if (_report) {
+        this->writeReportLine(SymbolAction::Skipped, module, name, jsName, getReasonName(failure.getReason()), "", "");
+    }
+}
+
+void Meta::Diagnostics::writeReportLine(SymbolAction action, const clang::Module* module, const std::string& name, const std::string& jsName, const char* reason, const std::string& whitelistRule, const std::string& blacklistRule)
+{
+    llvm::raw_fd_ostream& os = *_report;
+    os << getActionName(action) << "\t";
+    writeField(os, module ? module->getFullModuleName() : "");
+    os << "\t";
+    writeField(os, name);
+    os << "\t";
+    writeField(os, jsName);
+    os << "\t" << reason << "\t";
+    writeField(os, whitelistRule);
+    os << "\t";
+    writeField(os, blacklistRule);
+    os << "\n";
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CreationException.h"
+#include "MetaEntities.h"
+#include <llvm/Support/raw_ostream.h>
+#include <memory>
+#include <string>
+
+namespace Meta {
+enum class DiagnosticLevel {
+    Error,
+    Warning,
+    Verbose,
+    Debug
+};
+
+enum class SymbolAction {
+    Included,
+    Blacklisted,
+    Skipped
+};
+
+/*
+ * \class Diagnostics
+ * \brief Reports the diagnostics of the metadata generation.
+ *
+ * Messages are formatted by callbacks which are invoked only if the level of the message is enabled,
+ * so disabled diagnostics don't build any strings. Optionally, the outcome of every top level symbol is written
+ * to a tab-separated report file.
+ */
+class Diagnostics {
+public:
+    explicit Diagnostics(DiagnosticLevel level)
+        : _level(level)
+    {
+    }
+
+    bool isEnabled(DiagnosticLevel level) const
+    {
+        return level <= _level;
+    }
+
+    /*
+     * \brief Logs a message if its level is enabled.
+     * \param level The level of the message
+     * \param formatter A callable taking an llvm::raw_ostream& which writes the message. It is not called if the level is disabled.
+     */
+    template <class Formatter>
+    void log(DiagnosticLevel level, Formatter formatter)
+    {
+        if (this->isEnabled(level)) {
+            std::string message;
+            llvm::raw_string_ostream os(message);
+            formatter(os);
+            this->write(level, os.str());
+        }
+    }
+
+    /*
+     * \brief Creates the per-symbol report file and writes its header line.
+     * \return false if the file can't be created.
+     */
+    bool openReport(const std::string& reportPath);
+
+    bool isReportEnabled() const
+    {
+        return _report != nullptr;
+    }
+
+    /*
+     * \brief Writes a line in the report for a symbol which is included in or blacklisted from the metadata.
+     */
+    void reportSymbol(SymbolAction action, const Meta* meta, const std::string& whitelistRule, const std::string& blacklistRule);
+
+    /*
+     * \brief Writes a line in the report for a symbol whose metadata could not be created.
+     * \param module The module of the symbol, or null if it is unknown.
+     * \param name The native name of the symbol's declaration.
+     * \param jsName The JavaScript name of the symbol's declaration.
+     */
+    void reportSkippedSymbol(const clang::Module* module, const std::string& name, const std::string& jsName, const CreationException& failure);
+
+    static const char* getReasonName(CreationFailureReason reason);
+
+private:
+    void write(DiagnosticLevel level, const std::string& message);
+
+    void writeReportLine(SymbolAction action, const clang::Module* module, const std::string& name, const std::string& jsName, const char* reason, const std::string& whitelistRule, const std::string& blacklistRule);
+
+    DiagnosticLevel _level;
+    std::unique_ptr<llvm::raw_fd_ostream> _report;
+};
+}
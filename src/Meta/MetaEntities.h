@@ -175,6 +175,10 @@ public:
     std::vector<Type*> signature;
     std::string constructorTokens;
 
+    // The names of the parameters as declared in the headers
+    std::vector<std::string> parameterNames;
+    bool isInstanceMethod = true;
+
     virtual void visit(MetaVisitor* visitor) override;
 };
 
@@ -188,6 +192,7 @@ public:
 
     MethodMeta* getter = nullptr;
     MethodMeta* setter = nullptr;
+    bool isClassProperty = false;
 
     virtual void visit(MetaVisitor* visitor) override;
 };
@@ -232,6 +237,12 @@ public:
 
     InterfaceMeta* base;
 
+    // The names of the generic type parameters, e.g. ObjectType of NSArray<ObjectType>
+    std::vector<std::string> typeParameters;
+
+    // The type arguments with which the base interface is specialized, e.g. NSString of MyClass : NSArray<NSString*>
+    std::vector<Type*> baseTypeArguments;
+
     virtual void visit(MetaVisitor* visitor) override;
 };
 
@@ -267,6 +278,7 @@ public:
         this->type = MetaType::Function;
     }
     std::vector<Type*> signature;
+    std::vector<std::string> parameterNames;
 
     virtual void visit(MetaVisitor* visitor) override;
 };
@@ -11,40 +11,112 @@ using namespace std;
 
 namespace Meta {
 
-static bool compareJsNames(string& protocol1, string& protocol2)
-{
-    string name1 = protocol1;
-    string name2 = protocol2;
-    transform(name1.begin(), name1.end(), name1.begin(), ::tolower);
-    transform(name2.begin(), name2.end(), name2.begin(), ::tolower);
-    return name1 < name2;
+namespace {
+// Collects the dependencies of a meta or a type for as long as it is alive
+class DependencyFrame {
+public:
+    DependencyFrame(std::vector<std::vector<const clang::Decl*>*>& frames, std::vector<const clang::Decl*>& dependencies)
+        : _frames(frames)
+        , _dependencies(dependencies)
+    {
+        _frames.push_back(&_dependencies);
+    }
+
+    ~DependencyFrame()
+    {
+        _frames.pop_back();
+        std::sort(_dependencies.begin(), _dependencies.end());
+        _dependencies.erase(std::unique(_dependencies.begin(), _dependencies.end()), _dependencies.end());
+    }
+
+private:
+    std::vector<std::vector<const clang::Decl*>*>& _frames;
+    std::vector<const clang::Decl*>& _dependencies;
+};
 }
 
-static bool metasComparerByJsName(Meta* meta1, Meta* meta2)
+// Creates the type of a meta's member. If the type can't be created, returns the failure of the meta.
+static CreationFailure createType(TypeFactory& typeFactory, const clang::QualType& qualType, const Meta& meta, Type*& type)
 {
-    return compareJsNames(meta1->jsName, meta2->jsName);
+    CreationResult<shared_ptr<Type> > result = typeFactory.tryCreate(qualType);
+    if (!result) {
+        return make_shared<MetaCreationException>(&meta, CreationFailureReason::TypeDependency, result.getFailure());
+    }
+    type = result.get().get();
+    return nullptr;
 }
 
-void MetaFactory::validate(Type* type)
+CreationFailure MetaFactory::validate(Type* type)
 {
     ValidateMetaTypeVisitor validator(*this);
     
     type->visit(validator);
+    return validator.getFailure();
+}
+
+CreationFailure MetaFactory::validate(Type* type, std::vector<const clang::Decl*>& dependencies)
+{
+    DependencyFrame frame(this->_dependencyFrames, dependencies);
+    return this->validate(type);
+}
+
+void MetaFactory::addDependency(const clang::Decl* dependency)
+{
+    if (!this->_dependencyFrames.empty()) {
+        this->_dependencyFrames.back()->push_back(dependency);
+    }
+}
+
+void MetaFactory::addDependencies(const std::vector<const clang::Decl*>& dependencies)
+{
+    if (!this->_dependencyFrames.empty()) {
+        std::vector<const clang::Decl*>& frame = *this->_dependencyFrames.back();
+        frame.insert(frame.end(), dependencies.begin(), dependencies.end());
+    }
+}
+
+bool MetaFactory::hasFailedDependencies(const clang::Decl* decl, std::unordered_set<const clang::Decl*>& visited)
+{
+    // Declarations which are already being checked (i.e. cyclic dependencies) are decided by the outermost check
+    if (!visited.insert(decl).second) {
+        return false;
+    }
+
+    // Nothing has failed since the declaration was last checked
+    auto checkedIt = this->_dependenciesCheckedGeneration.find(decl);
+    if (checkedIt != this->_dependenciesCheckedGeneration.end() && checkedIt->second == this->getValidationGeneration()) {
+        return false;
+    }
+
+    auto dependenciesIt = this->_dependencies.find(decl);
+    if (dependenciesIt == this->_dependencies.end()) {
+        return false;
+    }
+
+    for (const clang::Decl* dependency : dependenciesIt->second) {
+        auto cachedIt = this->_cache.find(dependency);
+        if (cachedIt != this->_cache.end() && cachedIt->second.second.get() != nullptr) {
+            return true;
+        }
+        if (this->hasFailedDependencies(dependency, visited)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void MetaFactory::validate(Meta* meta)
+CreationFailure MetaFactory::validate(Meta* meta)
 {
     auto declIt = this->_metaToDecl.find(meta);
     if (declIt == this->_metaToDecl.end()) {
-        throw MetaCreationException(meta, "Metadata not created", true);
+        return make_shared<MetaCreationException>(meta, CreationFailureReason::MetadataNotCreated, "Metadata not created", true);
     }
 
+    this->addDependency(declIt->second);
+
     auto metaIt = this->_cache.find(declIt->second);
     assert(metaIt != this->_cache.end());
-    if (metaIt->second.second.get() != nullptr) {
-//        printf("**** Validation failed for %s: %s ***\n\n", meta->name.c_str(), metaIt->second.second.c_str());
-        POLYMORPHIC_THROW(metaIt->second.second);
-    }
+    return metaIt->second.second;
 }
     
 string MetaFactory::getTypedefOrOwnName(const clang::TagDecl* tagDecl)
@@ -69,7 +141,7 @@ string MetaFactory::getTypedefOrOwnName(const clang::TagDecl* tagDecl)
 }
 
 template<class T>
-void resetMetaAndAddToMap(std::unique_ptr<Meta>& metaPtrRef, MetaToDeclMap& metaToDecl, const clang::Decl& decl) {
+Meta& resetMetaAndAddToMap(std::unique_ptr<Meta>& metaPtrRef, MetaToDeclMap& metaToDecl, const clang::Decl& decl) {
     if (metaPtrRef.get()) {
         // The pointer has been previously allocated. Reset it's value and assert that it's already present in the map
         static_cast<T&>(*metaPtrRef) = T();
@@ -79,30 +151,49 @@ void resetMetaAndAddToMap(std::unique_ptr<Meta>& metaPtrRef, MetaToDeclMap& meta
         metaPtrRef.reset(new T());
         metaToDecl[metaPtrRef.get()] = &decl;
     }
-    
-    if (decl.isInvalidDecl()) {
-        std::string declDump;
-        llvm::raw_string_ostream os(declDump);
-        decl.dump(os);
-        throw MetaCreationException(metaPtrRef.get(), CreationException::constructMessage("Invalid decl.", os.str()), true);
-    }
+
+    return *metaPtrRef;
 }
 
 Meta* MetaFactory::create(const clang::Decl& decl, bool resetCached /* = false*/)
 {
+    CreationResult<Meta*> result = this->tryCreate(decl, resetCached);
+    if (!result) {
+        POLYMORPHIC_THROW(result.getFailure());
+    }
+    return result.get();
+}
+
+CreationResult<Meta*> MetaFactory::tryCreate(const clang::Decl& decl, bool resetCached /* = false*/)
+{
+    this->addDependency(&decl);
+
     // Check for cached Meta
     Cache::iterator cachedMetaIt = _cache.find(&decl);
+    if (resetCached && cachedMetaIt != _cache.end() && cachedMetaIt->second.second.get() == nullptr) {
+        // Rebuild the meta only if something it depends on has failed after it was created
+        std::unordered_set<const clang::Decl*> visited;
+        if (!this->hasFailedDependencies(&decl, visited)) {
+            // All checked declarations are known to be valid until the next failure
+            uint64_t generation = this->getValidationGeneration();
+            for (const clang::Decl* checkedDecl : visited) {
+                this->_dependenciesCheckedGeneration[checkedDecl] = generation;
+            }
+            resetCached = false;
+        }
+    }
+
     if (!resetCached && cachedMetaIt != _cache.end()) {
-        Meta* meta = cachedMetaIt->second.first.get();
-        if (auto creationException = cachedMetaIt->second.second.get()) {
-            POLYMORPHIC_THROW(creationException);
+        // A failed creation is reported with its cached failure, without being repeated
+        if (const CreationFailure& failure = cachedMetaIt->second.second) {
+            return failure;
         }
 
         /* TODO: The meta object is not guaranteed to be fully initialized. If the meta object is in the creation stack
              * it will appear in cache, but will not be fully initialized. This may cause some inconsistent results.
              * */
         
-        return meta;
+        return cachedMetaIt->second.first.get();
     }
 
     if (cachedMetaIt == _cache.end()) {
@@ -111,107 +202,126 @@ Meta* MetaFactory::create(const clang::Decl& decl, bool resetCached /* = false*/
         cachedMetaIt = insertionResult.first;
     }
     std::unique_ptr<Meta>& insertedMetaPtrRef = cachedMetaIt->second.first;
-    std::unique_ptr<CreationException>& insertedException = cachedMetaIt->second.second;
+    CreationFailure& insertedFailure = cachedMetaIt->second.second;
+    bool hasFailedBefore = insertedFailure != nullptr;
+
+    std::vector<const clang::Decl*>& dependencies = this->_dependencies[&decl];
+    dependencies.clear();
+    DependencyFrame dependencyFrame(this->_dependencyFrames, dependencies);
+
+    Meta* meta = nullptr;
+    if (clang::isa<clang::FunctionDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<FunctionMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (const clang::RecordDecl* record = clang::dyn_cast<clang::RecordDecl>(&decl)) {
+        if (record->isStruct()) {
+            meta = &resetMetaAndAddToMap<StructMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+        } else {
+            meta = &resetMetaAndAddToMap<UnionMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+        }
+    } else if (clang::isa<clang::VarDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<VarMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (clang::isa<clang::EnumDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<EnumMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (clang::isa<clang::EnumConstantDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<EnumConstantMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (clang::isa<clang::ObjCInterfaceDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<InterfaceMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (clang::isa<clang::ObjCProtocolDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<ProtocolMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (clang::isa<clang::ObjCCategoryDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<CategoryMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (clang::isa<clang::ObjCMethodDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<MethodMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else if (clang::isa<clang::ObjCPropertyDecl>(decl)) {
+        meta = &resetMetaAndAddToMap<PropertyMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
+    } else {
+        throw logic_error("Unknown declaration type.");
+    }
+
+    CreationFailure failure;
+    if (decl.isInvalidDecl()) {
+        // The declaration is dumped only if the message is logged
+        const clang::Decl* invalidDecl = &decl;
+        failure = make_shared<MetaCreationException>(meta, CreationFailureReason::InvalidDeclaration, "Invalid decl.", [invalidDecl]() {
+            std::string declDump;
+            llvm::raw_string_ostream os(declDump);
+            invalidDecl->dump(os);
+            return os.str();
+        }, true);
+    } else {
+        failure = populateIdentificationFields(clang::cast<clang::NamedDecl>(decl), *meta);
+    }
 
-    try {
+    if (failure == nullptr) {
         if (const clang::FunctionDecl* function = clang::dyn_cast<clang::FunctionDecl>(&decl)) {
-            resetMetaAndAddToMap<FunctionMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*function, *insertedMetaPtrRef.get());
-            createFromFunction(*function, insertedMetaPtrRef.get()->as<FunctionMeta>());
+            failure = createFromFunction(*function, meta->as<FunctionMeta>());
         } else if (const clang::RecordDecl* record = clang::dyn_cast<clang::RecordDecl>(&decl)) {
             if (record->isStruct()) {
-                resetMetaAndAddToMap<StructMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-                populateIdentificationFields(*record, *insertedMetaPtrRef.get());
-                createFromStruct(*record, insertedMetaPtrRef.get()->as<StructMeta>());
+                failure = createFromStruct(*record, meta->as<StructMeta>());
             } else {
-                resetMetaAndAddToMap<UnionMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-                populateIdentificationFields(*record, *insertedMetaPtrRef.get());
-                throw MetaCreationException(insertedMetaPtrRef.get(), "The record is union.", false);
+                failure = make_shared<MetaCreationException>(meta, CreationFailureReason::Union, "The record is union.", false);
             }
         } else if (const clang::VarDecl* var = clang::dyn_cast<clang::VarDecl>(&decl)) {
-            resetMetaAndAddToMap<VarMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*var, *insertedMetaPtrRef.get());
-            createFromVar(*var, insertedMetaPtrRef.get()->as<VarMeta>());
+            failure = createFromVar(*var, meta->as<VarMeta>());
         } else if (const clang::EnumDecl* enumDecl = clang::dyn_cast<clang::EnumDecl>(&decl)) {
-            resetMetaAndAddToMap<EnumMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*enumDecl, *insertedMetaPtrRef.get());
-            createFromEnum(*enumDecl, insertedMetaPtrRef.get()->as<EnumMeta>());
+            failure = createFromEnum(*enumDecl, meta->as<EnumMeta>());
         } else if (const clang::EnumConstantDecl* enumConstantDecl = clang::dyn_cast<clang::EnumConstantDecl>(&decl)) {
-            resetMetaAndAddToMap<EnumConstantMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*enumConstantDecl, *insertedMetaPtrRef.get());
-            createFromEnumConstant(*enumConstantDecl, insertedMetaPtrRef.get()->as<EnumConstantMeta>());
+            failure = createFromEnumConstant(*enumConstantDecl, meta->as<EnumConstantMeta>());
         } else if (const clang::ObjCInterfaceDecl* interface = clang::dyn_cast<clang::ObjCInterfaceDecl>(&decl)) {
-            resetMetaAndAddToMap<InterfaceMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*interface, *insertedMetaPtrRef.get());
-            createFromInterface(*interface, insertedMetaPtrRef.get()->as<InterfaceMeta>());
+            failure = createFromInterface(*interface, meta->as<InterfaceMeta>());
         } else if (const clang::ObjCProtocolDecl* protocol = clang::dyn_cast<clang::ObjCProtocolDecl>(&decl)) {
-            resetMetaAndAddToMap<ProtocolMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*protocol, *insertedMetaPtrRef.get());
-            createFromProtocol(*protocol, insertedMetaPtrRef.get()->as<ProtocolMeta>());
+            failure = createFromProtocol(*protocol, meta->as<ProtocolMeta>());
         } else if (const clang::ObjCCategoryDecl* category = clang::dyn_cast<clang::ObjCCategoryDecl>(&decl)) {
-            resetMetaAndAddToMap<CategoryMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*category, *insertedMetaPtrRef.get());
-            createFromCategory(*category, insertedMetaPtrRef.get()->as<CategoryMeta>());
+            failure = createFromCategory(*category, meta->as<CategoryMeta>());
         } else if (const clang::ObjCMethodDecl* method = clang::dyn_cast<clang::ObjCMethodDecl>(&decl)) {
-            resetMetaAndAddToMap<MethodMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*method, *insertedMetaPtrRef.get());
-            createFromMethod(*method, insertedMetaPtrRef.get()->as<MethodMeta>());
+            failure = createFromMethod(*method, meta->as<MethodMeta>());
         } else if (const clang::ObjCPropertyDecl* property = clang::dyn_cast<clang::ObjCPropertyDecl>(&decl)) {
-            resetMetaAndAddToMap<PropertyMeta>(insertedMetaPtrRef, this->_metaToDecl, decl);
-            populateIdentificationFields(*property, *insertedMetaPtrRef.get());
-            createFromProperty(*property, insertedMetaPtrRef.get()->as<PropertyMeta>());
-        } else {
-            throw logic_error("Unknown declaration type.");
+            failure = createFromProperty(*property, meta->as<PropertyMeta>());
         }
-
-        return insertedMetaPtrRef.get();
-    } catch (MetaCreationException& e) {
-        if (e.getMeta() == insertedMetaPtrRef.get()) {
-            insertedException = llvm::make_unique<MetaCreationException>(e);
-            throw;
-        }
-        std::string message = CreationException::constructMessage("Can't create meta dependency.", e.getDetailedMessage());
-        insertedException = llvm::make_unique<MetaCreationException>(insertedMetaPtrRef.get(), message, e.isError());
-        POLYMORPHIC_THROW(insertedException);
-    } catch (TypeCreationException& e) {
-        std::string message = CreationException::constructMessage("Can't create type dependency.", e.getDetailedMessage());
-        insertedException = llvm::make_unique<MetaCreationException>(insertedMetaPtrRef.get(), message, e.isError());
-        POLYMORPHIC_THROW(insertedException);
     }
-}
 
-bool MetaFactory::tryCreate(const clang::Decl& decl, Meta** meta)
-{
-    try {
-        Meta* result = this->create(decl);
-        if (meta != nullptr) {
-            *meta = result;
+    if (failure != nullptr) {
+        // Only a declaration which becomes invalid can invalidate the types validated so far
+        if (!hasFailedBefore) {
+            this->invalidateValidatedTypes();
         }
-        return true;
-    } catch (CreationException& e) {
-        return false;
+        insertedFailure = failure;
+        return failure;
     }
+
+    return meta;
 }
 
-void MetaFactory::createFromFunction(const clang::FunctionDecl& function, FunctionMeta& functionMeta)
+CreationFailure MetaFactory::createFromFunction(const clang::FunctionDecl& function, FunctionMeta& functionMeta)
 {
     if (function.isThisDeclarationADefinition()) {
-        throw MetaCreationException(&functionMeta, "The function is defined in headers.", false);
+        return make_shared<MetaCreationException>(&functionMeta, CreationFailureReason::DefinedInHeaders, "The function is defined in headers.", false);
     }
 
     // TODO: We don't support variadic functions but we save in metadata flags whether a function is variadic or not.
     // If we not plan in the future to support variadic functions this redundant flag should be removed.
     if (function.isVariadic())
-        throw MetaCreationException(&functionMeta, "The function is variadic.", false);
+        return make_shared<MetaCreationException>(&functionMeta, CreationFailureReason::Variadic, "The function is variadic.", false);
 
-    populateMetaFields(function, functionMeta);
+    if (CreationFailure failure = populateMetaFields(function, functionMeta)) {
+        return failure;
+    }
 
     functionMeta.setFlags(MetaFlags::FunctionIsVariadic, function.isVariadic()); // set IsVariadic
 
     // set signature
-    functionMeta.signature.push_back(_typeFactory.create(function.getReturnType()).get());
+    Type* returnType;
+    if (CreationFailure failure = createType(_typeFactory, function.getReturnType(), functionMeta, returnType)) {
+        return failure;
+    }
+    functionMeta.signature.push_back(returnType);
     for (clang::ParmVarDecl* param : function.parameters()) {
-        functionMeta.signature.push_back(_typeFactory.create(param->getType()).get());
+        Type* paramType;
+        if (CreationFailure failure = createType(_typeFactory, param->getType(), functionMeta, paramType)) {
+            return failure;
+        }
+        functionMeta.signature.push_back(paramType);
+        functionMeta.parameterNames.push_back(param->getNameAsString());
     }
 
     bool returnsRetained = function.hasAttr<clang::NSReturnsRetainedAttr>() || function.hasAttr<clang::CFReturnsRetainedAttr>();
@@ -230,40 +340,52 @@ void MetaFactory::createFromFunction(const clang::FunctionDecl& function, Functi
     }
 
     functionMeta.setFlags(MetaFlags::FunctionOwnsReturnedCocoaObject, returnsRetained); // set OwnsReturnedCocoaObjects
+    return nullptr;
 }
 
-void MetaFactory::createFromStruct(const clang::RecordDecl& record, StructMeta& structMeta)
+CreationFailure MetaFactory::createFromStruct(const clang::RecordDecl& record, StructMeta& structMeta)
 {
     if (!record.isStruct())
-        throw MetaCreationException(&structMeta, "The record is not a struct.", false);
+        return make_shared<MetaCreationException>(&structMeta, CreationFailureReason::NotAStruct, "The record is not a struct.", false);
     if (!record.isThisDeclarationADefinition()) {
-        throw MetaCreationException(&structMeta, "A forward declaration of record.", false);
+        return make_shared<MetaCreationException>(&structMeta, CreationFailureReason::ForwardDeclaration, "A forward declaration of record.", false);
     }
 
-    populateMetaFields(record, structMeta);
+    if (CreationFailure failure = populateMetaFields(record, structMeta)) {
+        return failure;
+    }
 
     // set fields
     for (clang::FieldDecl* field : record.fields()) {
-        RecordField recordField(field->getNameAsString(), _typeFactory.create(field->getType()).get());
+        Type* fieldType;
+        if (CreationFailure failure = createType(_typeFactory, field->getType(), structMeta, fieldType)) {
+            return failure;
+        }
+        RecordField recordField(field->getNameAsString(), fieldType);
         structMeta.fields.push_back(recordField);
     }
+    return nullptr;
 }
 
-void MetaFactory::createFromVar(const clang::VarDecl& var, VarMeta& varMeta)
+CreationFailure MetaFactory::createFromVar(const clang::VarDecl& var, VarMeta& varMeta)
 {
     if (var.getLexicalDeclContext() != var.getASTContext().getTranslationUnitDecl()) {
-        throw MetaCreationException(&varMeta, "A nested var.", false);
+        return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::NestedVar, "A nested var.", false);
     }
 
-    populateMetaFields(var, varMeta);
+    if (CreationFailure failure = populateMetaFields(var, varMeta)) {
+        return failure;
+    }
     //set type
-    varMeta.signature = _typeFactory.create(var.getType()).get();
+    if (CreationFailure failure = createType(_typeFactory, var.getType(), varMeta, varMeta.signature)) {
+        return failure;
+    }
     varMeta.hasValue = false;
 
     if (var.hasInit()) {
         clang::APValue* evValue = var.evaluateValue();
         if (evValue == nullptr) {
-            throw MetaCreationException(&varMeta, "Unable to evaluate compile-time constant value.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Unable to evaluate compile-time constant value.", false);
         }
 
         varMeta.hasValue = true;
@@ -277,40 +399,43 @@ void MetaFactory::createFromVar(const clang::VarDecl& var, VarMeta& varMeta)
             evValue->getFloat().toString(valueAsString);
             break;
         case clang::APValue::ValueKind::ComplexInt:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: ComplexInt.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: ComplexInt.", false);
         case clang::APValue::ValueKind::ComplexFloat:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: ComplexFloat.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: ComplexFloat.", false);
         case clang::APValue::ValueKind::AddrLabelDiff:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: AddrLabelDiff.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: AddrLabelDiff.", false);
         case clang::APValue::ValueKind::Array:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: Array.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: Array.", false);
         case clang::APValue::ValueKind::LValue:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: LValue.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: LValue.", false);
         case clang::APValue::ValueKind::MemberPointer:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: MemberPointer.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: MemberPointer.", false);
         case clang::APValue::ValueKind::Struct:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: Struct.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: Struct.", false);
         case clang::APValue::ValueKind::Union:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: Union.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: Union.", false);
         case clang::APValue::ValueKind::Vector:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: Vector.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: Vector.", false);
         case clang::APValue::ValueKind::Uninitialized:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: Uninitialized.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: Uninitialized.", false);
         default:
-            throw MetaCreationException(&varMeta, "Not supported compile-time constant value: -.", false);
+            return make_shared<MetaCreationException>(&varMeta, CreationFailureReason::UnsupportedConstantValue, "Not supported compile-time constant value: -.", false);
         }
 
         varMeta.value = std::string(valueAsString.data(), valueAsString.size());
     }
+    return nullptr;
 }
 
-void MetaFactory::createFromEnum(const clang::EnumDecl& enumeration, EnumMeta& enumMeta)
+CreationFailure MetaFactory::createFromEnum(const clang::EnumDecl& enumeration, EnumMeta& enumMeta)
 {
     if (!enumeration.isThisDeclarationADefinition()) {
-        throw MetaCreationException(&enumMeta, "Forward declaration of enum.", false);
+        return make_shared<MetaCreationException>(&enumMeta, CreationFailureReason::ForwardDeclaration, "Forward declaration of enum.", false);
     }
 
-    populateMetaFields(enumeration, enumMeta);
+    if (CreationFailure failure = populateMetaFields(enumeration, enumMeta)) {
+        return failure;
+    }
 
     std::vector<std::string> fieldNames;
     for (clang::EnumConstantDecl* enumField : enumeration.enumerators())
@@ -329,11 +454,14 @@ void MetaFactory::createFromEnum(const clang::EnumDecl& enumeration, EnumMeta& e
         }
         enumMeta.fullNameFields.push_back({ enumField->getNameAsString(), valueStr });
     }
+    return nullptr;
 }
 
-void MetaFactory::createFromEnumConstant(const clang::EnumConstantDecl& enumConstant, EnumConstantMeta& enumConstantMeta)
+CreationFailure MetaFactory::createFromEnumConstant(const clang::EnumConstantDecl& enumConstant, EnumConstantMeta& enumConstantMeta)
 {
-    populateMetaFields(enumConstant, enumConstantMeta);
+    if (CreationFailure failure = populateMetaFields(enumConstant, enumConstantMeta)) {
+        return failure;
+    }
 
     llvm::SmallVector<char, 10> value;
     enumConstant.getInitVal().toString(value, 10, enumConstant.getInitVal().isSigned());
@@ -342,44 +470,88 @@ void MetaFactory::createFromEnumConstant(const clang::EnumConstantDecl& enumCons
     const clang::EnumDecl* parent = clang::cast<clang::EnumDecl>(enumConstant.getDeclContext());
     EnumMeta& parentMeta = this->_cache.find(parent)->second.first.get()->as<EnumMeta>();
     enumConstantMeta.isScoped = !parentMeta.jsName.empty();
+    return nullptr;
 }
 
-void MetaFactory::createFromInterface(const clang::ObjCInterfaceDecl& interface, InterfaceMeta& interfaceMeta)
+CreationFailure MetaFactory::createFromInterface(const clang::ObjCInterfaceDecl& interface, InterfaceMeta& interfaceMeta)
 {
     if (!interface.isThisDeclarationADefinition()) {
-        throw MetaCreationException(&interfaceMeta, "A forward declaration of interface.", false);
+        return make_shared<MetaCreationException>(&interfaceMeta, CreationFailureReason::ForwardDeclaration, "A forward declaration of interface.", false);
     }
 
-    populateMetaFields(interface, interfaceMeta);
+    if (CreationFailure failure = populateMetaFields(interface, interfaceMeta)) {
+        return failure;
+    }
     populateBaseClassMetaFields(interface, interfaceMeta);
 
     // set base interface
     clang::ObjCInterfaceDecl* super = interface.getSuperClass();
-    interfaceMeta.base = (super == nullptr || super->getDefinition() == nullptr) ? nullptr : &this->create(*super->getDefinition())->as<InterfaceMeta>();
+    interfaceMeta.base = nullptr;
+    if (super != nullptr && super->getDefinition() != nullptr) {
+        CreationResult<Meta*> base = this->tryCreate(*super->getDefinition());
+        if (!base) {
+            return make_shared<MetaCreationException>(&interfaceMeta, CreationFailureReason::MetaDependency, base.getFailure());
+        }
+        interfaceMeta.base = &base.get()->as<InterfaceMeta>();
+
+        // An unsupported type argument of the base is omitted, so the interface is still generated
+        // and its typings fall back to the base's implicit NSObject arguments.
+        if (const clang::ObjCObjectType* superType = interface.getSuperClassType()) {
+            for (const clang::QualType& typeArgument : superType->getTypeArgsAsWritten()) {
+                CreationResult<shared_ptr<Type> > argument = _typeFactory.tryCreate(typeArgument);
+                if (!argument) {
+                    interfaceMeta.baseTypeArguments.clear();
+                    break;
+                }
+                interfaceMeta.baseTypeArguments.push_back(argument.get().get());
+            }
+        }
+    }
+
+    if (clang::ObjCTypeParamList* typeParameters = interface.getTypeParamListAsWritten()) {
+        for (clang::ObjCTypeParamDecl* typeParameter : *typeParameters) {
+            interfaceMeta.typeParameters.push_back(typeParameter->getNameAsString());
+        }
+    }
+    return nullptr;
 }
 
-void MetaFactory::createFromProtocol(const clang::ObjCProtocolDecl& protocol, ProtocolMeta& protocolMeta)
+CreationFailure MetaFactory::createFromProtocol(const clang::ObjCProtocolDecl& protocol, ProtocolMeta& protocolMeta)
 {
     if (!protocol.isThisDeclarationADefinition()) {
-        throw MetaCreationException(&protocolMeta, "A forward declaration of protocol.", false);
+        return make_shared<MetaCreationException>(&protocolMeta, CreationFailureReason::ForwardDeclaration, "A forward declaration of protocol.", false);
     }
 
-    populateMetaFields(protocol, protocolMeta);
+    if (CreationFailure failure = populateMetaFields(protocol, protocolMeta)) {
+        return failure;
+    }
     populateBaseClassMetaFields(protocol, protocolMeta);
+    return nullptr;
 }
 
-void MetaFactory::createFromCategory(const clang::ObjCCategoryDecl& category, CategoryMeta& categoryMeta)
+CreationFailure MetaFactory::createFromCategory(const clang::ObjCCategoryDecl& category, CategoryMeta& categoryMeta)
 {
-    populateMetaFields(category, categoryMeta);
+    if (CreationFailure failure = populateMetaFields(category, categoryMeta)) {
+        return failure;
+    }
     populateBaseClassMetaFields(category, categoryMeta);
-    categoryMeta.extendedInterface = &this->create(*category.getClassInterface()->getDefinition())->as<InterfaceMeta>();
+
+    CreationResult<Meta*> extendedInterface = this->tryCreate(*category.getClassInterface()->getDefinition());
+    if (!extendedInterface) {
+        return make_shared<MetaCreationException>(&categoryMeta, CreationFailureReason::MetaDependency, extendedInterface.getFailure());
+    }
+    categoryMeta.extendedInterface = &extendedInterface.get()->as<InterfaceMeta>();
+    return nullptr;
 }
 
-void MetaFactory::createFromMethod(const clang::ObjCMethodDecl& method, MethodMeta& methodMeta)
+CreationFailure MetaFactory::createFromMethod(const clang::ObjCMethodDecl& method, MethodMeta& methodMeta)
 {
-    populateMetaFields(method, methodMeta);
+    if (CreationFailure failure = populateMetaFields(method, methodMeta)) {
+        return failure;
+    }
     
     methodMeta.setFlags(MetaFlags::MemberIsOptional, method.isOptional());
+    methodMeta.isInstanceMethod = method.isInstanceMethod();
     methodMeta.setFlags(MetaFlags::MethodIsVariadic, method.isVariadic()); // set IsVariadic flag
 
     bool isNullTerminatedVariadic = method.isVariadic() && method.hasAttr<clang::SentinelAttr>(); // set MethodIsNilTerminatedVariadic flag
@@ -388,7 +560,10 @@ void MetaFactory::createFromMethod(const clang::ObjCMethodDecl& method, MethodMe
     // set MethodHasErrorOutParameter flag
     if (method.parameters().size() > 0) {
         clang::ParmVarDecl* lastParameter = method.parameters()[method.parameters().size() - 1];
-        Type* type = _typeFactory.create(lastParameter->getType()).get();
+        Type* type;
+        if (CreationFailure failure = createType(_typeFactory, lastParameter->getType(), methodMeta, type)) {
+            return failure;
+        }
         if (type->is(TypeType::TypePointer)) {
             Type* innerType = type->as<PointerType>().innerType;
             if (innerType->is(TypeType::TypeInterface) && innerType->as<InterfaceType>().interface->jsName == "NSError") {
@@ -443,7 +618,7 @@ void MetaFactory::createFromMethod(const clang::ObjCMethodDecl& method, MethodMe
     }
 
     if (method.isVariadic() && !isNullTerminatedVariadic)
-        throw MetaCreationException(&methodMeta, "Method is variadic (and is not marked as nil terminated.).", false);
+        return make_shared<MetaCreationException>(&methodMeta, CreationFailureReason::Variadic, "Method is variadic (and is not marked as nil terminated.).", false);
 
     // set MethodOwnsReturnedCocoaObject flag
     clang::ObjCMethodFamily methodFamily = method.getMethodFamily();
@@ -467,23 +642,51 @@ void MetaFactory::createFromMethod(const clang::ObjCMethodDecl& method, MethodMe
     }
 
     // set signature
-    methodMeta.signature.push_back(method.hasRelatedResultType() ? _typeFactory.getInstancetype().get() : _typeFactory.create(method.getReturnType()).get());
+    Type* returnType = _typeFactory.getInstancetype().get();
+    if (!method.hasRelatedResultType()) {
+        if (CreationFailure failure = createType(_typeFactory, method.getReturnType(), methodMeta, returnType)) {
+            return failure;
+        }
+    }
+    methodMeta.signature.push_back(returnType);
     for (clang::ParmVarDecl* param : method.parameters()) {
-        methodMeta.signature.push_back(_typeFactory.create(param->getType()).get());
+        Type* paramType;
+        if (CreationFailure failure = createType(_typeFactory, param->getType(), methodMeta, paramType)) {
+            return failure;
+        }
+        methodMeta.signature.push_back(paramType);
+        methodMeta.parameterNames.push_back(param->getNameAsString());
     }
+    return nullptr;
 }
 
-void MetaFactory::createFromProperty(const clang::ObjCPropertyDecl& property, PropertyMeta& propertyMeta)
+CreationFailure MetaFactory::createFromProperty(const clang::ObjCPropertyDecl& property, PropertyMeta& propertyMeta)
 {
-    populateMetaFields(property, propertyMeta);
+    if (CreationFailure failure = populateMetaFields(property, propertyMeta)) {
+        return failure;
+    }
 
     propertyMeta.setFlags(MetaFlags::MemberIsOptional, property.isOptional());
+    propertyMeta.isClassProperty = property.isClassProperty();
 
-    clang::ObjCMethodDecl* getter = property.getGetterMethodDecl();
-    propertyMeta.getter = getter ? &create(*getter)->as<MethodMeta>() : nullptr;
+    propertyMeta.getter = nullptr;
+    if (clang::ObjCMethodDecl* getter = property.getGetterMethodDecl()) {
+        CreationResult<Meta*> getterMeta = tryCreate(*getter);
+        if (!getterMeta) {
+            return make_shared<MetaCreationException>(&propertyMeta, CreationFailureReason::MetaDependency, getterMeta.getFailure());
+        }
+        propertyMeta.getter = &getterMeta.get()->as<MethodMeta>();
+    }
 
-    clang::ObjCMethodDecl* setter = property.getSetterMethodDecl();
-    propertyMeta.setter = setter ? &create(*setter)->as<MethodMeta>() : nullptr;
+    propertyMeta.setter = nullptr;
+    if (clang::ObjCMethodDecl* setter = property.getSetterMethodDecl()) {
+        CreationResult<Meta*> setterMeta = tryCreate(*setter);
+        if (!setterMeta) {
+            return make_shared<MetaCreationException>(&propertyMeta, CreationFailureReason::MetaDependency, setterMeta.getFailure());
+        }
+        propertyMeta.setter = &setterMeta.get()->as<MethodMeta>();
+    }
+    return nullptr;
 }
 
 
@@ -497,7 +700,10 @@ std::string demangleSwiftName(std::string name) {
     using namespace redi;
     static const std::string cmd = "script -q /dev/null xcrun swift demangle";
     static pstream ps(cmd, pstreams::pstdin|pstreams::pstdout|pstreams::pstderr);
-    
+    // The process is shared by all generations which run at the same time
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
     // Send the name to child process
     ps << name << std::endl;
     
@@ -514,28 +720,14 @@ std::string demangleSwiftName(std::string name) {
     return result;
 }
 
-void MetaFactory::populateIdentificationFields(const clang::NamedDecl& decl, Meta& meta)
+void MetaFactory::calculateNames(const clang::NamedDecl& decl, std::string& name, std::string& jsName)
 {
-    meta.declaration = &decl;
     // calculate name
     clang::ObjCRuntimeNameAttr* objCRuntimeNameAttribute = decl.getAttr<clang::ObjCRuntimeNameAttr>();
     if (objCRuntimeNameAttribute) {
-        meta.name = objCRuntimeNameAttribute->getMetadataName().str();
-        auto demangled = demangleSwiftName(meta.name);
-        if (meta.name != demangled) {
-            meta.demangledName = demangled;
-        }
+        name = objCRuntimeNameAttribute->getMetadataName().str();
     } else {
-        meta.name = decl.getNameAsString();
-    }
-
-    // calculate file name and module
-    clang::SourceLocation location = _sourceManager.getFileLoc(decl.getLocation());
-    clang::FileID fileId = _sourceManager.getDecomposedLoc(location).first;
-    const clang::FileEntry* entry = _sourceManager.getFileEntryForID(fileId);
-    if (entry != nullptr) {
-        meta.fileName = entry->getName();
-        meta.module = _headerSearch.findModuleForHeader(entry).getModule();
+        name = decl.getNameAsString();
     }
 
     // calculate js name
@@ -547,7 +739,7 @@ void MetaFactory::populateIdentificationFields(const clang::NamedDecl& decl, Met
     case clang::Decl::Kind::ObjCProperty:
     case clang::Decl::Kind::EnumConstant:
     case clang::Decl::Kind::Var:
-        meta.jsName = decl.getNameAsString();
+        jsName = decl.getNameAsString();
         break;
     case clang::Decl::Kind::ObjCMethod: {
         const clang::ObjCMethodDecl* method = clang::dyn_cast<clang::ObjCMethodDecl>(&decl);
@@ -558,40 +750,71 @@ void MetaFactory::populateIdentificationFields(const clang::NamedDecl& decl, Met
             tokens[i][0] = toupper(tokens[i][0]);
             tokens[0] += tokens[i];
         }
-        meta.jsName = tokens[0];
+        jsName = tokens[0];
         break;
     }
     case clang::Decl::Kind::Record:
     case clang::Decl::Kind::Enum: {
         const clang::TagDecl* tagDecl = clang::dyn_cast<clang::TagDecl>(&decl);
-        meta.name = meta.jsName = getTypedefOrOwnName(tagDecl);
+        name = jsName = getTypedefOrOwnName(tagDecl);
         break;
     }
     default:
         throw logic_error(string("Can't generate jsName for ") + decl.getDeclKindName() + " type of declaration.");
     }
+}
+
+clang::Module* MetaFactory::findModule(const clang::Decl& decl, std::string* fileName)
+{
+    clang::SourceLocation location = _sourceManager.getFileLoc(decl.getLocation());
+    clang::FileID fileId = _sourceManager.getDecomposedLoc(location).first;
+    const clang::FileEntry* entry = _sourceManager.getFileEntryForID(fileId);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    if (fileName != nullptr) {
+        *fileName = entry->getName();
+    }
+    return _headerSearch.findModuleForHeader(entry).getModule();
+}
+
+CreationFailure MetaFactory::populateIdentificationFields(const clang::NamedDecl& decl, Meta& meta)
+{
+    meta.declaration = &decl;
+    calculateNames(decl, meta.name, meta.jsName);
+    if (decl.hasAttr<clang::ObjCRuntimeNameAttr>()) {
+        auto demangled = demangleSwiftName(meta.name);
+        if (meta.name != demangled) {
+            meta.demangledName = demangled;
+        }
+    }
+
+    // calculate file name and module
+    meta.module = findModule(decl, &meta.fileName);
 
     // We allow  anonymous categories to be created. There is no need for categories to be named
     // because we don't keep them as separate entity in metadata. They are merged in their interfaces
     if (!meta.is(MetaType::Category)) {
         if (meta.fileName == "") {
-            throw MetaCreationException(&meta, "Unknown file for declaration.", true);
+            return make_shared<MetaCreationException>(&meta, CreationFailureReason::UnknownFile, "Unknown file for declaration.", true);
         } else if (meta.module == nullptr) {
-            throw MetaCreationException(&meta, "Unknown module for declaration.", false);
+            return make_shared<MetaCreationException>(&meta, CreationFailureReason::UnknownModule, "Unknown module for declaration.", false);
         } else if (meta.jsName == "") {
-            throw MetaCreationException(&meta, "Anonymous declaration. Unable to calculate JS name.", false);
+            return make_shared<MetaCreationException>(&meta, CreationFailureReason::AnonymousDeclaration, "Anonymous declaration. Unable to calculate JS name.", false);
         }
     }
+    return nullptr;
 }
 
-void MetaFactory::populateMetaFields(const clang::NamedDecl& decl, Meta& meta)
+CreationFailure MetaFactory::populateMetaFields(const clang::NamedDecl& decl, Meta& meta)
 {
     clang::AvailabilityAttr* iosAvailability = nullptr;
     clang::AvailabilityAttr* iosExtensionsAvailability = nullptr;
 
     // Traverse attributes
     if (decl.hasAttr<clang::UnavailableAttr>()) {
-        throw MetaCreationException(&meta, "The declaration is marked unavailable (with unavailable attribute).", false);
+        return make_shared<MetaCreationException>(&meta, CreationFailureReason::Unavailable, "The declaration is marked unavailable (with unavailable attribute).", false);
     }
     vector<clang::AvailabilityAttr*> availabilityAttributes = Utils::getAttributes<clang::AvailabilityAttr>(decl);
     for (clang::AvailabilityAttr* availability : availabilityAttributes) {
@@ -619,7 +842,7 @@ void MetaFactory::populateMetaFields(const clang::NamedDecl& decl, Meta& meta)
          */
     if (iosAvailability) {
         if (iosAvailability->getUnavailable()) {
-            throw MetaCreationException(&meta, "The declaration is marked unvailable for ios platform (with availability attribute).", false);
+            return make_shared<MetaCreationException>(&meta, CreationFailureReason::Unavailable, "The declaration is marked unvailable for ios platform (with availability attribute).", false);
         }
         meta.introducedIn = this->convertVersion(iosAvailability->getIntroduced());
         meta.deprecatedIn = this->convertVersion(iosAvailability->getDeprecated());
@@ -627,47 +850,51 @@ void MetaFactory::populateMetaFields(const clang::NamedDecl& decl, Meta& meta)
     }
     bool isIosExtensionsAvailable = iosExtensionsAvailability == nullptr || !iosExtensionsAvailability->getUnavailable();
     meta.setFlags(MetaFlags::IsIosAppExtensionAvailable, isIosExtensionsAvailable);
+    return nullptr;
 }
 
 void MetaFactory::populateBaseClassMetaFields(const clang::ObjCContainerDecl& decl, BaseClassMeta& baseClass)
 {
     for (clang::ObjCProtocolDecl* protocol : this->getProtocols(&decl)) {
-        Meta* protocolMeta;
-        
-        if (protocol->getDefinition() != nullptr && this->tryCreate(*protocol->getDefinition(), &protocolMeta)) {
-            baseClass.protocols.push_back(&protocolMeta->as<ProtocolMeta>());
+        if (protocol->getDefinition() != nullptr) {
+            if (CreationResult<Meta*> protocolMeta = this->tryCreate(*protocol->getDefinition())) {
+                baseClass.protocols.push_back(&protocolMeta.get()->as<ProtocolMeta>());
+            }
         }
     }
-    std::sort(baseClass.protocols.begin(), baseClass.protocols.end(), metasComparerByJsName); // order by jsName
+    Utils::sortMetasByJsName(baseClass.protocols);
 
     for (clang::ObjCMethodDecl* classMethod : decl.class_methods()) {
-        Meta* methodMeta;
-        if (!classMethod->isImplicit() && this->tryCreate(*classMethod, &methodMeta)) {
-            baseClass.staticMethods.push_back(&methodMeta->as<MethodMeta>());
+        if (classMethod->isImplicit()) {
+            continue;
+        }
+        if (CreationResult<Meta*> methodMeta = this->tryCreate(*classMethod)) {
+            baseClass.staticMethods.push_back(&methodMeta.get()->as<MethodMeta>());
         }
     }
-    std::sort(baseClass.staticMethods.begin(), baseClass.staticMethods.end(), metasComparerByJsName); // order by jsName
+    Utils::sortMetasByJsName(baseClass.staticMethods);
 
     for (clang::ObjCMethodDecl* instanceMethod : decl.instance_methods()) {
-        Meta* methodMeta;
-        if (!instanceMethod->isImplicit() && this->tryCreate(*instanceMethod, &methodMeta)) {
-            baseClass.instanceMethods.push_back(&methodMeta->as<MethodMeta>());
+        if (instanceMethod->isImplicit()) {
+            continue;
+        }
+        if (CreationResult<Meta*> methodMeta = this->tryCreate(*instanceMethod)) {
+            baseClass.instanceMethods.push_back(&methodMeta.get()->as<MethodMeta>());
         }
     }
-    std::sort(baseClass.instanceMethods.begin(), baseClass.instanceMethods.end(), metasComparerByJsName); // order by jsName
+    Utils::sortMetasByJsName(baseClass.instanceMethods);
 
     for (clang::ObjCPropertyDecl* property : decl.properties()) {
-        Meta* propertyMeta;
-        if (this->tryCreate(*property, &propertyMeta)) {
+        if (CreationResult<Meta*> propertyMeta = this->tryCreate(*property)) {
             if (!property->isClassProperty()) {
-                baseClass.instanceProperties.push_back(&propertyMeta->as<PropertyMeta>());
+                baseClass.instanceProperties.push_back(&propertyMeta.get()->as<PropertyMeta>());
             } else {
-                baseClass.staticProperties.push_back(&propertyMeta->as<PropertyMeta>());
+                baseClass.staticProperties.push_back(&propertyMeta.get()->as<PropertyMeta>());
             }
         }
     }
-    std::sort(baseClass.instanceProperties.begin(), baseClass.instanceProperties.end(), metasComparerByJsName); // order by jsName
-    std::sort(baseClass.staticProperties.begin(), baseClass.staticProperties.end(), metasComparerByJsName); // order by jsName
+    Utils::sortMetasByJsName(baseClass.instanceProperties);
+    Utils::sortMetasByJsName(baseClass.staticProperties);
 }
     
 std::string MetaFactory::renameMeta(MetaType type, std::string& originalJsName, int index)
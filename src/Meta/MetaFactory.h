@@ -5,14 +5,16 @@
 #include "TypeFactory.h"
 #include "Utils/Noncopyable.h"
 #include <clang/AST/RecursiveASTVisitor.h>
+#include <unordered_set>
 #include <clang/Frontend/ASTUnit.h>
 #include <clang/Lex/HeaderSearch.h>
 #include <clang/Lex/Preprocessor.h>
 
 namespace Meta {
 
-typedef std::unordered_map<const clang::Decl*, std::pair<std::unique_ptr<Meta>, std::unique_ptr<CreationException>> > Cache;
+typedef std::unordered_map<const clang::Decl*, std::pair<std::unique_ptr<Meta>, CreationFailure> > Cache;
 typedef std::unordered_map<const Meta*, const clang::Decl*> MetaToDeclMap;
+typedef std::unordered_map<const clang::Decl*, std::vector<const clang::Decl*> > DependenciesMap;
 
 class MetaFactory {
 public:
@@ -20,12 +22,25 @@ public:
         : _sourceManager(sourceManager)
         , _headerSearch(headerSearch)
         , _typeFactory(this)
+        , _validationGeneration(1)
     {
     }
 
+    /*
+     * \brief Creates the metadata for a declaration or returns the cached one.
+     * \param decl The declaration
+     * \param resetCached If true, a cached meta is created again if its creation has failed or if a declaration
+     * it depends on has failed after it was returned (e.g. while still being created, or from a forward declaration).
+     */
     Meta* create(const clang::Decl& decl, bool resetCached = false);
 
-    bool tryCreate(const clang::Decl& decl, Meta** meta);
+    /*
+     * \brief Creates the metadata for a declaration or returns the cached one, without throwing if the creation fails.
+     * \param decl The declaration
+     * \param resetCached The same as in \c create
+     * \return The meta or the (cached) reason of the failure.
+     */
+    CreationResult<Meta*> tryCreate(const clang::Decl& decl, bool resetCached = false);
 
     TypeFactory& getTypeFactory()
     {
@@ -37,43 +52,86 @@ public:
         return this->_cache;
     }
     
-    void validate(Type* type);
+    /*
+     * \brief Checks whether the metas referenced by a type have been created successfully.
+     * \return The failure of the first invalid meta, or null if the type is valid.
+     */
+    CreationFailure validate(Type* type);
+
+    /*
+     * \brief Validates a type and collects the declarations of all metas it references.
+     */
+    CreationFailure validate(Type* type, std::vector<const clang::Decl*>& dependencies);
+
+    /*
+     * \brief Records the given declarations as dependencies of the meta which is currently being created.
+     */
+    void addDependencies(const std::vector<const clang::Decl*>& dependencies);
+
+    CreationFailure validate(Meta* meta);
+
+    /*
+     * \brief Returns a counter which is incremented every time the metadata creation of a declaration fails for the first time.
+     * Types which were validated in the current generation are known to be still valid.
+     */
+    uint64_t getValidationGeneration() const
+    {
+        return this->_validationGeneration;
+    }
 
-    void validate(Meta* meta);
+    void invalidateValidatedTypes()
+    {
+        this->_validationGeneration++;
+    }
     
+    /*
+     * \brief Calculates the native and JavaScript names of a declaration, the same way they are set in its meta.
+     */
+    static void calculateNames(const clang::NamedDecl& decl, std::string& name, std::string& jsName);
+
+    /*
+     * \brief Returns the module of the header in which a declaration is written, or null if it is unknown.
+     * \param fileName If not null, receives the path of the header.
+     */
+    clang::Module* findModule(const clang::Decl& decl, std::string* fileName = nullptr);
+
     static std::string getTypedefOrOwnName(const clang::TagDecl* tagDecl);
     
     static std::string renameMeta(MetaType type, std::string& originalJsName, int index = 1);
 
 private:
-    void createFromFunction(const clang::FunctionDecl& function, FunctionMeta& functionMeta);
+    CreationFailure createFromFunction(const clang::FunctionDecl& function, FunctionMeta& functionMeta);
 
-    void createFromStruct(const clang::RecordDecl& record, StructMeta& recordMeta);
+    CreationFailure createFromStruct(const clang::RecordDecl& record, StructMeta& recordMeta);
 
-    void createFromVar(const clang::VarDecl& var, VarMeta& varMeta);
+    CreationFailure createFromVar(const clang::VarDecl& var, VarMeta& varMeta);
 
-    void createFromEnum(const clang::EnumDecl& enumeration, EnumMeta& enumMeta);
+    CreationFailure createFromEnum(const clang::EnumDecl& enumeration, EnumMeta& enumMeta);
 
-    void createFromEnumConstant(const clang::EnumConstantDecl& enumConstant, EnumConstantMeta& enumMeta);
+    CreationFailure createFromEnumConstant(const clang::EnumConstantDecl& enumConstant, EnumConstantMeta& enumMeta);
 
-    void createFromInterface(const clang::ObjCInterfaceDecl& interface, InterfaceMeta& interfaceMeta);
+    CreationFailure createFromInterface(const clang::ObjCInterfaceDecl& interface, InterfaceMeta& interfaceMeta);
 
-    void createFromProtocol(const clang::ObjCProtocolDecl& protocol, ProtocolMeta& protocolMeta);
+    CreationFailure createFromProtocol(const clang::ObjCProtocolDecl& protocol, ProtocolMeta& protocolMeta);
 
-    void createFromCategory(const clang::ObjCCategoryDecl& category, CategoryMeta& categoryMeta);
+    CreationFailure createFromCategory(const clang::ObjCCategoryDecl& category, CategoryMeta& categoryMeta);
 
-    void createFromMethod(const clang::ObjCMethodDecl& method, MethodMeta& methodMeta);
+    CreationFailure createFromMethod(const clang::ObjCMethodDecl& method, MethodMeta& methodMeta);
 
-    void createFromProperty(const clang::ObjCPropertyDecl& property, PropertyMeta& propertyMeta);
+    CreationFailure createFromProperty(const clang::ObjCPropertyDecl& property, PropertyMeta& propertyMeta);
 
-    void populateIdentificationFields(const clang::NamedDecl& decl, Meta& meta);
+    CreationFailure populateIdentificationFields(const clang::NamedDecl& decl, Meta& meta);
 
-    void populateMetaFields(const clang::NamedDecl& decl, Meta& meta);
+    CreationFailure populateMetaFields(const clang::NamedDecl& decl, Meta& meta);
 
     void populateBaseClassMetaFields(const clang::ObjCContainerDecl& decl, BaseClassMeta& baseClassMeta);
 
     Version convertVersion(const clang::VersionTuple clangVersion);
 
+    void addDependency(const clang::Decl* dependency);
+
+    bool hasFailedDependencies(const clang::Decl* decl, std::unordered_set<const clang::Decl*>& visited);
+
     llvm::iterator_range<clang::ObjCProtocolList::iterator> getProtocols(const clang::ObjCContainerDecl* objCContainer);
 
     clang::SourceManager& _sourceManager;
@@ -82,5 +140,13 @@ private:
 
     Cache _cache;
     MetaToDeclMap _metaToDecl;
+    uint64_t _validationGeneration;
+
+    // The declarations each meta has depended on during its creation
+    DependenciesMap _dependencies;
+    // The dependency lists which are currently being collected, innermost last
+    std::vector<std::vector<const clang::Decl*>*> _dependencyFrames;
+    // The validation generation in which a declaration was last found to have no failed dependencies
+    std::unordered_map<const clang::Decl*, uint64_t> _dependenciesCheckedGeneration;
 };
 }
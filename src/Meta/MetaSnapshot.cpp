@@ -0,0 +1,900 @@
+#include "MetaSnapshot.h"
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+const uint32_t SnapshotMagic = 0x504e534d; // "MSNP"
+const uint32_t SnapshotVersion = 1;
+
+enum SnapshotModuleFlags : uint32_t {
+    ModuleIsFramework = 1 << 0,
+    ModuleIsExplicit = 1 << 1,
+    ModuleIsSystem = 1 << 2
+};
+
+void appendWord(std::string& buffer, uint32_t word)
+{
+    for (int i = 0; i < 4; i++) {
+        buffer.push_back((char)((word >> (8 * i)) & 0xff));
+    }
+}
+
+/*
+ * \brief Assigns indices to the modules, metas, types and strings reachable from the roots and encodes their records.
+ *
+ * Indices are 1-based, 0 stands for a null reference. Records may reference metas and types which are
+ * encoded later, so the loader creates all objects before it reads any record.
+ */
+class SnapshotWriter {
+public:
+    std::string write(Meta::MetaSnapshot::MetasByModules& metasByModules, size_t declarationsCount)
+    {
+        std::vector<uint32_t> roots;
+        roots.push_back(metasByModules.size());
+        for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : metasByModules) {
+            roots.push_back(this->module(modulePair.first));
+            this->metas(roots, modulePair.second);
+        }
+
+        // Encoding a record appends the metas and types it references which haven't been seen yet
+        std::vector<uint32_t> metaRecords;
+        std::vector<uint32_t> typeRecords;
+        for (size_t metasCount = 0, typesCount = 0; metasCount < _metas.size() || typesCount < _types.size();) {
+            if (metasCount < _metas.size()) {
+                this->writeMeta(*_metas[metasCount++], metaRecords);
+            } else {
+                this->writeType(*_types[typesCount++], typeRecords);
+            }
+        }
+
+        std::vector<uint32_t> moduleRecords;
+        for (clang::Module* module : _modules) {
+            this->writeModule(*module, moduleRecords);
+        }
+
+        std::string buffer;
+        appendWord(buffer, SnapshotMagic);
+        appendWord(buffer, SnapshotVersion);
+        appendWord(buffer, declarationsCount);
+
+        appendWord(buffer, _strings.size());
+        for (const std::string* string : _strings) {
+            appendWord(buffer, string->size());
+            buffer.append(*string);
+            buffer.append((4 - string->size() % 4) % 4, '\0');
+        }
+
+        appendWord(buffer, _modules.size());
+        this->append(buffer, moduleRecords);
+
+        appendWord(buffer, _metas.size());
+        for (Meta::Meta* meta : _metas) {
+            appendWord(buffer, meta->type);
+        }
+        appendWord(buffer, _types.size());
+        for (Meta::Type* type : _types) {
+            appendWord(buffer, type->getType());
+        }
+        this->append(buffer, metaRecords);
+        this->append(buffer, typeRecords);
+
+        this->append(buffer, roots);
+        return buffer;
+    }
+
+private:
+    void append(std::string& buffer, const std::vector<uint32_t>& words)
+    {
+        for (uint32_t word : words) {
+            appendWord(buffer, word);
+        }
+    }
+
+    uint32_t string(const std::string& value)
+    {
+        std::unordered_map<std::string, uint32_t>::iterator it = _stringIndices.find(value);
+        if (it == _stringIndices.end()) {
+            it = _stringIndices.emplace(value, _strings.size()).first;
+            _strings.push_back(&it->first);
+        }
+        return it->second;
+    }
+
+    void strings(std::vector<uint32_t>& out, const std::vector<std::string>& values)
+    {
+        out.push_back(values.size());
+        for (const std::string& value : values) {
+            out.push_back(this->string(value));
+        }
+    }
+
+    uint32_t module(clang::Module* module)
+    {
+        if (module == nullptr) {
+            return 0;
+        }
+
+        std::unordered_map<clang::Module*, uint32_t>::iterator it = _moduleIndices.find(module);
+        if (it == _moduleIndices.end()) {
+            this->addModuleTree(module->getTopLevelModule());
+            it = _moduleIndices.find(module);
+            assert(it != _moduleIndices.end());
+        }
+        return it->second;
+    }
+
+    // Parents are added before their submodules, so that the loader can create them in order
+    void addModuleTree(clang::Module* module)
+    {
+        _modules.push_back(module);
+        _moduleIndices[module] = _modules.size();
+        for (clang::Module::submodule_iterator it = module->submodule_begin(); it != module->submodule_end(); ++it) {
+            this->addModuleTree(*it);
+        }
+    }
+
+    uint32_t meta(Meta::Meta* meta)
+    {
+        if (meta == nullptr) {
+            return 0;
+        }
+
+        std::unordered_map<Meta::Meta*, uint32_t>::iterator it = _metaIndices.find(meta);
+        if (it == _metaIndices.end()) {
+            _metas.push_back(meta);
+            it = _metaIndices.emplace(meta, _metas.size()).first;
+        }
+        return it->second;
+    }
+
+    template <class T>
+    void metas(std::vector<uint32_t>& out, const std::vector<T*>& metas)
+    {
+        out.push_back(metas.size());
+        for (T* meta : metas) {
+            out.push_back(this->meta(meta));
+        }
+    }
+
+    uint32_t type(Meta::Type* type)
+    {
+        if (type == nullptr) {
+            return 0;
+        }
+
+        std::unordered_map<Meta::Type*, uint32_t>::iterator it = _typeIndices.find(type);
+        if (it == _typeIndices.end()) {
+            _types.push_back(type);
+            it = _typeIndices.emplace(type, _types.size()).first;
+        }
+        return it->second;
+    }
+
+    void types(std::vector<uint32_t>& out, const std::vector<Meta::Type*>& types)
+    {
+        out.push_back(types.size());
+        for (Meta::Type* type : types) {
+            out.push_back(this->type(type));
+        }
+    }
+
+    void fields(std::vector<uint32_t>& out, const std::vector<Meta::RecordField>& fields)
+    {
+        out.push_back(fields.size());
+        for (const Meta::RecordField& field : fields) {
+            out.push_back(this->string(field.name));
+            out.push_back(this->type(field.encoding));
+        }
+    }
+
+    void enumFields(std::vector<uint32_t>& out, const std::vector<Meta::EnumField>& fields)
+    {
+        out.push_back(fields.size());
+        for (const Meta::EnumField& field : fields) {
+            out.push_back(this->string(field.name));
+            out.push_back(this->string(field.value));
+        }
+    }
+
+    void version(std::vector<uint32_t>& out, const Meta::Version& version)
+    {
+        out.push_back((uint32_t)version.Major);
+        out.push_back((uint32_t)version.Minor);
+        out.push_back((uint32_t)version.SubMinor);
+    }
+
+    void writeModule(clang::Module& module, std::vector<uint32_t>& out)
+    {
+        out.push_back(this->string(module.Name));
+        out.push_back(this->module(module.Parent));
+        uint32_t flags = 0;
+        if (module.IsFramework)
+            flags |= ModuleIsFramework;
+        if (module.IsExplicit)
+            flags |= ModuleIsExplicit;
+        if (module.IsSystem)
+            flags |= ModuleIsSystem;
+        out.push_back(flags);
+        out.push_back(this->string(module.Directory ? module.Directory->getName().str() : ""));
+        out.push_back(module.LinkLibraries.size());
+        for (const clang::Module::LinkLibrary& library : module.LinkLibraries) {
+            out.push_back(this->string(library.Library));
+            out.push_back(library.IsFramework);
+        }
+    }
+
+    void writeBaseClass(Meta::BaseClassMeta& meta, std::vector<uint32_t>& out)
+    {
+        this->metas(out, meta.instanceMethods);
+        this->metas(out, meta.staticMethods);
+        this->metas(out, meta.instanceProperties);
+        this->metas(out, meta.staticProperties);
+        this->metas(out, meta.protocols);
+    }
+
+    void writeMeta(Meta::Meta& meta, std::vector<uint32_t>& out)
+    {
+        out.push_back(meta.flags);
+        out.push_back(this->string(meta.name));
+        out.push_back(this->string(meta.demangledName));
+        out.push_back(this->string(meta.jsName));
+        out.push_back(this->string(meta.fileName));
+        out.push_back(this->module(meta.module));
+        this->version(out, meta.introducedIn);
+        this->version(out, meta.obsoletedIn);
+        this->version(out, meta.deprecatedIn);
+
+        switch (meta.type) {
+        case Meta::MetaType::Method: {
+            Meta::MethodMeta& method = meta.as<Meta::MethodMeta>();
+            this->types(out, method.signature);
+            out.push_back(this->string(method.constructorTokens));
+            this->strings(out, method.parameterNames);
+            out.push_back(method.isInstanceMethod);
+            break;
+        }
+        case Meta::MetaType::Property: {
+            Meta::PropertyMeta& property = meta.as<Meta::PropertyMeta>();
+            out.push_back(this->meta(property.getter));
+            out.push_back(this->meta(property.setter));
+            out.push_back(property.isClassProperty);
+            break;
+        }
+        case Meta::MetaType::Protocol:
+            this->writeBaseClass(meta.as<Meta::ProtocolMeta>(), out);
+            break;
+        case Meta::MetaType::Category: {
+            Meta::CategoryMeta& category = meta.as<Meta::CategoryMeta>();
+            this->writeBaseClass(category, out);
+            out.push_back(this->meta(category.extendedInterface));
+            break;
+        }
+        case Meta::MetaType::Interface: {
+            Meta::InterfaceMeta& interface = meta.as<Meta::InterfaceMeta>();
+            this->writeBaseClass(interface, out);
+            out.push_back(this->meta(interface.base));
+            this->strings(out, interface.typeParameters);
+            this->types(out, interface.baseTypeArguments);
+            break;
+        }
+        case Meta::MetaType::Struct:
+        case Meta::MetaType::Union:
+            this->fields(out, meta.as<Meta::RecordMeta>().fields);
+            break;
+        case Meta::MetaType::Function: {
+            Meta::FunctionMeta& function = meta.as<Meta::FunctionMeta>();
+            this->types(out, function.signature);
+            this->strings(out, function.parameterNames);
+            break;
+        }
+        case Meta::MetaType::EnumConstant: {
+            Meta::EnumConstantMeta& enumConstant = meta.as<Meta::EnumConstantMeta>();
+            out.push_back(this->string(enumConstant.value));
+            out.push_back(enumConstant.isScoped);
+            break;
+        }
+        case Meta::MetaType::Enum: {
+            Meta::EnumMeta& enumMeta = meta.as<Meta::EnumMeta>();
+            this->enumFields(out, enumMeta.fullNameFields);
+            this->enumFields(out, enumMeta.swiftNameFields);
+            break;
+        }
+        case Meta::MetaType::Var: {
+            Meta::VarMeta& var = meta.as<Meta::VarMeta>();
+            out.push_back(this->type(var.signature));
+            out.push_back(var.hasValue);
+            out.push_back(this->string(var.value));
+            break;
+        }
+        case Meta::MetaType::Undefined:
+            throw std::logic_error(std::string("Unable to save the meta of undefined type ") + meta.identificationString());
+        }
+    }
+
+    void writeType(Meta::Type& type, std::vector<uint32_t>& out)
+    {
+        switch (type.getType()) {
+        case Meta::TypeClass:
+            this->metas(out, type.as<Meta::ClassType>().protocols);
+            break;
+        case Meta::TypeId:
+            this->metas(out, type.as<Meta::IdType>().protocols);
+            break;
+        case Meta::TypeTypeArgument: {
+            Meta::TypeArgumentType& typeArgument = type.as<Meta::TypeArgumentType>();
+            out.push_back(this->type(typeArgument.underlyingType));
+            out.push_back(this->string(typeArgument.name));
+            this->metas(out, typeArgument.protocols);
+            break;
+        }
+        case Meta::TypeInterface: {
+            Meta::InterfaceType& interface = type.as<Meta::InterfaceType>();
+            out.push_back(this->meta(interface.interface));
+            this->metas(out, interface.protocols);
+            this->types(out, interface.typeArguments);
+            break;
+        }
+        case Meta::TypeBridgedInterface: {
+            Meta::BridgedInterfaceType& bridgedInterface = type.as<Meta::BridgedInterfaceType>();
+            out.push_back(this->string(bridgedInterface.name));
+            out.push_back(this->meta(bridgedInterface.bridgedInterface));
+            break;
+        }
+        case Meta::TypeIncompleteArray:
+            out.push_back(this->type(type.as<Meta::IncompleteArrayType>().innerType));
+            break;
+        case Meta::TypeConstantArray:
+            out.push_back(this->type(type.as<Meta::ConstantArrayType>().innerType));
+            out.push_back((uint32_t)type.as<Meta::ConstantArrayType>().size);
+            break;
+        case Meta::TypeExtVector:
+            out.push_back(this->type(type.as<Meta::ExtVectorType>().innerType));
+            out.push_back((uint32_t)type.as<Meta::ExtVectorType>().size);
+            break;
+        case Meta::TypePointer:
+            out.push_back(this->type(type.as<Meta::PointerType>().innerType));
+            break;
+        case Meta::TypeBlock:
+            this->types(out, type.as<Meta::BlockType>().signature);
+            break;
+        case Meta::TypeFunctionPointer:
+            this->types(out, type.as<Meta::FunctionPointerType>().signature);
+            break;
+        case Meta::TypeStruct:
+            out.push_back(this->meta(type.as<Meta::StructType>().structMeta));
+            break;
+        case Meta::TypeUnion:
+            out.push_back(this->meta(type.as<Meta::UnionType>().unionMeta));
+            break;
+        case Meta::TypeAnonymousStruct:
+            this->fields(out, type.as<Meta::AnonymousStructType>().fields);
+            break;
+        case Meta::TypeAnonymousUnion:
+            this->fields(out, type.as<Meta::AnonymousUnionType>().fields);
+            break;
+        case Meta::TypeEnum:
+            out.push_back(this->type(type.as<Meta::EnumType>().underlyingType));
+            out.push_back(this->meta(type.as<Meta::EnumType>().enumMeta));
+            break;
+        default:
+            // Primitive types have no record
+            break;
+        }
+    }
+
+    std::vector<const std::string*> _strings;
+    std::unordered_map<std::string, uint32_t> _stringIndices;
+    std::vector<clang::Module*> _modules;
+    std::unordered_map<clang::Module*, uint32_t> _moduleIndices;
+    std::vector<Meta::Meta*> _metas;
+    std::unordered_map<Meta::Meta*, uint32_t> _metaIndices;
+    std::vector<Meta::Type*> _types;
+    std::unordered_map<Meta::Type*, uint32_t> _typeIndices;
+};
+}
+
+/*
+ * \brief Recreates the objects of a snapshot in the order in which \c SnapshotWriter encoded them.
+ *
+ * Every index and count is checked against the size of the file, so malformed snapshots are reported
+ * with \c std::runtime_error instead of reading outside of the buffer.
+ */
+class Meta::MetaSnapshot::Reader {
+public:
+    Reader(MetaSnapshot& snapshot, llvm::StringRef data)
+        : _snapshot(snapshot)
+        , _data(data)
+    {
+    }
+
+    void read()
+    {
+        if (this->word() != SnapshotMagic) {
+            this->fail("not a metadata snapshot");
+        }
+        if (this->word() != SnapshotVersion) {
+            this->fail("unsupported snapshot version");
+        }
+        _snapshot._declarationsCount = this->word();
+
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            uint32_t size = this->word();
+            const char* bytes = this->bytes(size);
+            _strings.push_back(std::string(bytes, size));
+            this->bytes((4 - size % 4) % 4);
+        }
+
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            this->readModule();
+        }
+
+        // All metas and types are created before any record is read, because records reference each other in any order
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            _snapshot._metas.push_back(this->createMeta((MetaType)this->word()));
+        }
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            _snapshot._types.push_back(this->createType((TypeType)this->word()));
+        }
+        for (std::unique_ptr<Meta>& meta : _snapshot._metas) {
+            this->readMeta(*meta);
+        }
+        for (std::shared_ptr<Type>& type : _snapshot._types) {
+            this->readType(*type);
+        }
+
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            clang::Module* module = this->module();
+            std::vector<Meta*> metas;
+            this->metas(metas);
+            _snapshot._metasByModules.push_back(std::make_pair(module, std::move(metas)));
+        }
+
+        if (_offset != _data.size()) {
+            this->fail("unexpected data at the end of the file");
+        }
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const
+    {
+        throw std::runtime_error("Invalid snapshot at offset " + std::to_string(_offset) + ": " + message + ".");
+    }
+
+    const char* bytes(size_t size)
+    {
+        if (size > _data.size() - _offset) {
+            this->fail("unexpected end of file");
+        }
+        const char* bytes = _data.data() + _offset;
+        _offset += size;
+        return bytes;
+    }
+
+    uint32_t word()
+    {
+        const uint8_t* bytes = (const uint8_t*)this->bytes(4);
+        return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    }
+
+    // Every counted element takes at least one word, so larger counts can only come from a malformed file
+    uint32_t count()
+    {
+        uint32_t count = this->word();
+        if (count > (_data.size() - _offset) / 4) {
+            this->fail("count exceeds the size of the file");
+        }
+        return count;
+    }
+
+    bool boolean()
+    {
+        return this->word() != 0;
+    }
+
+    const std::string& string()
+    {
+        uint32_t index = this->word();
+        if (index >= _strings.size()) {
+            this->fail("invalid string index");
+        }
+        return _strings[index];
+    }
+
+    void strings(std::vector<std::string>& values)
+    {
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            values.push_back(this->string());
+        }
+    }
+
+    clang::Module* module()
+    {
+        uint32_t index = this->word();
+        if (index > _modules.size()) {
+            this->fail("invalid module index");
+        }
+        return index == 0 ? nullptr : _modules[index - 1];
+    }
+
+    Meta* meta()
+    {
+        uint32_t index = this->word();
+        if (index > _snapshot._metas.size()) {
+            this->fail("invalid meta index");
+        }
+        return index == 0 ? nullptr : _snapshot._metas[index - 1].get();
+    }
+
+    template <class T>
+    T* meta(MetaType type)
+    {
+        Meta* meta = this->meta();
+        if (meta != nullptr && !meta->is(type)) {
+            this->fail("unexpected type of the referenced meta " + meta->jsName);
+        }
+        return meta == nullptr ? nullptr : &meta->as<T>();
+    }
+
+    void metas(std::vector<Meta*>& metas)
+    {
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            metas.push_back(this->meta());
+        }
+    }
+
+    template <class T>
+    void metas(std::vector<T*>& metas, MetaType type)
+    {
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            metas.push_back(this->meta<T>(type));
+        }
+    }
+
+    Type* type()
+    {
+        uint32_t index = this->word();
+        if (index > _snapshot._types.size()) {
+            this->fail("invalid type index");
+        }
+        return index == 0 ? nullptr : _snapshot._types[index - 1].get();
+    }
+
+    void types(std::vector<Type*>& types)
+    {
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            types.push_back(this->type());
+        }
+    }
+
+    void fields(std::vector<RecordField>& fields)
+    {
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            std::string name = this->string();
+            fields.push_back(RecordField(name, this->type()));
+        }
+    }
+
+    void enumFields(std::vector<EnumField>& fields)
+    {
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            EnumField field;
+            field.name = this->string();
+            field.value = this->string();
+            fields.push_back(field);
+        }
+    }
+
+    void version(Version& version)
+    {
+        version.Major = (int)this->word();
+        version.Minor = (int)this->word();
+        version.SubMinor = (int)this->word();
+    }
+
+    void readModule()
+    {
+        std::string name = this->string();
+        clang::Module* parent = this->module();
+        uint32_t flags = this->word();
+        const std::string& directory = this->string();
+
+        // A module registers itself in the submodules of its parent, which deletes it
+        clang::Module* module = new clang::Module(name, clang::SourceLocation(), parent, flags & ModuleIsFramework, flags & ModuleIsExplicit, 0);
+        if (parent == nullptr) {
+            _snapshot._modules.push_back(std::unique_ptr<clang::Module>(module));
+        }
+        module->IsSystem = (flags & ModuleIsSystem) != 0;
+        // The directory is null if it no longer exists, like the directory of a module without a module map
+        module->Directory = directory.empty() ? nullptr : _snapshot._fileManager.getDirectory(directory);
+
+        for (uint32_t i = 0, count = this->count(); i < count; i++) {
+            std::string library = this->string();
+            module->LinkLibraries.push_back(clang::Module::LinkLibrary(library, this->boolean()));
+        }
+        _modules.push_back(module);
+    }
+
+    std::unique_ptr<Meta> createMeta(MetaType type)
+    {
+        switch (type) {
+        case MetaType::Struct:
+            return std::unique_ptr<Meta>(new StructMeta());
+        case MetaType::Union:
+            return std::unique_ptr<Meta>(new UnionMeta());
+        case MetaType::Function:
+            return std::unique_ptr<Meta>(new FunctionMeta());
+        case MetaType::Enum:
+            return std::unique_ptr<Meta>(new EnumMeta());
+        case MetaType::Var:
+            return std::unique_ptr<Meta>(new VarMeta());
+        case MetaType::Interface:
+            return std::unique_ptr<Meta>(new InterfaceMeta());
+        case MetaType::Protocol:
+            return std::unique_ptr<Meta>(new ProtocolMeta());
+        case MetaType::Category:
+            return std::unique_ptr<Meta>(new CategoryMeta());
+        case MetaType::Method:
+            return std::unique_ptr<Meta>(new MethodMeta());
+        case MetaType::Property:
+            return std::unique_ptr<Meta>(new PropertyMeta());
+        case MetaType::EnumConstant:
+            return std::unique_ptr<Meta>(new EnumConstantMeta());
+        default:
+            this->fail("invalid meta type " + std::to_string(type));
+        }
+    }
+
+    void readBaseClass(BaseClassMeta& meta)
+    {
+        this->metas(meta.instanceMethods, MetaType::Method);
+        this->metas(meta.staticMethods, MetaType::Method);
+        this->metas(meta.instanceProperties, MetaType::Property);
+        this->metas(meta.staticProperties, MetaType::Property);
+        this->metas(meta.protocols, MetaType::Protocol);
+    }
+
+    void readMeta(Meta& meta)
+    {
+        meta.flags = (MetaFlags)this->word();
+        meta.name = this->string();
+        meta.demangledName = this->string();
+        meta.jsName = this->string();
+        meta.fileName = this->string();
+        meta.module = this->module();
+        this->version(meta.introducedIn);
+        this->version(meta.obsoletedIn);
+        this->version(meta.deprecatedIn);
+
+        switch (meta.type) {
+        case MetaType::Method: {
+            MethodMeta& method = meta.as<MethodMeta>();
+            this->types(method.signature);
+            method.constructorTokens = this->string();
+            this->strings(method.parameterNames);
+            method.isInstanceMethod = this->boolean();
+            break;
+        }
+        case MetaType::Property: {
+            PropertyMeta& property = meta.as<PropertyMeta>();
+            property.getter = this->meta<MethodMeta>(MetaType::Method);
+            property.setter = this->meta<MethodMeta>(MetaType::Method);
+            property.isClassProperty = this->boolean();
+            break;
+        }
+        case MetaType::Protocol:
+            this->readBaseClass(meta.as<ProtocolMeta>());
+            break;
+        case MetaType::Category: {
+            CategoryMeta& category = meta.as<CategoryMeta>();
+            this->readBaseClass(category);
+            category.extendedInterface = this->meta<InterfaceMeta>(MetaType::Interface);
+            break;
+        }
+        case MetaType::Interface: {
+            InterfaceMeta& interface = meta.as<InterfaceMeta>();
+            this->readBaseClass(interface);
+            interface.base = this->meta<InterfaceMeta>(MetaType::Interface);
+            this->strings(interface.typeParameters);
+            this->types(interface.baseTypeArguments);
+            break;
+        }
+        case MetaType::Struct:
+        case MetaType::Union:
+            this->fields(meta.as<RecordMeta>().fields);
+            break;
+        case MetaType::Function: {
+            FunctionMeta& function = meta.as<FunctionMeta>();
+            this->types(function.signature);
+            this->strings(function.parameterNames);
+            break;
+        }
+        case MetaType::EnumConstant: {
+            EnumConstantMeta& enumConstant = meta.as<EnumConstantMeta>();
+            enumConstant.value = this->string();
+            enumConstant.isScoped = this->boolean();
+            break;
+        }
+        case MetaType::Enum: {
+            EnumMeta& enumMeta = meta.as<EnumMeta>();
+            this->enumFields(enumMeta.fullNameFields);
+            this->enumFields(enumMeta.swiftNameFields);
+            break;
+        }
+        case MetaType::Var: {
+            VarMeta& var = meta.as<VarMeta>();
+            var.signature = this->type();
+            var.hasValue = this->boolean();
+            var.value = this->string();
+            break;
+        }
+        case MetaType::Undefined:
+            this->fail("invalid meta type");
+        }
+    }
+
+    std::shared_ptr<Type> createType(TypeType type)
+    {
+        switch (type) {
+        case TypeClass:
+            return std::make_shared<ClassType>();
+        case TypeId:
+            return std::make_shared<IdType>();
+        case TypeTypeArgument:
+            return std::make_shared<TypeArgumentType>(nullptr, "");
+        case TypeInterface:
+            return std::make_shared<InterfaceType>(nullptr, std::vector<ProtocolMeta*>(), std::vector<Type*>());
+        case TypeBridgedInterface:
+            return std::make_shared<BridgedInterfaceType>("", nullptr);
+        case TypeIncompleteArray:
+            return std::make_shared<IncompleteArrayType>(nullptr);
+        case TypeConstantArray:
+            return std::make_shared<ConstantArrayType>(nullptr, 0);
+        case TypeExtVector:
+            return std::make_shared<ExtVectorType>(nullptr, 0);
+        case TypePointer:
+            return std::make_shared<PointerType>(nullptr);
+        case TypeBlock:
+            return std::make_shared<BlockType>(std::vector<Type*>());
+        case TypeFunctionPointer:
+            return std::make_shared<FunctionPointerType>(std::vector<Type*>());
+        case TypeStruct:
+            return std::make_shared<StructType>(nullptr);
+        case TypeUnion:
+            return std::make_shared<UnionType>(nullptr);
+        case TypeAnonymousStruct:
+            return std::make_shared<AnonymousStructType>(std::vector<RecordField>());
+        case TypeAnonymousUnion:
+            return std::make_shared<AnonymousUnionType>(std::vector<RecordField>());
+        case TypeEnum:
+            return std::make_shared<EnumType>(nullptr, nullptr);
+        default:
+            if (type > TypeExtVector) {
+                this->fail("invalid type kind " + std::to_string(type));
+            }
+            // Primitive types have no data besides their kind
+            return std::make_shared<Type>(type);
+        }
+    }
+
+    void readType(Type& type)
+    {
+        switch (type.getType()) {
+        case TypeClass:
+            this->metas(type.as<ClassType>().protocols, MetaType::Protocol);
+            break;
+        case TypeId:
+            this->metas(type.as<IdType>().protocols, MetaType::Protocol);
+            break;
+        case TypeTypeArgument: {
+            TypeArgumentType& typeArgument = type.as<TypeArgumentType>();
+            typeArgument.underlyingType = this->type();
+            typeArgument.name = this->string();
+            this->metas(typeArgument.protocols, MetaType::Protocol);
+            break;
+        }
+        case TypeInterface: {
+            InterfaceType& interface = type.as<InterfaceType>();
+            interface.interface = this->meta<InterfaceMeta>(MetaType::Interface);
+            this->metas(interface.protocols, MetaType::Protocol);
+            this->types(interface.typeArguments);
+            break;
+        }
+        case TypeBridgedInterface: {
+            BridgedInterfaceType& bridgedInterface = type.as<BridgedInterfaceType>();
+            bridgedInterface.name = this->string();
+            bridgedInterface.bridgedInterface = this->meta<InterfaceMeta>(MetaType::Interface);
+            break;
+        }
+        case TypeIncompleteArray:
+            type.as<IncompleteArrayType>().innerType = this->type();
+            break;
+        case TypeConstantArray:
+            type.as<ConstantArrayType>().innerType = this->type();
+            type.as<ConstantArrayType>().size = (int)this->word();
+            break;
+        case TypeExtVector:
+            type.as<ExtVectorType>().innerType = this->type();
+            type.as<ExtVectorType>().size = (int)this->word();
+            break;
+        case TypePointer:
+            type.as<PointerType>().innerType = this->type();
+            break;
+        case TypeBlock:
+            this->types(type.as<BlockType>().signature);
+            break;
+        case TypeFunctionPointer:
+            this->types(type.as<FunctionPointerType>().signature);
+            break;
+        case TypeStruct:
+            type.as<StructType>().structMeta = this->meta<StructMeta>(MetaType::Struct);
+            break;
+        case TypeUnion:
+            type.as<UnionType>().unionMeta = this->meta<UnionMeta>(MetaType::Union);
+            break;
+        case TypeAnonymousStruct:
+            this->fields(type.as<AnonymousStructType>().fields);
+            break;
+        case TypeAnonymousUnion:
+            this->fields(type.as<AnonymousUnionType>().fields);
+            break;
+        case TypeEnum:
+            type.as<EnumType>().underlyingType = this->type();
+            type.as<EnumType>().enumMeta = this->meta<EnumMeta>(MetaType::Enum);
+            break;
+        default:
+            break;
+        }
+    }
+
+    MetaSnapshot& _snapshot;
+    llvm::StringRef _data;
+    size_t _offset = 0;
+    std::vector<std::string> _strings;
+
+    // All modules in the order of the module table, including submodules
+    std::vector<clang::Module*> _modules;
+};
+
+void Meta::MetaSnapshot::save(const std::string& filePath, MetasByModules& metasByModules, size_t declarationsCount)
+{
+    std::string contents = saveToString(metasByModules, declarationsCount);
+
+    std::error_code errorCode;
+    llvm::raw_fd_ostream fileStream(filePath, errorCode, llvm::sys::fs::OpenFlags::F_None);
+    if (errorCode)
+        throw std::runtime_error(std::string("Unable to open file ") + filePath + ".");
+    fileStream << contents;
+    fileStream.close();
+    if (fileStream.has_error()) {
+        fileStream.clear_error();
+        throw std::runtime_error(std::string("Unable to write file ") + filePath + ".");
+    }
+}
+
+std::unique_ptr<Meta::MetaSnapshot> Meta::MetaSnapshot::load(const std::string& filePath)
+{
+    // The file is memory mapped and only the strings are copied out of it
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > buffer = llvm::MemoryBuffer::getFile(filePath, -1, false);
+    if (!buffer) {
+        throw std::runtime_error("Unable to read snapshot " + filePath + ": " + buffer.getError().message() + ".");
+    }
+
+    std::unique_ptr<MetaSnapshot> snapshot(new MetaSnapshot());
+    Reader(*snapshot, buffer.get()->getBuffer()).read();
+    return snapshot;
+}
+
+std::string Meta::MetaSnapshot::saveToString(MetasByModules& metasByModules, size_t declarationsCount)
+{
+    return SnapshotWriter().write(metasByModules, declarationsCount);
+}
+
+std::unique_ptr<Meta::MetaSnapshot> Meta::MetaSnapshot::loadFromString(const std::string& contents)
+{
+    std::unique_ptr<MetaSnapshot> snapshot(new MetaSnapshot());
+    Reader(*snapshot, contents).read();
+    return snapshot;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Filters/ResolveGlobalNamesCollisionsFilter.h"
+#include "MetaEntities.h"
+#include "Utils/Noncopyable.h"
+#include <clang/Basic/FileManager.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Meta {
+/*
+ * \class MetaSnapshot
+ * \brief Saves the filtered metas of all modules and loads them back without parsing any headers.
+ *
+ * A snapshot is a sequence of little-endian 32 bit words: a deduplicated string table followed by
+ * the module, meta and type tables, in which all cross references are indices. A loaded snapshot owns
+ * the modules, metas and types it recreates. Declarations aren't saved, so \c Meta::declaration is null
+ * for all loaded metas.
+ */
+class MetaSnapshot {
+    MAKE_NONCOPYABLE(MetaSnapshot);
+
+public:
+    typedef ResolveGlobalNamesCollisionsFilter::MetasByModules MetasByModules;
+
+    /*
+     * \brief Writes the metas of the modules, and all metas and types reachable from them, to a file.
+     * \param declarationsCount The number of declarations before the metas were grouped by modules
+     */
+    static void save(const std::string& filePath, MetasByModules& metasByModules, size_t declarationsCount);
+
+    /*
+     * \brief Reads a snapshot written by \c save. Unreadable or malformed files are reported with \c std::runtime_error.
+     */
+    static std::unique_ptr<MetaSnapshot> load(const std::string& filePath);
+
+    /*
+     * \brief Returns the contents of the snapshot file which \c save would write.
+     */
+    static std::string saveToString(MetasByModules& metasByModules, size_t declarationsCount);
+
+    /*
+     * \brief Reads a snapshot from the contents returned by \c saveToString.
+     */
+    static std::unique_ptr<MetaSnapshot> loadFromString(const std::string& contents);
+
+    MetasByModules& getMetasByModules()
+    {
+        return _metasByModules;
+    }
+
+    size_t getDeclarationsCount() const
+    {
+        return _declarationsCount;
+    }
+
+private:
+    class Reader;
+
+    MetaSnapshot()
+        : _fileManager(clang::FileSystemOptions())
+    {
+    }
+
+    // Resolves the directories of the loaded framework modules
+    clang::FileManager _fileManager;
+
+    // Only top level modules are owned here, submodules are deleted by their parents
+    std::vector<std::unique_ptr<clang::Module> > _modules;
+    std::vector<std::unique_ptr<Meta> > _metas;
+    std::vector<std::shared_ptr<Type> > _types;
+    MetasByModules _metasByModules;
+    size_t _declarationsCount = 0;
+};
+}
@@ -3,17 +3,30 @@
 #include "MetaFactory.h"
 #include "Utils.h"
 #include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringMap.h>
 
 namespace Meta {
 using namespace std;
 
-static const std::vector<std::string> KNOWN_BRIDGED_TYPES = {
-#define CF_TYPE(NAME) #NAME,
+// Maps the names of the typedefs which are created specially to their kinds
+static const llvm::StringMap<uint8_t>& getSpecialTypedefNames()
+{
+    static const llvm::StringMap<uint8_t> names = []() {
+        llvm::StringMap<uint8_t> result;
+        for (const char* name : { "BOOL", "Boolean", "bool" }) {
+            result[name] |= TypeFactory::SpecialTypedefBool;
+        }
+        result["unichar"] |= TypeFactory::SpecialTypedefUnichar;
+        result["__builtin_va_list"] |= TypeFactory::SpecialTypedefVaList;
+#define CF_TYPE(NAME) result[#NAME] |= TypeFactory::SpecialTypedefKnownBridged;
 #define NON_CF_TYPE(NAME)
 #include "CFDatabase.def"
 #undef CF_TYPE
 #undef NON_CF_TYPE
-};
+        return result;
+    }();
+    return names;
+}
 
 shared_ptr<Type> TypeFactory::getVoid()
 {
@@ -135,27 +148,60 @@ shared_ptr<Type> TypeFactory::getProtocolType()
     return type;
 }
 
+CreationFailure TypeFactory::cacheException(const clang::Type* type, CreationFailure exception, bool overwrite)
+{
+    pair<Cache::iterator, bool> insertionResult = _cache.emplace(type, CacheEntry());
+    if (insertionResult.second || overwrite) {
+        insertionResult.first->second.exception = std::move(exception);
+    }
+    return insertionResult.first->second.exception;
+}
+
 shared_ptr<Type> TypeFactory::create(const clang::Type* type)
 {
-    const clang::Type& typeRef = *type;
+    CreationResult<shared_ptr<Type> > result = this->tryCreate(type);
+    if (!result) {
+        POLYMORPHIC_THROW(result.getFailure());
+    }
+    return result.get();
+}
+
+CreationResult<shared_ptr<Type> > TypeFactory::tryCreate(const clang::Type* type)
+{
     shared_ptr<Type> resultType(nullptr);
 
-    try {
-        // check for cached Type
-        Cache::const_iterator cachedTypeIt = _cache.find(type);
-        if (cachedTypeIt != _cache.end()) {
-            shared_ptr<Type> resultType = cachedTypeIt->second.first;
-            if (auto creationException = cachedTypeIt->second.second.get()) {
-                POLYMORPHIC_THROW(creationException);
+    // check for cached Type
+    Cache::iterator cachedTypeIt = _cache.find(type);
+    if (cachedTypeIt != _cache.end()) {
+        CacheEntry& entry = cachedTypeIt->second;
+        if (entry.exception != nullptr) {
+            return entry.exception;
+        }
+        shared_ptr<Type> resultType = entry.type;
+
+        // revalidate in case the Type's metadata creation has failed after it was returned
+        // (e.g. from a forward declaration). Validation is skipped if no metadata creation has failed since the last one.
+        uint64_t generation = this->_metaFactory->getValidationGeneration();
+        if (entry.validatedGeneration != generation) {
+            std::vector<const clang::Decl*> dependencies;
+            CreationFailure failure = this->_metaFactory->validate(resultType.get(), dependencies);
+            if (failure != nullptr) {
+                return cacheException(type, make_shared<TypeCreationException>(type, CreationFailureReason::MetaDependency, failure), true);
             }
+            // The entry is never erased and references to unordered_map elements survive rehashing, so it is still valid
+            entry.validatedGeneration = generation;
+            entry.dependencies = std::move(dependencies);
+        }
 
-            // revalidate in case the Type's metadata creation has failed after it was returned
-            // (e.g. from a forward declaration)
-            this->_metaFactory->validate(resultType.get());
+        // The meta being created depends on the metas referenced by the type
+        this->_metaFactory->addDependencies(entry.dependencies);
 
-            return resultType;
-        }
+        return resultType;
+    }
 
+    // The types which depend on other types and metas are built with the throwing create methods.
+    // A failure is thrown at most once per type, because it is cached and returned by the next lookups.
+    try {
         if (const clang::BuiltinType* concreteType = clang::dyn_cast<clang::BuiltinType>(type))
             resultType = createFromBuiltinType(concreteType);
         else if (const clang::TypedefType* concreteType = clang::dyn_cast<clang::TypedefType>(type))
@@ -193,43 +239,46 @@ shared_ptr<Type> TypeFactory::create(const clang::Type* type)
         else if (const clang::ObjCTypeParamType* concreteType = clang::dyn_cast<clang::ObjCTypeParamType>(type))
             resultType = createFromObjCTypeParamType(concreteType);
         else
-            throw TypeCreationException(type, "Unable to create encoding for this type.", true);
+            return cacheException(type, make_shared<TypeCreationException>(type, CreationFailureReason::UnsupportedType, "Unable to create encoding for this type.", true), false);
     }
     catch (TypeCreationException& e) {
         if (e.getType() == type) {
-            _cache.insert(make_pair(&typeRef, make_pair(nullptr, llvm::make_unique<TypeCreationException>(e))));
-            throw;
-        };
-        pair<Cache::iterator, bool> insertionResult = _cache.insert(make_pair(&typeRef, make_pair(nullptr, nullptr)));
-        string message = CreationException::constructMessage("Can't create type dependency.", e.getDetailedMessage());
-        insertionResult.first->second.second = llvm::make_unique<TypeCreationException>(type, message, e.isError());
-        POLYMORPHIC_THROW(insertionResult.first->second.second);
+            return cacheException(type, make_shared<TypeCreationException>(e), false);
+        }
+        return cacheException(type, make_shared<TypeCreationException>(type, CreationFailureReason::TypeDependency, make_shared<TypeCreationException>(e)), true);
     }
     catch (MetaCreationException& e) {
-        pair<Cache::iterator, bool> insertionResult = _cache.insert(make_pair(&typeRef, make_pair(nullptr, nullptr)));
-        string message = CreationException::constructMessage("Can't create meta dependency.", e.getDetailedMessage());
-        insertionResult.first->second.second = llvm::make_unique<TypeCreationException>(type, message, e.isError());
-        POLYMORPHIC_THROW(insertionResult.first->second.second);
+        return cacheException(type, make_shared<TypeCreationException>(type, CreationFailureReason::MetaDependency, make_shared<MetaCreationException>(e)), true);
     }
 
     assert(resultType != nullptr);
-    pair<Cache::iterator, bool> insertionResult = _cache.insert(make_pair(&typeRef, make_pair(nullptr, nullptr)));
+    resultType = _interner.intern(resultType);
+    pair<Cache::iterator, bool> insertionResult = _cache.emplace(type, CacheEntry());
     if (insertionResult.second) {
-        assert(insertionResult.first->second.first.get() == nullptr);
-        insertionResult.first->second.first = resultType;
+        insertionResult.first->second.type = resultType;
         return resultType;
     }
     else {
-        return insertionResult.first->second.first;
+        // The type has been created while creating its dependencies
+        return insertionResult.first->second.type;
     }
 }
 
 shared_ptr<Type> TypeFactory::create(const clang::QualType& type)
+{
+    CreationResult<shared_ptr<Type> > result = this->tryCreate(type);
+    if (!result) {
+        POLYMORPHIC_THROW(result.getFailure());
+    }
+    return result.get();
+}
+
+CreationResult<shared_ptr<Type> > TypeFactory::tryCreate(const clang::QualType& type)
 {
     const clang::Type* typePtr = type.getTypePtrOrNull();
     if (typePtr)
-        return this->create(typePtr);
-    throw TypeCreationException(nullptr, "Unable to get the inner type of qualified type.", true);
+        return this->tryCreate(typePtr);
+    return CreationFailure(make_shared<TypeCreationException>(nullptr, CreationFailureReason::InvalidType, "Unable to get the inner type of qualified type.", true));
 }
 
 shared_ptr<ConstantArrayType> TypeFactory::createFromConstantArrayType(const clang::ConstantArrayType* type)
@@ -293,7 +342,7 @@ shared_ptr<Type> TypeFactory::createFromBuiltinType(const clang::BuiltinType* ty
     // This is also valid for ObjCClass type.
 
     default:
-        throw TypeCreationException(type, string("Not supported builtin type(") + type->getTypeClassName() + ").", true);
+        throw TypeCreationException(type, CreationFailureReason::UnsupportedType, "Not supported builtin type.", true);
     }
 }
 
@@ -302,10 +351,12 @@ shared_ptr<Type> TypeFactory::createFromObjCObjectPointerType(const clang::ObjCO
     vector<ProtocolMeta*> protocols;
     for (clang::ObjCProtocolDecl* qual : type->quals()) {
         clang::ObjCProtocolDecl* protocolDef = qual->getDefinition();
-        Meta* protocolMeta = nullptr;
-        if (protocolDef != nullptr && _metaFactory->tryCreate(*protocolDef, &protocolMeta)) {
-            assert(protocolMeta->is(MetaType::Protocol));
-            protocols.push_back(&protocolMeta->as<ProtocolMeta>());
+        if (protocolDef == nullptr) {
+            continue;
+        }
+        if (CreationResult<Meta*> protocolMeta = _metaFactory->tryCreate(*protocolDef)) {
+            assert(protocolMeta.get()->is(MetaType::Protocol));
+            protocols.push_back(&protocolMeta.get()->as<ProtocolMeta>());
         }
     }
     if (type->isObjCIdType() || type->isObjCQualifiedIdType()) {
@@ -329,7 +380,7 @@ shared_ptr<Type> TypeFactory::createFromObjCObjectPointerType(const clang::ObjCO
         }
     }
 
-    throw TypeCreationException(type, "Invalid interface pointer type.", true);
+    throw TypeCreationException(type, CreationFailureReason::InvalidType, "Invalid interface pointer type.", true);
 }
 
 shared_ptr<Type> TypeFactory::createFromPointerType(const clang::PointerType* type)
@@ -369,9 +420,9 @@ shared_ptr<Type> TypeFactory::createFromRecordType(const clang::RecordType* type
         return TypeFactory::getVoid();
     }
     if (recordDef->isUnion())
-        throw TypeCreationException(type, "The record is an union.", true);
+        throw TypeCreationException(type, CreationFailureReason::Union, "The record is an union.", true);
     if (!recordDef->isStruct())
-        throw TypeCreationException(type, "The record is not a struct.", true);
+        throw TypeCreationException(type, CreationFailureReason::NotAStruct, "The record is not a struct.", true);
     const clang::TagDecl* tagDecl = clang::dyn_cast<clang::TagDecl>(type->getDecl());
     if (MetaFactory::getTypedefOrOwnName(tagDecl) == "") {
         // The record is anonymous
@@ -414,17 +465,17 @@ static shared_ptr<Type> tryCreateFromBridgedType(const clang::Type* type)
 
 shared_ptr<Type> TypeFactory::createFromTypedefType(const clang::TypedefType* type)
 {
-    vector<string> boolTypedefs{ "BOOL", "Boolean", "bool"};
-    if (isSpecificTypedefType(type, boolTypedefs))
+    uint8_t specialKinds = this->getSpecialTypedefKinds(type->getDecl());
+    if (specialKinds & SpecialTypedefBool)
         return TypeFactory::getBool();
-    if (isSpecificTypedefType(type, "unichar"))
+    if (specialKinds & SpecialTypedefUnichar)
         return TypeFactory::getUnichar();
-    if (isSpecificTypedefType(type, "__builtin_va_list"))
-        throw TypeCreationException(type, "VaList type is not supported.", true);
+    if (specialKinds & SpecialTypedefVaList)
+        throw TypeCreationException(type, CreationFailureReason::UnsupportedType, "VaList type is not supported.", true);
     if (auto bridgedInterfaceType = tryCreateFromBridgedType(type->getDecl()->getUnderlyingType().getTypePtrOrNull())) {
         return bridgedInterfaceType;
     }
-    if (isSpecificTypedefType(type, KNOWN_BRIDGED_TYPES)) {
+    if (specialKinds & SpecialTypedefKnownBridged) {
         return make_shared<BridgedInterfaceType>("id", nullptr);
     }
     return this->create(type->getDecl()->getUnderlyingType());
@@ -437,7 +488,7 @@ shared_ptr<Type> TypeFactory::createFromExtVectorType(const clang::ExtVectorType
 
 shared_ptr<Type> TypeFactory::createFromVectorType(const clang::VectorType* type)
 {
-    throw TypeCreationException(type, "Vector type is not supported.", true);
+    throw TypeCreationException(type, CreationFailureReason::UnsupportedType, "Vector type is not supported.", true);
 }
 
 shared_ptr<Type> TypeFactory::createFromElaboratedType(const clang::ElaboratedType* type)
@@ -483,62 +534,77 @@ shared_ptr<Type> TypeFactory::createFromObjCTypeParamType(const clang::ObjCTypeP
     vector<ProtocolMeta*> protocols;
     for (clang::ObjCProtocolDecl* decl : type->getProtocols()) {
         clang::ObjCProtocolDecl* protocolDef = decl->getDefinition();
-        Meta* protocolMeta = nullptr;
-        if (protocolDef != nullptr && _metaFactory->tryCreate(*protocolDef, &protocolMeta)) {
-            assert(protocolMeta->is(MetaType::Protocol));
-            protocols.push_back(&protocolMeta->as<ProtocolMeta>());
+        if (protocolDef == nullptr) {
+            continue;
+        }
+        if (CreationResult<Meta*> protocolMeta = _metaFactory->tryCreate(*protocolDef)) {
+            assert(protocolMeta.get()->is(MetaType::Protocol));
+            protocols.push_back(&protocolMeta.get()->as<ProtocolMeta>());
         }
     }
 
     return make_shared<TypeArgumentType>(this->create(typeParamDecl->getUnderlyingType()).get(), typeParamDecl->getNameAsString(), protocols);
 }
 
-bool TypeFactory::isSpecificTypedefType(const clang::TypedefType* type, const string& typedefName)
+uint8_t TypeFactory::getSpecialTypedefKinds(const clang::TypedefNameDecl* decl)
 {
-    const vector<string> typedefNames{ typedefName };
-    return this->isSpecificTypedefType(type, typedefNames);
-}
+    const llvm::StringMap<uint8_t>& specialNames = getSpecialTypedefNames();
 
-bool TypeFactory::isSpecificTypedefType(const clang::TypedefType* type, const vector<string>& typedefNames)
-{
-    clang::TypedefNameDecl* decl = type->getDecl();
+    // Walk the chain of typedefs until a declaration whose kinds are already known
+    vector<const clang::TypedefNameDecl*> chain;
+    uint8_t kinds = 0;
     while (decl) {
-        if (find(typedefNames.begin(), typedefNames.end(), decl->getNameAsString()) != typedefNames.end()) {
-            return true;
+        unordered_map<const clang::TypedefNameDecl*, uint8_t>::const_iterator it = _specialTypedefKinds.find(decl);
+        if (it != _specialTypedefKinds.end()) {
+            kinds = it->second;
+            break;
         }
+        chain.push_back(decl);
 
-        clang::Type const* innerType = decl->getUnderlyingType().getTypePtr();
-        if (const clang::TypedefType* innerTypedef = clang::dyn_cast<clang::TypedefType>(innerType)) {
-            decl = innerTypedef->getDecl();
-        }
-        else {
-            return false;
+        const clang::Type* innerType = decl->getUnderlyingType().getTypePtr();
+        const clang::TypedefType* innerTypedef = clang::dyn_cast<clang::TypedefType>(innerType);
+        decl = innerTypedef ? innerTypedef->getDecl() : nullptr;
+    }
+
+    // A typedef has the kinds of its own name and of all typedefs it is declared with
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (const clang::IdentifierInfo* identifier = (*it)->getIdentifier()) {
+            llvm::StringMap<uint8_t>::const_iterator nameIt = specialNames.find(identifier->getName());
+            if (nameIt != specialNames.end()) {
+                kinds |= nameIt->second;
+            }
         }
+        _specialTypedefKinds[*it] = kinds;
     }
-    return false;
+    return kinds;
 }
 
 void TypeFactory::resolveCachedBridgedInterfaceTypes(unordered_map<string, InterfaceMeta*>& interfaceMap)
 {
     unordered_map<string, InterfaceMeta*>::const_iterator nsObjectIt = interfaceMap.find("NSObject");
     for (Cache::value_type& typeEntry : _cache) {
-        if (typeEntry.second.second.get() == nullptr) {
-            Type* type = typeEntry.second.first.get();
-            if (type->is(TypeType::TypeBridgedInterface)) {
-                BridgedInterfaceType* bridgedType = &type->as<BridgedInterfaceType>();
-                if (!bridgedType->isId()) {
-                    unordered_map<string, InterfaceMeta*>::const_iterator it = interfaceMap.find(bridgedType->name);
-                    if (it != interfaceMap.end()) {
-                        bridgedType->bridgedInterface = it->second;
-                    }
-                    else {
-                        assert(nsObjectIt != interfaceMap.end());
-                        bridgedType->bridgedInterface = nsObjectIt->second;
-                        cout << "Unable to resolve bridged interface type. Interface " << bridgedType->name << " not found. NSObject used instead." << endl;
-                    }
+        if (typeEntry.second.exception.get() != nullptr || typeEntry.second.type == nullptr) {
+            continue;
+        }
+
+        Type* type = typeEntry.second.type.get();
+        if (type->is(TypeType::TypeBridgedInterface)) {
+            BridgedInterfaceType* bridgedType = &type->as<BridgedInterfaceType>();
+            if (!bridgedType->isId()) {
+                unordered_map<string, InterfaceMeta*>::const_iterator it = interfaceMap.find(bridgedType->name);
+                if (it != interfaceMap.end()) {
+                    bridgedType->bridgedInterface = it->second;
+                }
+                else {
+                    assert(nsObjectIt != interfaceMap.end());
+                    bridgedType->bridgedInterface = nsObjectIt->second;
+                    cout << "Unable to resolve bridged interface type. Interface " << bridgedType->name << " not found. NSObject used instead." << endl;
                 }
             }
         }
     }
+
+    // The resolved interfaces are now part of the types, so they have to be validated again
+    _metaFactory->invalidateValidatedTypes();
 }
 }
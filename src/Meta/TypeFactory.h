@@ -3,6 +3,7 @@
 #include "CreationException.h"
 #include "MetaEntities.h"
 #include "TypeEntities.h"
+#include "TypeInterner.h"
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <unordered_map>
 
@@ -11,6 +12,19 @@ class MetaFactory;
 
 class TypeFactory {
 public:
+    /*
+     * \brief The typedefs which aren't created from their underlying types.
+     *
+     * A typedef is of a kind if its name or the name of any typedef in its chain is one of the special names.
+     */
+    enum SpecialTypedefKind : uint8_t {
+        SpecialTypedefBool = 1 << 0,
+        SpecialTypedefUnichar = 1 << 1,
+        SpecialTypedefVaList = 1 << 2,
+        // The CoreFoundation types from CFDatabase.def, which are bridged to id
+        SpecialTypedefKnownBridged = 1 << 3
+    };
+
     TypeFactory(MetaFactory* metaFactory)
         : _metaFactory(metaFactory)
         , _cache()
@@ -61,6 +75,14 @@ public:
 
     std::shared_ptr<Type> create(const clang::QualType& type);
 
+    /*
+     * \brief Creates the type or returns the cached one, without throwing if the creation fails.
+     * \return The type or the (cached) reason of the failure.
+     */
+    CreationResult<std::shared_ptr<Type> > tryCreate(const clang::Type* type);
+
+    CreationResult<std::shared_ptr<Type> > tryCreate(const clang::QualType& type);
+
     void resolveCachedBridgedInterfaceTypes(std::unordered_map<std::string, InterfaceMeta*>& interfaceMap);
 
 private:
@@ -101,12 +123,32 @@ private:
     std::shared_ptr<Type> createFromObjCTypeParamType(const clang::ObjCTypeParamType* type);
 
     // helpers
-    bool isSpecificTypedefType(const clang::TypedefType* type, const std::string& typedefName);
+    /*
+     * \brief Returns the \c SpecialTypedefKind flags of the typedef. They are resolved once per declaration.
+     */
+    uint8_t getSpecialTypedefKinds(const clang::TypedefNameDecl* decl);
+
+    struct CacheEntry {
+        std::shared_ptr<Type> type;
+        CreationFailure exception;
+
+        // The validation generation of the MetaFactory in which the type was last successfully validated
+        uint64_t validatedGeneration = 0;
 
-    bool isSpecificTypedefType(const clang::TypedefType* type, const std::vector<std::string>& typedefNames);
+        // The declarations of the metas referenced by the type, collected during its last validation
+        std::vector<const clang::Decl*> dependencies;
+    };
+
+    typedef std::unordered_map<const clang::Type*, CacheEntry> Cache;
+
+    CreationFailure cacheException(const clang::Type* type, CreationFailure exception, bool overwrite);
 
     MetaFactory* _metaFactory;
-    typedef std::unordered_map<const clang::Type*, std::pair<std::shared_ptr<Type>, std::unique_ptr<CreationException> > > Cache;
     Cache _cache;
+
+    // Types created from different clang types (e.g. through typedefs) share one instance if they are structurally equal
+    TypeInterner _interner;
+
+    std::unordered_map<const clang::TypedefNameDecl*, uint8_t> _specialTypedefKinds;
 };
 }
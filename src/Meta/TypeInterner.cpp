@@ -0,0 +1,161 @@
+#include "TypeInterner.h"
+#include <llvm/ADT/Hashing.h>
+
+namespace Meta {
+static llvm::hash_code hashRecordFields(const std::vector<RecordField>& fields)
+{
+    llvm::hash_code result = llvm::hash_value(fields.size());
+    for (const RecordField& field : fields) {
+        result = llvm::hash_combine(result, field.name, field.encoding);
+    }
+    return result;
+}
+
+static bool areRecordFieldsEqual(const std::vector<RecordField>& fields1, const std::vector<RecordField>& fields2)
+{
+    if (fields1.size() != fields2.size()) {
+        return false;
+    }
+    for (std::vector<RecordField>::size_type i = 0; i < fields1.size(); i++) {
+        if (fields1[i].name != fields2[i].name || fields1[i].encoding != fields2[i].encoding) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<Type> TypeInterner::intern(const std::shared_ptr<Type>& type)
+{
+    size_t typeHash = hash(*type);
+
+    auto range = _types.equal_range(typeHash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == type || areFieldsEqual(*it->second, *type)) {
+            return it->second;
+        }
+    }
+    _types.emplace(typeHash, type);
+    return type;
+}
+
+size_t TypeInterner::hash(const Type& type)
+{
+    llvm::hash_code result = llvm::hash_value(type.getType());
+    switch (type.getType()) {
+    case TypeType::TypeClass: {
+        const std::vector<ProtocolMeta*>& protocols = type.as<ClassType>().protocols;
+        return llvm::hash_combine(result, llvm::hash_combine_range(protocols.begin(), protocols.end()));
+    }
+    case TypeType::TypeId: {
+        const std::vector<ProtocolMeta*>& protocols = type.as<IdType>().protocols;
+        return llvm::hash_combine(result, llvm::hash_combine_range(protocols.begin(), protocols.end()));
+    }
+    case TypeType::TypeTypeArgument: {
+        const TypeArgumentType& argType = type.as<TypeArgumentType>();
+        return llvm::hash_combine(result, argType.underlyingType, argType.name, llvm::hash_combine_range(argType.protocols.begin(), argType.protocols.end()));
+    }
+    case TypeType::TypeInterface: {
+        const InterfaceType& interfaceType = type.as<InterfaceType>();
+        return llvm::hash_combine(result, interfaceType.interface,
+            llvm::hash_combine_range(interfaceType.protocols.begin(), interfaceType.protocols.end()),
+            llvm::hash_combine_range(interfaceType.typeArguments.begin(), interfaceType.typeArguments.end()));
+    }
+    case TypeType::TypeBridgedInterface:
+        // The bridged interface is resolved later from the name
+        return llvm::hash_combine(result, type.as<BridgedInterfaceType>().name);
+    case TypeType::TypeIncompleteArray:
+        return llvm::hash_combine(result, type.as<IncompleteArrayType>().innerType);
+    case TypeType::TypeConstantArray: {
+        const ConstantArrayType& arrayType = type.as<ConstantArrayType>();
+        return llvm::hash_combine(result, arrayType.innerType, arrayType.size);
+    }
+    case TypeType::TypeExtVector: {
+        const ExtVectorType& vectorType = type.as<ExtVectorType>();
+        return llvm::hash_combine(result, vectorType.innerType, vectorType.size);
+    }
+    case TypeType::TypePointer:
+        return llvm::hash_combine(result, type.as<PointerType>().innerType);
+    case TypeType::TypeBlock: {
+        const std::vector<Type*>& signature = type.as<BlockType>().signature;
+        return llvm::hash_combine(result, llvm::hash_combine_range(signature.begin(), signature.end()));
+    }
+    case TypeType::TypeFunctionPointer: {
+        const std::vector<Type*>& signature = type.as<FunctionPointerType>().signature;
+        return llvm::hash_combine(result, llvm::hash_combine_range(signature.begin(), signature.end()));
+    }
+    case TypeType::TypeStruct:
+        return llvm::hash_combine(result, type.as<StructType>().structMeta);
+    case TypeType::TypeUnion:
+        return llvm::hash_combine(result, type.as<UnionType>().unionMeta);
+    case TypeType::TypeAnonymousStruct:
+        return llvm::hash_combine(result, hashRecordFields(type.as<AnonymousStructType>().fields));
+    case TypeType::TypeAnonymousUnion:
+        return llvm::hash_combine(result, hashRecordFields(type.as<AnonymousUnionType>().fields));
+    case TypeType::TypeEnum: {
+        const EnumType& enumType = type.as<EnumType>();
+        return llvm::hash_combine(result, enumType.underlyingType, enumType.enumMeta);
+    }
+    default:
+        return result;
+    }
+}
+
+bool TypeInterner::areFieldsEqual(const Type& type1, const Type& type2)
+{
+    if (type1.getType() != type2.getType())
+        return false;
+
+    switch (type1.getType()) {
+    case TypeType::TypeClass:
+        return type1.as<ClassType>().protocols == type2.as<ClassType>().protocols;
+    case TypeType::TypeId:
+        return type1.as<IdType>().protocols == type2.as<IdType>().protocols;
+    case TypeType::TypeTypeArgument: {
+        const TypeArgumentType& argType1 = type1.as<TypeArgumentType>();
+        const TypeArgumentType& argType2 = type2.as<TypeArgumentType>();
+        return argType1.underlyingType == argType2.underlyingType && argType1.name == argType2.name && argType1.protocols == argType2.protocols;
+    }
+    case TypeType::TypeInterface: {
+        const InterfaceType& interfaceType1 = type1.as<InterfaceType>();
+        const InterfaceType& interfaceType2 = type2.as<InterfaceType>();
+        return interfaceType1.interface == interfaceType2.interface && interfaceType1.protocols == interfaceType2.protocols
+            && interfaceType1.typeArguments == interfaceType2.typeArguments;
+    }
+    case TypeType::TypeBridgedInterface:
+        return type1.as<BridgedInterfaceType>().name == type2.as<BridgedInterfaceType>().name;
+    case TypeType::TypeIncompleteArray:
+        return type1.as<IncompleteArrayType>().innerType == type2.as<IncompleteArrayType>().innerType;
+    case TypeType::TypeConstantArray: {
+        const ConstantArrayType& arrayType1 = type1.as<ConstantArrayType>();
+        const ConstantArrayType& arrayType2 = type2.as<ConstantArrayType>();
+        return arrayType1.innerType == arrayType2.innerType && arrayType1.size == arrayType2.size;
+    }
+    case TypeType::TypeExtVector: {
+        const ExtVectorType& vectorType1 = type1.as<ExtVectorType>();
+        const ExtVectorType& vectorType2 = type2.as<ExtVectorType>();
+        return vectorType1.innerType == vectorType2.innerType && vectorType1.size == vectorType2.size;
+    }
+    case TypeType::TypePointer:
+        return type1.as<PointerType>().innerType == type2.as<PointerType>().innerType;
+    case TypeType::TypeBlock:
+        return type1.as<BlockType>().signature == type2.as<BlockType>().signature;
+    case TypeType::TypeFunctionPointer:
+        return type1.as<FunctionPointerType>().signature == type2.as<FunctionPointerType>().signature;
+    case TypeType::TypeStruct:
+        return type1.as<StructType>().structMeta == type2.as<StructType>().structMeta;
+    case TypeType::TypeUnion:
+        return type1.as<UnionType>().unionMeta == type2.as<UnionType>().unionMeta;
+    case TypeType::TypeAnonymousStruct:
+        return areRecordFieldsEqual(type1.as<AnonymousStructType>().fields, type2.as<AnonymousStructType>().fields);
+    case TypeType::TypeAnonymousUnion:
+        return areRecordFieldsEqual(type1.as<AnonymousUnionType>().fields, type2.as<AnonymousUnionType>().fields);
+    case TypeType::TypeEnum: {
+        const EnumType& enumType1 = type1.as<EnumType>();
+        const EnumType& enumType2 = type2.as<EnumType>();
+        return enumType1.underlyingType == enumType2.underlyingType && enumType1.enumMeta == enumType2.enumMeta;
+    }
+    default:
+        return true;
+    }
+}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "TypeEntities.h"
+#include <memory>
+#include <unordered_map>
+
+namespace Meta {
+/*
+ * \class TypeInterner
+ * \brief Keeps one instance of each structurally distinct type.
+ *
+ * Types are interned after the types they reference, so two types are structurally equal exactly when their
+ * own fields are equal and they reference the same instances. Hashing and comparing a type never recurses,
+ * and two interned types are equal only if they are the same object.
+ */
+class TypeInterner {
+    MAKE_NONCOPYABLE(TypeInterner);
+
+public:
+    TypeInterner() {}
+
+    /*
+     * \brief Returns the interned type which is structurally equal to the given one, or interns the given type.
+     *
+     * All types referenced by the given type must already be interned.
+     */
+    std::shared_ptr<Type> intern(const std::shared_ptr<Type>& type);
+
+    static size_t hash(const Type& type);
+
+    static bool areFieldsEqual(const Type& type1, const Type& type2);
+
+private:
+    std::unordered_multimap<size_t, std::shared_ptr<Type> > _types;
+};
+}
@@ -19,6 +19,9 @@ bool areRecordFieldListsEqual(const std::vector<RecordField>& vector1, const std
 // TODO: This logic should be moved in types (and meta entities) entites
 bool Utils::areTypesEqual(const Type& type1, const Type& type2)
 {
+    // The types created by TypeFactory are interned, so structurally identical types are the same object
+    if (&type1 == &type2)
+        return true;
     if (type1.getType() != type2.getType())
         return false;
 
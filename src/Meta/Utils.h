@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
 #include <clang/AST/Decl.h>
 #include <clang/Basic/Module.h>
+#include <vector>
 
 namespace Meta {
 class Type;
@@ -27,5 +30,65 @@ public:
     static std::string calculateEnumFieldsPrefix(const std::string& enumName, const std::vector<std::string>& fields);
 
     static void getAllLinkLibraries(clang::Module* module, std::vector<clang::Module::LinkLibrary>& result);
+
+    /*
+     * \brief Sorts metas by their jsNames compared case-insensitively, which is the order of the members in the YAML and TypeScript outputs.
+     */
+    template <class T>
+    static void sortMetasByJsName(std::vector<T*>& metas)
+    {
+        // The lowercase names are computed once instead of in each comparison
+        std::vector<std::pair<std::string, T*> > keys;
+        keys.reserve(metas.size());
+        for (T* meta : metas) {
+            std::string key = meta->jsName;
+            std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+            keys.push_back(std::make_pair(std::move(key), meta));
+        }
+
+        std::sort(keys.begin(), keys.end(), [](const std::pair<std::string, T*>& first, const std::pair<std::string, T*>& second) {
+            return first.first < second.first;
+        });
+        for (size_t i = 0; i < keys.size(); i++) {
+            metas[i] = keys[i].second;
+        }
+    }
+
+    /*
+     * \brief Sorts metas in the order in which the runtime looks members up: by jsName and then by name, compared byte by byte.
+     *
+     * Only the binary metadata is written in this order. The names are gathered next to each meta before sorting,
+     * so that comparisons don't load the metas themselves.
+     */
+    template <class T>
+    static void sortMetasForLookup(std::vector<T*>& metas)
+    {
+        struct SortKey {
+            llvm::StringRef jsName;
+            llvm::StringRef name;
+            T* meta;
+
+            bool operator<(const SortKey& other) const
+            {
+                int result = jsName.compare(other.jsName);
+                return result < 0 || (result == 0 && name < other.name);
+            }
+        };
+
+        std::vector<SortKey> keys;
+        keys.reserve(metas.size());
+        for (T* meta : metas) {
+            keys.push_back({ meta->jsName, meta->name, meta });
+        }
+        // Members whose names differ only in case are often already sorted
+        if (std::is_sorted(keys.begin(), keys.end())) {
+            return;
+        }
+
+        std::sort(keys.begin(), keys.end());
+        for (size_t i = 0; i < keys.size(); i++) {
+            metas[i] = keys[i].meta;
+        }
+    }
 };
 }
\ No newline at end of file
@@ -91,9 +91,19 @@ public:
     
     virtual bool visitTypeArgument(const ::Meta::TypeArgumentType& type);
 
+    /*
+     * \brief Returns the failure of the first invalid meta referenced by the visited type, or null if it is valid.
+     */
+    const CreationFailure& getFailure() const
+    {
+        return _failure;
+    }
     
 private:
+    bool validate(::Meta::Meta* meta);
+
     MetaFactory& _metaFactory;
+    CreationFailure _failure;
 };
 
 #endif /* ValidateMetaTypeVisitor_h */
@@ -3,8 +3,9 @@
 #include "Meta/NameRetrieverVisitor.h"
 #include "Utils/StringUtils.h"
 #include <algorithm>
-#include <clang/AST/DeclObjC.h>
 #include <iterator>
+#include <llvm/Support/ThreadPool.h>
+#include <set>
 
 namespace TypeScript {
 using namespace Meta;
@@ -25,48 +26,27 @@ static std::string sanitizeParameterName(const std::string& parameterName)
     }
 }
 
-static std::string getTypeParametersStringOrEmpty(const clang::ObjCInterfaceDecl* interfaceDecl)
+static void writeTypeParameters(llvm::raw_ostream& output, const InterfaceMeta& interface)
 {
-    std::ostringstream output;
-    if (clang::ObjCTypeParamList* typeParameters = interfaceDecl->getTypeParamListAsWritten()) {
-        if (typeParameters->size()) {
-            output << "<";
-            for (unsigned i = 0; i < typeParameters->size(); i++) {
-                clang::ObjCTypeParamDecl* typeParam = *(typeParameters->begin() + i);
-                output << typeParam->getNameAsString();
-                if (i < typeParameters->size() - 1) {
-                    output << ", ";
-                }
-            }
-            output << ">";
-        }
-    }
-
-    return output.str();
-}
-    
-static std::vector<std::string> getTypeParameterNames(const clang::ObjCInterfaceDecl* interfaceDecl)
-{
-    std::vector<std::string> params;
-    if (clang::ObjCTypeParamList* typeParameters = interfaceDecl->getTypeParamListAsWritten()) {
-        if (typeParameters->size()) {
-            for (unsigned i = 0; i < typeParameters->size(); i++) {
-                clang::ObjCTypeParamDecl* typeParam = *(typeParameters->begin() + i);
-                params.push_back(typeParam->getNameAsString());
+    if (interface.typeParameters.size()) {
+        output << "<";
+        for (size_t i = 0; i < interface.typeParameters.size(); i++) {
+            output << interface.typeParameters[i];
+            if (i < interface.typeParameters.size() - 1) {
+                output << ", ";
             }
         }
+        output << ">";
     }
-    return params;
 }
-    
-std::string DefinitionWriter::getTypeArgumentsStringOrEmpty(const clang::ObjCObjectType* objectType)
+
+void DefinitionWriter::writeTypeArguments(llvm::raw_ostream& output, const InterfaceMeta& interface)
 {
-    std::ostringstream output;
-    llvm::ArrayRef<clang::QualType> typeArgs = objectType->getTypeArgsAsWritten();
+    const std::vector<Type*>& typeArgs = interface.baseTypeArguments;
     if (!typeArgs.empty()) {
         output << "<";
-        for (unsigned i = 0; i < typeArgs.size(); i++) {
-            output << tsifyType(*_typeFactory.create(typeArgs[i]));
+        for (size_t i = 0; i < typeArgs.size(); i++) {
+            tsifyType(output, *typeArgs[i]);
             if (i < typeArgs.size() - 1) {
                 output << ", ";
             }
@@ -78,21 +58,18 @@ std::string DefinitionWriter::getTypeArgumentsStringOrEmpty(const clang::ObjCObj
          * @interface MyInterface<ObjectType1, ObjectType2>
          * @interface MyDerivedInterface : MyInterface
          */
-        if (clang::ObjCTypeParamList* typeParameters = objectType->getInterface()->getTypeParamListAsWritten()) {
-            if (typeParameters->size()) {
-                output << "<";
-                for (unsigned i = 0; i < typeParameters->size(); i++) {
-                    output << "NSObject";
-                    if (i < typeParameters->size() - 1) {
-                        output << ", ";
-                    }
+        const std::vector<std::string>& typeParameters = interface.base->typeParameters;
+        if (typeParameters.size()) {
+            output << "<";
+            for (size_t i = 0; i < typeParameters.size(); i++) {
+                output << "NSObject";
+                if (i < typeParameters.size() - 1) {
+                    output << ", ";
                 }
-                output << ">";
             }
+            output << ">";
         }
     }
-
-    return output.str();
 }
 
 void DefinitionWriter::visit(InterfaceMeta* meta)
@@ -139,38 +116,44 @@ void DefinitionWriter::visit(InterfaceMeta* meta)
     }
     
     std::string metaJsName = meta->jsName;
-    std::string parametersString = getTypeParametersStringOrEmpty(clang::cast<clang::ObjCInterfaceDecl>(meta->declaration));
+    bool overrideParameters = false;
     
     if (DefinitionWriter::applyManualChanges) {
         if (metaJsName == "UIEvent") {
             metaJsName = "_UIEvent";
         } else if (metaJsName == "HMMutableCharacteristicEvent") {
-            // We need to add 'extends NSObject in order to inherit NSObject properties. By default it is exported as <TriggerValueType>
-            // @interface HMMutableCharacteristicEvent<TriggerValueType : id<NSCopying>> : HMCharacteristicEvent
-            parametersString = "<TriggerValueType extends NSObject>";
+            overrideParameters = true;
         }
     }
     
-    _buffer << std::endl
-            << _docSet.getCommentFor(meta).toString("") << "declare class " << metaJsName << parametersString;
+    _out << "\n"
+            << _docSet.getCommentFor(meta).toString("") << "declare class " << metaJsName;
+    if (overrideParameters) {
+        // We need to add 'extends NSObject in order to inherit NSObject properties. By default it is exported as <TriggerValueType>
+        // @interface HMMutableCharacteristicEvent<TriggerValueType : id<NSCopying>> : HMCharacteristicEvent
+        _out << "<TriggerValueType extends NSObject>";
+    } else {
+        writeTypeParameters(_out, *meta);
+    }
     if (meta->base != nullptr) {
-        _buffer << " extends " << localizeReference(*meta->base) << getTypeArgumentsStringOrEmpty(clang::cast<clang::ObjCInterfaceDecl>(meta->declaration)->getSuperClassType());
+        _out << " extends " << localizeReference(*meta->base);
+        writeTypeArguments(_out, *meta);
     }
 
     CompoundMemberMap<PropertyMeta> protocolInheritedStaticProperties;
     CompoundMemberMap<PropertyMeta> protocolInheritedInstanceProperties;
     std::unordered_set<ProtocolMeta*> protocols;
     if (meta->protocols.size()) {
-        _buffer << " implements ";
+        _out << " implements ";
         for (size_t i = 0; i < meta->protocols.size(); i++) {
             getProtocolMembersRecursive(meta->protocols[i], &compoundStaticMethods, &compoundInstanceMethods, &protocolInheritedStaticProperties, &protocolInheritedInstanceProperties, protocols);
-            _buffer << localizeReference(*meta->protocols[i]);
+            _out << localizeReference(*meta->protocols[i]);
             if (i < meta->protocols.size() - 1) {
-                _buffer << ", ";
+                _out << ", ";
             }
         }
     }
-    _buffer << " {" << std::endl;
+    _out << " {\n";
 
     std::unordered_set<ProtocolMeta*> immediateProtocols;
     for (auto protocol : protocols) {
@@ -184,13 +167,14 @@ void DefinitionWriter::visit(InterfaceMeta* meta)
             continue;
         }
 
-        std::string output = writeMethod(methodPair, meta, immediateProtocols);
-        if (output.size()) {
+        if (shouldWriteMethod(methodPair, meta, immediateProtocols)) {
             MethodMeta* method = methodPair.second.second;
             BaseClassMeta* owner = methodPair.second.first;
-            _buffer << std::endl
+            _out << "\n"
                     << _docSet.getCommentFor(method, owner).toString("\t");
-            _buffer << "\tstatic " << output << std::endl;
+            _out << "\tstatic ";
+            writeMethod(_out, methodPair, meta, immediateProtocols);
+            _out << "\n";
         }
     }
 
@@ -231,19 +215,22 @@ void DefinitionWriter::visit(InterfaceMeta* meta)
     auto objectAtIndexedSubscript = compoundInstanceMethods.find("objectAtIndexedSubscript");
     if (objectAtIndexedSubscript != compoundInstanceMethods.end()) {
         const Type* retType = objectAtIndexedSubscript->second.second->signature[0];
-        std::string indexerReturnType = computeMethodReturnType(retType, meta, true);
-        _buffer << "\t[index: number]: " << indexerReturnType << ";" << std::endl;
+        _out << "\t[index: number]: ";
+        writeMethodReturnType(_out, retType, meta, true);
+        _out << ";\n";
     }
 
     if (compoundInstanceMethods.find("countByEnumeratingWithStateObjectsCount") != compoundInstanceMethods.end()) {
-        _buffer << "\t[Symbol.iterator](): Iterator<any>;" << std::endl;
+        _out << "\t[Symbol.iterator](): Iterator<any>;\n";
     }
 
     for (auto& methodPair : compoundInstanceMethods) {
         if (methodPair.second.second->getFlags(MethodIsInitializer)) {
-            _buffer << std::endl
+            _out << "\n"
                     << _docSet.getCommentFor(methodPair.second.second, methodPair.second.first).toString("\t");
-            _buffer << "\t" << writeConstructor(methodPair, meta) << std::endl;
+            _out << "\t";
+            writeConstructor(_out, methodPair, meta);
+            _out << "\n";
         }
     }
 
@@ -256,29 +243,30 @@ void DefinitionWriter::visit(InterfaceMeta* meta)
         //            continue;
         //        }
 
-        std::string output = writeMethod(methodPair, meta, immediateProtocols, true);
-        if (output.size()) {
-            _buffer << std::endl
+        if (shouldWriteMethod(methodPair, meta, immediateProtocols)) {
+            _out << "\n"
                     << _docSet.getCommentFor(methodPair.second.second, methodPair.second.first).toString("\t");
-            _buffer << "\t" << output << std::endl;
+            _out << "\t";
+            writeMethod(_out, methodPair, meta, immediateProtocols, true);
+            _out << "\n";
         }
     }
 
-    _buffer << "}" << std::endl;
+    _out << "}\n";
 }
 
-void DefinitionWriter::writeProperty(PropertyMeta* propertyMeta, BaseClassMeta* owner, InterfaceMeta* target, CompoundMemberMap<PropertyMeta> baseClassProperties)
+void DefinitionWriter::writeProperty(PropertyMeta* propertyMeta, BaseClassMeta* owner, InterfaceMeta* target, const CompoundMemberMap<PropertyMeta>& baseClassProperties)
 {
-    _buffer << std::endl
+    _out << "\n"
             << _docSet.getCommentFor(propertyMeta, owner).toString("\t");
-    _buffer << "\t";
+    _out << "\t";
 
-    if (clang::cast<clang::ObjCPropertyDecl>(propertyMeta->declaration)->isClassProperty()) {
-        _buffer << "static ";
+    if (propertyMeta->isClassProperty) {
+        _out << "static ";
     }
 
     if (!propertyMeta->setter) {
-        _buffer << "readonly ";
+        _out << "readonly ";
     }
 
     bool optOutTypeChecking = false;
@@ -286,65 +274,100 @@ void DefinitionWriter::writeProperty(PropertyMeta* propertyMeta, BaseClassMeta*
     if (result != baseClassProperties.end()) {
         optOutTypeChecking = result->second.second->getter->signature[0] != propertyMeta->getter->signature[0];
     }
-    _buffer << writeProperty(propertyMeta, target, optOutTypeChecking);
+    writeProperty(_out, propertyMeta, target, optOutTypeChecking);
 
     if (owner != target) {
-        _buffer << " // inherited from " << localizeReference(*owner);
+        _out << " // inherited from " << localizeReference(*owner);
     }
 
-    _buffer << std::endl;
+    _out << "\n";
 }
 
-void DefinitionWriter::getInheritedMembersRecursive(InterfaceMeta* interface,
+template <class Member>
+static void addMembers(std::map<std::string, std::pair<BaseClassMeta*, Member*> >& members, const std::vector<Member*>& ownMembers, BaseClassMeta* owner)
+{
+    for (Member* member : ownMembers) {
+        members.emplace(member->jsName, std::make_pair(owner, member));
+    }
+}
+
+template <class Member>
+static void mergeMembers(std::map<std::string, std::pair<BaseClassMeta*, Member*> >* members, const std::map<std::string, std::pair<BaseClassMeta*, Member*> >& resolvedMembers)
+{
+    if (members) {
+        // Members which are already present take precedence, as they are closer to the class being written
+        members->insert(resolvedMembers.begin(), resolvedMembers.end());
+    }
+}
+
+void DefinitionWriter::mergeResolvedMembers(const ResolvedMembers& resolvedMembers,
     CompoundMemberMap<MethodMeta>* staticMethods,
     CompoundMemberMap<MethodMeta>* instanceMethods,
     CompoundMemberMap<PropertyMeta>* staticProperties,
     CompoundMemberMap<PropertyMeta>* instanceProperties)
 {
-    auto base = interface->base;
-    if (!base) {
-        return;
-    }
+    mergeMembers(staticMethods, resolvedMembers.staticMethods);
+    mergeMembers(instanceMethods, resolvedMembers.instanceMethods);
+    mergeMembers(staticProperties, resolvedMembers.staticProperties);
+    mergeMembers(instanceProperties, resolvedMembers.instanceProperties);
+}
 
-    if (staticMethods) {
-        for (MethodMeta* method : base->staticMethods) {
-            if (staticMethods->find(method->jsName) == staticMethods->end()) {
-                staticMethods->emplace(method->jsName, std::make_pair(base, method));
-            }
-        }
+const DefinitionWriter::ResolvedMembers& DefinitionWriter::Context::getInheritedMembers(InterfaceMeta* interface)
+{
+    auto cached = _inheritedMembersCache.find(interface);
+    if (cached != _inheritedMembersCache.end()) {
+        return cached->second;
     }
 
-    if (instanceMethods) {
-        for (MethodMeta* method : base->instanceMethods) {
-            if (instanceMethods->find(method->jsName) == instanceMethods->end()) {
-                instanceMethods->emplace(method->jsName, std::make_pair(base, method));
-            }
-        }
-    }
+    ResolvedMembers members;
+    if (InterfaceMeta* base = interface->base) {
+        addMembers(members.staticMethods, base->staticMethods, base);
+        addMembers(members.instanceMethods, base->instanceMethods, base);
+        addMembers(members.staticProperties, base->staticProperties, base);
+        addMembers(members.instanceProperties, base->instanceProperties, base);
 
-    if (staticProperties) {
-        for (PropertyMeta* property : base->staticProperties) {
-            if (staticProperties->find(property->jsName) == staticProperties->end()) {
-                staticProperties->emplace(property->jsName, std::make_pair(base, property));
-            }
+        for (ProtocolMeta* protocol : base->protocols) {
+            const ResolvedMembers& protocolMembers = getProtocolMembers(protocol);
+            mergeResolvedMembers(protocolMembers, &members.staticMethods, &members.instanceMethods, &members.staticProperties, &members.instanceProperties);
         }
+
+        const ResolvedMembers& baseMembers = getInheritedMembers(base);
+        mergeResolvedMembers(baseMembers, &members.staticMethods, &members.instanceMethods, &members.staticProperties, &members.instanceProperties);
     }
 
-    if (instanceProperties) {
-        for (PropertyMeta* property : base->instanceProperties) {
-            if (instanceProperties->find(property->jsName) == instanceProperties->end()) {
-                instanceProperties->emplace(property->jsName, std::make_pair(base, property));
-            }
-        }
+    return _inheritedMembersCache.emplace(interface, std::move(members)).first->second;
+}
+
+const DefinitionWriter::ResolvedMembers& DefinitionWriter::Context::getProtocolMembers(ProtocolMeta* protocolMeta)
+{
+    auto cached = _protocolMembersCache.find(protocolMeta);
+    if (cached != _protocolMembersCache.end()) {
+        return cached->second;
     }
 
-    // accumulate...
-    std::unordered_set<ProtocolMeta*> protocols;
-    for (auto protocol : base->protocols) {
-        getProtocolMembersRecursive(protocol, staticMethods, instanceMethods, staticProperties, instanceProperties, protocols);
+    ResolvedMembers members;
+    members.protocols.insert(protocolMeta);
+    addMembers(members.staticMethods, protocolMeta->staticMethods, protocolMeta);
+    addMembers(members.instanceMethods, protocolMeta->instanceMethods, protocolMeta);
+    addMembers(members.staticProperties, protocolMeta->staticProperties, protocolMeta);
+    addMembers(members.instanceProperties, protocolMeta->instanceProperties, protocolMeta);
+
+    for (ProtocolMeta* protocol : protocolMeta->protocols) {
+        const ResolvedMembers& protocolMembers = getProtocolMembers(protocol);
+        mergeResolvedMembers(protocolMembers, &members.staticMethods, &members.instanceMethods, &members.staticProperties, &members.instanceProperties);
+        members.protocols.insert(protocolMembers.protocols.begin(), protocolMembers.protocols.end());
     }
 
-    getInheritedMembersRecursive(base, staticMethods, instanceMethods, staticProperties, instanceProperties);
+    return _protocolMembersCache.emplace(protocolMeta, std::move(members)).first->second;
+}
+
+void DefinitionWriter::getInheritedMembersRecursive(InterfaceMeta* interface,
+    CompoundMemberMap<MethodMeta>* staticMethods,
+    CompoundMemberMap<MethodMeta>* instanceMethods,
+    CompoundMemberMap<PropertyMeta>* staticProperties,
+    CompoundMemberMap<PropertyMeta>* instanceProperties)
+{
+    mergeResolvedMembers(_context.getInheritedMembers(interface), staticMethods, instanceMethods, staticProperties, instanceProperties);
 }
 
 void DefinitionWriter::getProtocolMembersRecursive(ProtocolMeta* protocolMeta,
@@ -354,48 +377,14 @@ void DefinitionWriter::getProtocolMembersRecursive(ProtocolMeta* protocolMeta,
     CompoundMemberMap<PropertyMeta>* instanceProperties,
     std::unordered_set<ProtocolMeta*>& visitedProtocols)
 {
-    visitedProtocols.insert(protocolMeta);
-
-    if (staticMethods) {
-        for (MethodMeta* method : protocolMeta->staticMethods) {
-            if (staticMethods->find(method->jsName) == staticMethods->end()) {
-                staticMethods->emplace(method->jsName, std::make_pair(protocolMeta, method));
-            }
-        }
-    }
-
-    if (instanceMethods) {
-        for (MethodMeta* method : protocolMeta->instanceMethods) {
-            if (instanceMethods->find(method->jsName) == instanceMethods->end()) {
-                instanceMethods->emplace(method->jsName, std::make_pair(protocolMeta, method));
-            }
-        }
-    }
-
-    if (staticProperties) {
-        for (PropertyMeta* property : protocolMeta->staticProperties) {
-            if (staticProperties->find(property->jsName) == staticProperties->end()) {
-                staticProperties->emplace(property->jsName, std::make_pair(protocolMeta, property));
-            }
-        }
-    }
-
-    if (instanceProperties) {
-        for (PropertyMeta* property : protocolMeta->instanceProperties) {
-            if (instanceProperties->find(property->jsName) == instanceProperties->end()) {
-                instanceProperties->emplace(property->jsName, std::make_pair(protocolMeta, property));
-            }
-        }
-    }
-
-    for (ProtocolMeta* protocol : protocolMeta->protocols) {
-        getProtocolMembersRecursive(protocol, staticMethods, instanceMethods, staticProperties, instanceProperties, visitedProtocols);
-    }
+    const ResolvedMembers& protocolMembers = _context.getProtocolMembers(protocolMeta);
+    mergeResolvedMembers(protocolMembers, staticMethods, instanceMethods, staticProperties, instanceProperties);
+    visitedProtocols.insert(protocolMembers.protocols.begin(), protocolMembers.protocols.end());
 }
 
 void DefinitionWriter::visit(ProtocolMeta* meta)
 {
-    _buffer << std::endl
+    _out << "\n"
             << _docSet.getCommentFor(meta).toString("");
     
     std::string metaName = meta->jsName;
@@ -407,42 +396,46 @@ void DefinitionWriter::visit(ProtocolMeta* meta)
         }
     }
 
-    _buffer << "interface " << metaName;
+    _out << "interface " << metaName;
     std::map<std::string, PropertyMeta*> conformedProtocolsProperties;
     if (meta->protocols.size()) {
-        _buffer << " extends ";
+        _out << " extends ";
         for (size_t i = 0; i < meta->protocols.size(); i++) {
             std::transform(meta->protocols[i]->instanceProperties.begin(), meta->protocols[i]->instanceProperties.end(), std::inserter(conformedProtocolsProperties, conformedProtocolsProperties.end()), [](PropertyMeta* propertyMeta) {
                 return std::make_pair(propertyMeta->jsName, propertyMeta);
             });
 
-            _buffer << localizeReference(*meta->protocols[i]);
+            _out << localizeReference(*meta->protocols[i]);
             if (i < meta->protocols.size() - 1) {
-                _buffer << ", ";
+                _out << ", ";
             }
         }
     }
-    _buffer << " {" << std::endl;
+    _out << " {\n";
 
     for (PropertyMeta* property : meta->instanceProperties) {
         bool optOutTypeChecking = conformedProtocolsProperties.find(property->jsName) != conformedProtocolsProperties.end();
-        _buffer << std::endl
-                << _docSet.getCommentFor(property, meta).toString("\t") << "\t" << writeProperty(property, meta, optOutTypeChecking) << std::endl;
+        _out << "\n"
+                << _docSet.getCommentFor(property, meta).toString("\t") << "\t";
+        writeProperty(_out, property, meta, optOutTypeChecking);
+        _out << "\n";
     }
 
     for (MethodMeta* method : meta->instanceMethods) {
         if (hiddenMethods.find(method->jsName) == hiddenMethods.end()) {
-            _buffer << std::endl
-                    << _docSet.getCommentFor(method, meta).toString("\t") << "\t" << writeMethod(method, meta) << std::endl;
+            _out << "\n"
+                    << _docSet.getCommentFor(method, meta).toString("\t") << "\t";
+            writeMethod(_out, method, meta);
+            _out << "\n";
         }
     }
 
-    _buffer << "}" << std::endl;
+    _out << "}\n";
 
-    _buffer << "declare var " << metaName << ": {" << std::endl;
+    _out << "declare var " << metaName << ": {\n";
 
-    _buffer << std::endl
-            << "\tprototype: " << metaName << ";" << std::endl;
+    _out << "\n"
+            << "\tprototype: " << metaName << ";\n";
 
     CompoundMemberMap<MethodMeta> compoundStaticMethods;
     for (MethodMeta* method : meta->staticMethods) {
@@ -455,27 +448,26 @@ void DefinitionWriter::visit(ProtocolMeta* meta)
     }
 
     for (auto& methodPair : compoundStaticMethods) {
-        std::string output = writeMethod(methodPair, meta, protocols);
-        if (output.size()) {
+        if (shouldWriteMethod(methodPair, meta, protocols)) {
             MethodMeta* method = methodPair.second.second;
             BaseClassMeta* owner = methodPair.second.first;
-            _buffer << std::endl
+            _out << "\n"
                     << _docSet.getCommentFor(method, owner).toString("\t");
-            _buffer << "\t" << output << std::endl;
+            _out << "\t";
+            writeMethod(_out, methodPair, meta, protocols);
+            _out << "\n";
         }
     }
 
-    _buffer << "};" << std::endl;
+    _out << "};\n";
 }
 
-std::string DefinitionWriter::writeConstructor(const CompoundMemberMap<MethodMeta>::value_type& initializer,
+void DefinitionWriter::writeConstructor(llvm::raw_ostream& output, const CompoundMemberMap<MethodMeta>::value_type& initializer,
     const BaseClassMeta* owner)
 {
     MethodMeta* method = initializer.second.second;
     assert(method->getFlags(MethodIsInitializer));
 
-    std::ostringstream output;
-
     if (method->constructorTokens == "") {
         output << "constructor();";
     }
@@ -485,7 +477,12 @@ std::string DefinitionWriter::writeConstructor(const CompoundMemberMap<MethodMet
         output << "constructor(o: { ";
         for (size_t i = 0; i < ctorTokens.size(); i++) {
             output << ctorTokens[i] << ": ";
-            output << (i + 1 < method->signature.size() ? tsifyType(*method->signature[i + 1], true) : "void") << "; ";
+            if (i + 1 < method->signature.size()) {
+                tsifyType(output, *method->signature[i + 1], true);
+            } else {
+                output << "void";
+            }
+            output << "; ";
         }
         output << "});";
     }
@@ -494,8 +491,6 @@ std::string DefinitionWriter::writeConstructor(const CompoundMemberMap<MethodMet
     if (initializerOwner != owner) {
         output << " // inherited from " << initializerOwner->jsName;
     }
-
-    return output.str();
 }
     
 void getClosedGenericsIfAny(Type& type, std::vector<Type*>& params)
@@ -515,22 +510,14 @@ void getClosedGenericsIfAny(Type& type, std::vector<Type*>& params)
     }
 }
 
-std::string DefinitionWriter::writeMethod(MethodMeta* meta, BaseClassMeta* owner, bool canUseThisType)
+void DefinitionWriter::writeMethod(llvm::raw_ostream& output, MethodMeta* meta, BaseClassMeta* owner, bool canUseThisType)
 {
-    const clang::ObjCMethodDecl& methodDecl = *clang::dyn_cast<clang::ObjCMethodDecl>(meta->declaration);
-    auto parameters = methodDecl.parameters();
-
-    std::vector<std::string> parameterNames;
+    std::vector<std::string> parameterNames = meta->parameterNames;
     std::vector<Type*> paramsGenerics;
     std::vector<std::string> ownerGenerics;
     if (owner->is(Interface)) {
-        ownerGenerics = getTypeParameterNames(clang::cast<clang::ObjCInterfaceDecl>(static_cast<const InterfaceMeta*>(owner)->declaration));
+        ownerGenerics = static_cast<const InterfaceMeta*>(owner)->typeParameters;
     }
-    
-    std::transform(parameters.begin(), parameters.end(), std::back_inserter(parameterNames), [](clang::ParmVarDecl* param) {
-        
-        return param->getNameAsString();
-    });
 
     for (size_t i = 0; i < parameterNames.size(); i++) {
         getClosedGenericsIfAny(*meta->signature[i+1], paramsGenerics);
@@ -551,8 +538,6 @@ std::string DefinitionWriter::writeMethod(MethodMeta* meta, BaseClassMeta* owner
         }
     }
 
-    std::ostringstream output;
-
     output << meta->jsName;
     bool skipGenerics = false;
 
@@ -566,10 +551,9 @@ std::string DefinitionWriter::writeMethod(MethodMeta* meta, BaseClassMeta* owner
 
     const Type* retType = meta->signature[0];
     
-    if (!methodDecl.isInstanceMethod() && owner->is(MetaType::Interface)) {
+    if (!meta->isInstanceMethod && owner->is(MetaType::Interface)) {
         if ((retType->is(TypeInstancetype) || DefinitionWriter::hasClosedGenerics(*retType)) && !skipGenerics) {
-            output << getTypeParametersStringOrEmpty(
-                clang::cast<clang::ObjCInterfaceDecl>(static_cast<const InterfaceMeta*>(owner)->declaration));
+            writeTypeParameters(output, *static_cast<const InterfaceMeta*>(owner));
         } else if (!paramsGenerics.empty()) {
             output << "<";
             for (size_t i = 0; i < paramsGenerics.size(); i++) {
@@ -583,7 +567,7 @@ std::string DefinitionWriter::writeMethod(MethodMeta* meta, BaseClassMeta* owner
         }
     }
 
-    if ((owner->type == MetaType::Protocol && methodDecl.getImplementationControl() == clang::ObjCMethodDecl::ImplementationControl::Optional) || (owner->is(MetaType::Protocol) && meta->getFlags(MethodIsInitializer))) {
+    if ((owner->type == MetaType::Protocol && meta->getFlags(MemberIsOptional)) || (owner->is(MetaType::Protocol) && meta->getFlags(MethodIsInitializer))) {
         output << "?";
     }
 
@@ -603,7 +587,8 @@ std::string DefinitionWriter::writeMethod(MethodMeta* meta, BaseClassMeta* owner
     
     for (size_t i = 1; i < lastParamIndex; i++) {
         
-        output << sanitizeParameterName(parameterNames[i - 1]) << ": " << tsifyType(*meta->signature[i], true);
+        output << sanitizeParameterName(parameterNames[i - 1]) << ": ";
+        tsifyType(output, *meta->signature[i], true);
 
         if (i < lastParamIndex - 1) {
             output << ", ";
@@ -615,59 +600,63 @@ std::string DefinitionWriter::writeMethod(MethodMeta* meta, BaseClassMeta* owner
     if (skipGenerics) {
         output << "any;";
     } else {
-        output << computeMethodReturnType(retType, owner, canUseThisType) << ";";
+        writeMethodReturnType(output, retType, owner, canUseThisType);
+        output << ";";
     }
-    
-    return output.str();
 }
 
-std::string DefinitionWriter::writeMethod(CompoundMemberMap<MethodMeta>::value_type& methodPair, BaseClassMeta* owner, const std::unordered_set<ProtocolMeta*>& protocols, bool canUseThisType)
+bool DefinitionWriter::shouldWriteMethod(CompoundMemberMap<MethodMeta>::value_type& methodPair, BaseClassMeta* owner, const std::unordered_set<ProtocolMeta*>& protocols)
 {
-    std::ostringstream output;
-
     BaseClassMeta* memberOwner = methodPair.second.first;
     MethodMeta* method = methodPair.second.second;
 
     if (hiddenMethods.find(method->jsName) != hiddenMethods.end()) {
-        return std::string();
+        return false;
     }
 
     bool isOwnMethod = memberOwner == owner;
     bool implementsProtocol = protocols.find(static_cast<ProtocolMeta*>(memberOwner)) != protocols.end();
     bool returnsInstanceType = method->signature[0]->is(TypeInstancetype);
 
-    if (isOwnMethod || implementsProtocol || returnsInstanceType) {
-        output << writeMethod(method, owner, canUseThisType);
-        if (!isOwnMethod && !implementsProtocol) {
-            output << " // inherited from " << localizeReference(memberOwner->jsName, memberOwner->module->getFullModuleName());
-        }
+    return isOwnMethod || implementsProtocol || returnsInstanceType;
+}
+
+void DefinitionWriter::writeMethod(llvm::raw_ostream& output, CompoundMemberMap<MethodMeta>::value_type& methodPair, BaseClassMeta* owner, const std::unordered_set<ProtocolMeta*>& protocols, bool canUseThisType)
+{
+    if (!shouldWriteMethod(methodPair, owner, protocols)) {
+        return;
     }
 
-    return output.str();
+    BaseClassMeta* memberOwner = methodPair.second.first;
+    MethodMeta* method = methodPair.second.second;
+
+    writeMethod(output, method, owner, canUseThisType);
+    if (memberOwner != owner && protocols.find(static_cast<ProtocolMeta*>(memberOwner)) == protocols.end()) {
+        output << " // inherited from " << localizeReference(memberOwner->jsName, memberOwner->module->getFullModuleName());
+    }
 }
 
-std::string DefinitionWriter::writeProperty(PropertyMeta* meta, BaseClassMeta* owner, bool optOutTypeChecking)
+void DefinitionWriter::writeProperty(llvm::raw_ostream& output, PropertyMeta* meta, BaseClassMeta* owner, bool optOutTypeChecking)
 {
-    std::ostringstream output;
-
     if (hiddenMethods.find(meta->jsName) != hiddenMethods.end()) {
-        return std::string();
+        return;
     }
 
     output << meta->jsName;
-    if (owner->is(MetaType::Protocol) && clang::dyn_cast<clang::ObjCPropertyDecl>(meta->declaration)->getPropertyImplementation() == clang::ObjCPropertyDecl::PropertyControl::Optional) {
+    if (owner->is(MetaType::Protocol) && meta->getFlags(MemberIsOptional)) {
         output << "?";
     }
 
-    std::string returnType = tsifyType(*meta->getter->signature[0]);
     if (optOutTypeChecking) {
-        output << ": any; /*" << returnType << " */";
+        output << ": any; /*";
+        tsifyType(output, *meta->getter->signature[0]);
+        output << " */";
     }
     else {
-        output << ": " << returnType << ";";
+        output << ": ";
+        tsifyType(output, *meta->getter->signature[0]);
+        output << ";";
     }
-
-    return output.str();
 }
 
 void DefinitionWriter::visit(CategoryMeta* meta)
@@ -676,36 +665,36 @@ void DefinitionWriter::visit(CategoryMeta* meta)
 
 void DefinitionWriter::visit(FunctionMeta* meta)
 {
-    const clang::FunctionDecl& functionDecl = *clang::dyn_cast<clang::FunctionDecl>(meta->declaration);
+    _out << "\n"
+            << _docSet.getCommentFor(meta).toString("");
+    _out << "declare function " << meta->jsName << "(";
 
-    std::ostringstream params;
     for (size_t i = 1; i < meta->signature.size(); i++) {
-        std::string name = sanitizeParameterName(functionDecl.getParamDecl(i - 1)->getNameAsString());
-        params << (name.size() ? name : "p" + std::to_string(i)) << ": " << tsifyType(*meta->signature[i], true);
+        std::string name = sanitizeParameterName(meta->parameterNames[i - 1]);
+        _out << (name.size() ? name : "p" + std::to_string(i)) << ": ";
+        tsifyType(_out, *meta->signature[i], true);
         if (i < meta->signature.size() - 1) {
-            params << ", ";
+            _out << ", ";
         }
     }
 
-    _buffer << std::endl
-            << _docSet.getCommentFor(meta).toString("");
-    _buffer << "declare function " << meta->jsName
-            << "(" << params.str() << "): ";
+    _out << "): ";
 
-    std::string returnName;
     if (meta->name == "UIApplicationMain" || meta->name == "NSApplicationMain" || meta->name == "dispatch_main") {
-        returnName = "never";
+        _out << "never";
+    }
+    else if (meta->getFlags(MetaFlags::FunctionReturnsUnmanaged)) {
+        _out << "interop.Unmanaged<";
+        tsifyType(_out, *meta->signature[0]);
+        _out << ">";
     }
     else {
-        returnName = tsifyType(*meta->signature[0]);
-        if (meta->getFlags(MetaFlags::FunctionReturnsUnmanaged)) {
-            returnName = "interop.Unmanaged<" + returnName + ">";
-        }
+        tsifyType(_out, *meta->signature[0]);
     }
 
-    _buffer << returnName << ";";
+    _out << ";";
 
-    _buffer << std::endl;
+    _out << "\n";
 }
 
 void DefinitionWriter::visit(StructMeta* meta)
@@ -720,84 +709,88 @@ void DefinitionWriter::visit(StructMeta* meta)
     }
     
     TSComment comment = _docSet.getCommentFor(meta);
-    _buffer << std::endl
+    _out << "\n"
             << comment.toString("");
 
-    _buffer << "interface " << metaName << " {" << std::endl;
+    _out << "interface " << metaName << " {\n";
     writeMembers(meta->fields, comment.fields);
-    _buffer << "}" << std::endl;
+    _out << "}\n";
 
-    _buffer << "declare var " << metaName << ": interop.StructType<" << metaName << ">;";
+    _out << "declare var " << metaName << ": interop.StructType<" << metaName << ">;";
 
-    _buffer << std::endl;
+    _out << "\n";
 }
 
 void DefinitionWriter::visit(UnionMeta* meta)
 {
     TSComment comment = _docSet.getCommentFor(meta);
-    _buffer << std::endl
+    _out << "\n"
             << comment.toString("");
 
-    _buffer << "interface " << meta->jsName << " {" << std::endl;
+    _out << "interface " << meta->jsName << " {\n";
     writeMembers(meta->fields, comment.fields);
-    _buffer << "}" << std::endl;
+    _out << "}\n";
 
-    _buffer << std::endl;
+    _out << "\n";
 }
 
 void DefinitionWriter::writeMembers(const std::vector<RecordField>& fields, std::vector<TSComment> fieldsComments)
 {
     for (size_t i = 0; i < fields.size(); i++) {
         if (i < fieldsComments.size()) {
-            _buffer << fieldsComments[i].toString("\t");
+            _out << fieldsComments[i].toString("\t");
         }
-        _buffer << "\t" << fields[i].name << ": " << tsifyType(*fields[i].encoding) << ";" << std::endl;
+        _out << "\t" << fields[i].name << ": ";
+        tsifyType(_out, *fields[i].encoding);
+        _out << ";\n";
     }
 }
 
 void DefinitionWriter::visit(EnumMeta* meta)
 {
-    _buffer << std::endl
+    _out << "\n"
             << _docSet.getCommentFor(meta).toString("");
-    _buffer << "declare const enum " << meta->jsName << " {" << std::endl;
+    _out << "declare const enum " << meta->jsName << " {\n";
 
     std::vector<EnumField>& fields = meta->swiftNameFields.size() != 0 ? meta->swiftNameFields : meta->fullNameFields;
 
     for (size_t i = 0; i < fields.size(); i++) {
-        _buffer << std::endl
+        _out << "\n"
                 << _docSet.getCommentFor(meta->fullNameFields[i].name, MetaType::EnumConstant).toString("\t");
-        _buffer << "\t" << fields[i].name << " = " << fields[i].value;
+        _out << "\t" << fields[i].name << " = " << fields[i].value;
         if (i < fields.size() - 1) {
-            _buffer << ",";
+            _out << ",";
         }
-        _buffer << std::endl;
+        _out << "\n";
     }
 
-    _buffer << "}";
-    _buffer << std::endl;
+    _out << "}";
+    _out << "\n";
 }
 
 void DefinitionWriter::visit(VarMeta* meta)
 {
-    _buffer << std::endl
+    _out << "\n"
             << _docSet.getCommentFor(meta).toString("");
-    _buffer << "declare var " << meta->jsName << ": " << tsifyType(*meta->signature) << ";" << std::endl;
+    _out << "declare var " << meta->jsName << ": ";
+    tsifyType(_out, *meta->signature);
+    _out << ";\n";
 }
 
-std::string DefinitionWriter::writeFunctionProto(const std::vector<Type*>& signature)
+void DefinitionWriter::Context::writeFunctionProto(llvm::raw_ostream& output, const std::vector<Type*>& signature)
 {
-    std::ostringstream output;
     output << "(";
 
     for (size_t i = 1; i < signature.size(); i++) {
-        output << "p" << i << ": " << tsifyType(*signature[i]);
+        output << "p" << i << ": ";
+        output << getRenderedType(*signature[i], false);
         if (i < signature.size() - 1) {
             output << ", ";
         }
     }
 
-    output << ") => " << tsifyType(*signature[0]);
-    return output.str();
+    output << ") => ";
+    output << getRenderedType(*signature[0], false);
 }
 
 void DefinitionWriter::visit(MethodMeta* meta)
@@ -815,9 +808,9 @@ void DefinitionWriter::visit(EnumConstantMeta* meta)
         return;
     }
 
-    _buffer << std::endl;
-    _buffer << "declare const " << meta->jsName << ": number;";
-    _buffer << std::endl;
+    _out << "\n";
+    _out << "declare const " << meta->jsName << ": number;";
+    _out << "\n";
 }
 
 std::string DefinitionWriter::localizeReference(const std::string& jsName, std::string moduleName)
@@ -847,13 +840,106 @@ bool DefinitionWriter::hasClosedGenerics(const Type& type)
     return false;
 }
 
+void DefinitionWriter::Context::prerenderTypes(const std::vector<::Meta::Meta*>& metas)
+{
+    // The return type is at index 0 of a signature, followed by the parameters
+    std::set<std::pair<const Type*, bool> > types;
+    auto addSignature = [&types](const std::vector<Type*>& signature) {
+        for (size_t i = 0; i < signature.size(); i++) {
+            types.emplace(signature[i], i > 0);
+        }
+    };
+
+    for (::Meta::Meta* meta : metas) {
+        switch (meta->type) {
+        case MetaType::Function:
+            addSignature(meta->as<FunctionMeta>().signature);
+            break;
+        case MetaType::Var:
+            types.emplace(meta->as<VarMeta>().signature, false);
+            break;
+        case MetaType::Struct:
+        case MetaType::Union:
+            for (RecordField& field : meta->as<RecordMeta>().fields) {
+                types.emplace(field.encoding, false);
+            }
+            break;
+        case MetaType::Interface:
+        case MetaType::Protocol:
+        case MetaType::Category: {
+            BaseClassMeta& baseClass = meta->as<BaseClassMeta>();
+            for (MethodMeta* method : baseClass.staticMethods) {
+                addSignature(method->signature);
+            }
+            for (MethodMeta* method : baseClass.instanceMethods) {
+                addSignature(method->signature);
+            }
+            for (PropertyMeta* property : baseClass.staticProperties) {
+                types.emplace(property->getter->signature[0], false);
+            }
+            for (PropertyMeta* property : baseClass.instanceProperties) {
+                types.emplace(property->getter->signature[0], false);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    llvm::ThreadPool pool;
+    for (const std::pair<const Type*, bool>& type : types) {
+        // instancetype is written by writeMethodReturnType and va_list is never written
+        if (type.first->is(TypeInstancetype) || type.first->is(TypeVaList)) {
+            continue;
+        }
+        pool.async([this, &type]() {
+            getRenderedType(*type.first, type.second);
+        });
+    }
+    pool.wait();
+}
+
+const std::string& DefinitionWriter::Context::getRenderedType(const Type& type, const bool isFuncParam)
+{
+    std::unordered_map<const Type*, std::string>& rendered = _renderedTypes[isFuncParam ? 1 : 0];
+    {
+        std::lock_guard<std::mutex> lock(_renderedTypesMutex);
+        auto it = rendered.find(&type);
+        if (it != rendered.end()) {
+            return it->second;
+        }
+    }
+
+    // Rendered without holding the lock, as nested types are looked up recursively
+    std::string result;
+    llvm::raw_string_ostream output(result);
+    renderType(output, type, isFuncParam);
+    output.flush();
+
+    std::lock_guard<std::mutex> lock(_renderedTypesMutex);
+    return rendered.emplace(&type, std::move(result)).first->second;
+}
+
 std::string DefinitionWriter::tsifyType(const Type& type, const bool isFuncParam)
+{
+    return _context.getRenderedType(type, isFuncParam);
+}
+
+void DefinitionWriter::tsifyType(llvm::raw_ostream& output, const Type& type, const bool isFuncParam)
+{
+    output << _context.getRenderedType(type, isFuncParam);
+}
+
+void DefinitionWriter::Context::renderType(llvm::raw_ostream& output, const Type& type, const bool isFuncParam)
 {
     switch (type.getType()) {
     case TypeVoid:
-        return "void";
+        output << "void";
+        return;
     case TypeBool:
-        return "boolean";
+        output << "boolean";
+        return;
     case TypeSignedChar:
     case TypeUnsignedChar:
     case TypeShort:
@@ -866,71 +952,100 @@ std::string DefinitionWriter::tsifyType(const Type& type, const bool isFuncParam
     case TypeULongLong:
     case TypeFloat:
     case TypeDouble:
-        return "number";
+        output << "number";
+        return;
     case TypeUnichar:
     case TypeSelector:
-        return "string";
+        output << "string";
+        return;
     case TypeCString: {
-        std::string res = "string";
+        output << "string";
         if (isFuncParam) {
             Type typeVoid(TypeVoid);
-            res += " | " + tsifyType(::Meta::PointerType(&typeVoid), isFuncParam);
+            output << " | ";
+            // Temporary types are not cached, as their addresses are reused
+            renderType(output, ::Meta::PointerType(&typeVoid), isFuncParam);
         }
-        return res;
+        return;
     }
     case TypeProtocol:
-        return "any /* Protocol */";
+        output << "any /* Protocol */";
+        return;
     case TypeClass:
-        return "typeof " + localizeReference("NSObject", "ObjectiveC");
+        output << "typeof " << localizeReference("NSObject", "ObjectiveC");
+        return;
     case TypeId: {
         const IdType& idType = type.as<IdType>();
         if (idType.protocols.size() == 1) {
             std::string protocol = localizeReference(*idType.protocols[0]);
             // We pass string to be marshalled to NSString which conforms to NSCopying. NSCopying is tricky.
             if (protocol != "NSCopying") {
-                return protocol;
+                output << protocol;
+                return;
             }
         }
-        return "any";
+        output << "any";
+        return;
     }
     case TypeConstantArray:
     case TypeExtVector:
-        return "interop.Reference<" + tsifyType(*type.as<ConstantArrayType>().innerType) + ">";
+        output << "interop.Reference<";
+        output << getRenderedType(*type.as<ConstantArrayType>().innerType, false);
+        output << ">";
+        return;
     case TypeIncompleteArray:
-        return "interop.Reference<" + tsifyType(*type.as<IncompleteArrayType>().innerType) + ">";
+        output << "interop.Reference<";
+        output << getRenderedType(*type.as<IncompleteArrayType>().innerType, false);
+        output << ">";
+        return;
     case TypePointer: {
         const PointerType& pointerType = type.as<PointerType>();
-        return (pointerType.innerType->is(TypeVoid)) ? "interop.Pointer | interop.Reference<any>" : "interop.Pointer | interop.Reference<" + tsifyType(*pointerType.innerType) + ">";
+        if (pointerType.innerType->is(TypeVoid)) {
+            output << "interop.Pointer | interop.Reference<any>";
+        }
+        else {
+            output << "interop.Pointer | interop.Reference<";
+            output << getRenderedType(*pointerType.innerType, false);
+            output << ">";
+        }
+        return;
     }
     case TypeBlock:
-        return writeFunctionProto(type.as<BlockType>().signature);
+        writeFunctionProto(output, type.as<BlockType>().signature);
+        return;
     case TypeFunctionPointer:
-        return "interop.FunctionReference<" + writeFunctionProto(type.as<FunctionPointerType>().signature)
-            + ">";
+        output << "interop.FunctionReference<";
+        writeFunctionProto(output, type.as<FunctionPointerType>().signature);
+        output << ">";
+        return;
     case TypeInterface:
     case TypeBridgedInterface: {
         if (type.is(TypeType::TypeBridgedInterface) && type.as<BridgedInterfaceType>().isId()) {
-            return tsifyType(IdType());
+            renderType(output, IdType(), false);
+            return;
         }
 
         const InterfaceMeta& interface = type.is(TypeType::TypeInterface) ? *type.as<InterfaceType>().interface : *type.as<BridgedInterfaceType>().bridgedInterface;
         if (interface.name == "NSNumber") {
-            return "number";
+            output << "number";
+            return;
         }
         else if (interface.name == "NSString") {
-            return "string";
+            output << "string";
+            return;
         }
         else if (interface.name == "NSDate") {
-            return "Date";
+            output << "Date";
+            return;
         }
     
     if (DefinitionWriter::applyManualChanges) {
             if (interface.name == "UIEvent") {
-                return "_UIEvent";
+                output << "_UIEvent";
+                return;
             }
     }
 
-        std::ostringstream output;
         output << localizeReference(interface);
 
         bool hasClosedGenerics = DefinitionWriter::hasClosedGenerics(type);
@@ -939,10 +1054,12 @@ std::string DefinitionWriter::tsifyType(const Type& type, const bool isFuncParam
             const InterfaceType& interfaceType = type.as<InterfaceType>();
             output << "<";
             for (size_t i = 0; i < interfaceType.typeArguments.size(); i++) {
-                std::string argType = tsifyType(*interfaceType.typeArguments[i]);
-                output << argType;
                 if (i == 0) {
-                    firstElementType = argType;//we only need this for NSArray
+                    firstElementType = getRenderedType(*interfaceType.typeArguments[i], false);//we only need this for NSArray
+                    output << firstElementType;
+                }
+                else {
+                    output << getRenderedType(*interfaceType.typeArguments[i], false);
                 }
                 if (i < interfaceType.typeArguments.size() - 1) {
                     output << ", ";
@@ -952,11 +1069,11 @@ std::string DefinitionWriter::tsifyType(const Type& type, const bool isFuncParam
         }
         else {
             // This also translates CFArray to NSArray<any>
-            if (auto typeParamList = clang::dyn_cast<clang::ObjCInterfaceDecl>(interface.declaration)->getTypeParamListAsWritten()) {
+            if (!interface.typeParameters.empty()) {
                 output << "<";
-                for (size_t i = 0; i < typeParamList->size(); i++) {
+                for (size_t i = 0; i < interface.typeParameters.size(); i++) {
                     output << "any";
-                    if (i < typeParamList->size() - 1) {
+                    if (i < interface.typeParameters.size() - 1) {
                         output << ", ";
                     }
                 }
@@ -966,36 +1083,40 @@ std::string DefinitionWriter::tsifyType(const Type& type, const bool isFuncParam
         
         if (interface.name == "NSArray" && isFuncParam) {
             if (hasClosedGenerics) {
-                std::string arrayType = firstElementType;
-                output << " | " << arrayType << "[]";
+                output << " | " << firstElementType << "[]";
             } else {
                 output << " | any[]";
             }
         }
 
-        return output.str();
+        return;
     }
     case TypeStruct:
-        return localizeReference(*type.as<StructType>().structMeta);
+        output << localizeReference(*type.as<StructType>().structMeta);
+        return;
     case TypeUnion:
-        return localizeReference(*type.as<UnionType>().unionMeta);
+        output << localizeReference(*type.as<UnionType>().unionMeta);
+        return;
     case TypeAnonymousStruct:
     case TypeAnonymousUnion: {
-        std::ostringstream output;
         output << "{ ";
 
         const std::vector<RecordField>& fields = type.as<AnonymousStructType>().fields;
         for (auto& field : fields) {
-            output << field.name << ": " << tsifyType(*field.encoding) << "; ";
+            output << field.name << ": ";
+            output << getRenderedType(*field.encoding, false);
+            output << "; ";
         }
 
         output << "}";
-        return output.str();
+        return;
     }
     case TypeEnum:
-        return localizeReference(*type.as<EnumType>().enumMeta);
+        output << localizeReference(*type.as<EnumType>().enumMeta);
+        return;
     case TypeTypeArgument:
-        return type.as<TypeArgumentType>().name;
+        output << type.as<TypeArgumentType>().name;
+        return;
     case TypeVaList:
     case TypeInstancetype:
     default:
@@ -1003,12 +1124,10 @@ std::string DefinitionWriter::tsifyType(const Type& type, const bool isFuncParam
     }
 
     assert(false);
-    return "";
 }
 
-std::string DefinitionWriter::computeMethodReturnType(const Type* retType, const BaseClassMeta* owner, bool instanceMember)
+void DefinitionWriter::writeMethodReturnType(llvm::raw_ostream& output, const Type* retType, const BaseClassMeta* owner, bool instanceMember)
 {
-    std::ostringstream output;
     if (retType->is(TypeInstancetype)) {
         if (instanceMember) {
             output << "this";
@@ -1025,29 +1144,21 @@ std::string DefinitionWriter::computeMethodReturnType(const Type* retType, const
             
             output << ownerJsName;
             if (owner->is(MetaType::Interface)) {
-                output << getTypeParametersStringOrEmpty(clang::cast<clang::ObjCInterfaceDecl>(static_cast<const InterfaceMeta*>(owner)->declaration));
+                writeTypeParameters(output, *static_cast<const InterfaceMeta*>(owner));
             }
         }
     }
     else {
-        output << tsifyType(*retType);
+        tsifyType(output, *retType);
     }
-
-    return output.str();
 }
 
-std::string DefinitionWriter::write()
+void DefinitionWriter::write()
 {
-    _buffer.clear();
     _importedModules.clear();
     for (::Meta::Meta* meta : _module.second) {
         meta->visit(this);
     }
-
-    std::ostringstream output;
-
-    output << _buffer.str();
-
-    return output.str();
+    _out.flush();
 }
 }
@@ -2,22 +2,31 @@
 
 #include "DocSetManager.h"
 #include "Meta/MetaEntities.h"
-#include <Meta/TypeFactory.h>
-#include <sstream>
+#include <llvm/Support/raw_ostream.h>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace TypeScript {
 class DefinitionWriter : Meta::MetaVisitor {
 public:
-    DefinitionWriter(std::pair<clang::Module*, std::vector<Meta::Meta*> >& module, Meta::TypeFactory& typeFactory, std::string docSetPath)
+    class Context;
+
+    /*
+     * \brief Creates a writer which streams the definitions of a module into the given output.
+     * \param context The caches of the current run. It is shared by the writers of all modules in the run.
+     * \param out The sink for the definitions. It should be buffered (e.g. llvm::raw_fd_ostream) as it receives many small writes.
+     */
+    DefinitionWriter(std::pair<clang::Module*, std::vector<Meta::Meta*> >& module, Context& context, DocSetManager& docSet, llvm::raw_ostream& out)
         : _module(module)
-        , _typeFactory(typeFactory)
-        , _docSet(docSetPath)
+        , _context(context)
+        , _docSet(docSet)
+        , _out(out)
     {
     }
 
-    std::string write();
+    void write();
     
     static bool applyManualChanges;
 
@@ -48,40 +57,103 @@ private:
     using CompoundMemberMap = std::map<std::string, std::pair<Meta::BaseClassMeta*, Member*> >;
 
     void writeMembers(const std::vector<Meta::RecordField>& fields, std::vector<TSComment> fieldsComments);
-    void writeProperty(Meta::PropertyMeta* meta, Meta::BaseClassMeta* owner, Meta::InterfaceMeta* target, CompoundMemberMap<Meta::PropertyMeta> compoundProperties);
+    /*
+     * \brief The members of a class or protocol, resolved through its base classes and conformed protocols. Closer members take precedence.
+     */
+    struct ResolvedMembers {
+        CompoundMemberMap<Meta::MethodMeta> staticMethods;
+        CompoundMemberMap<Meta::MethodMeta> instanceMethods;
+        CompoundMemberMap<Meta::PropertyMeta> staticProperties;
+        CompoundMemberMap<Meta::PropertyMeta> instanceProperties;
+        std::unordered_set<Meta::ProtocolMeta*> protocols;
+    };
+
+    void writeProperty(Meta::PropertyMeta* meta, Meta::BaseClassMeta* owner, Meta::InterfaceMeta* target, const CompoundMemberMap<Meta::PropertyMeta>& compoundProperties);
+    void writeTypeArguments(llvm::raw_ostream& out, const Meta::InterfaceMeta& interface);
+
+    void getInheritedMembersRecursive(Meta::InterfaceMeta* interface,
+        CompoundMemberMap<Meta::MethodMeta>* staticMethods,
+        CompoundMemberMap<Meta::MethodMeta>* instanceMethods,
+        CompoundMemberMap<Meta::PropertyMeta>* staticProperties,
+        CompoundMemberMap<Meta::PropertyMeta>* instanceProperties);
 
-    static void getInheritedMembersRecursive(Meta::InterfaceMeta* interface,
+    static void mergeResolvedMembers(const ResolvedMembers& resolvedMembers,
         CompoundMemberMap<Meta::MethodMeta>* staticMethods,
         CompoundMemberMap<Meta::MethodMeta>* instanceMethods,
         CompoundMemberMap<Meta::PropertyMeta>* staticProperties,
         CompoundMemberMap<Meta::PropertyMeta>* instanceProperties);
 
-    static void getProtocolMembersRecursive(Meta::ProtocolMeta* protocol,
+    void getProtocolMembersRecursive(Meta::ProtocolMeta* protocol,
         CompoundMemberMap<Meta::MethodMeta>* staticMethods,
         CompoundMemberMap<Meta::MethodMeta>* instanceMethods,
         CompoundMemberMap<Meta::PropertyMeta>* staticProperties,
         CompoundMemberMap<Meta::PropertyMeta>* instanceProperties,
         std::unordered_set<Meta::ProtocolMeta*>& visitedProtocols);
 
-    static std::string writeConstructor(const CompoundMemberMap<Meta::MethodMeta>::value_type& initializer,
+    void writeConstructor(llvm::raw_ostream& out, const CompoundMemberMap<Meta::MethodMeta>::value_type& initializer,
         const Meta::BaseClassMeta* owner);
-    static std::string writeMethod(Meta::MethodMeta* meta, Meta::BaseClassMeta* owner, bool canUseThisType = false);
-    static std::string writeMethod(CompoundMemberMap<Meta::MethodMeta>::value_type& method, Meta::BaseClassMeta* owner,
+    void writeMethod(llvm::raw_ostream& out, Meta::MethodMeta* meta, Meta::BaseClassMeta* owner, bool canUseThisType = false);
+    static bool shouldWriteMethod(CompoundMemberMap<Meta::MethodMeta>::value_type& method, Meta::BaseClassMeta* owner,
+        const std::unordered_set<Meta::ProtocolMeta*>& protocols);
+    void writeMethod(llvm::raw_ostream& out, CompoundMemberMap<Meta::MethodMeta>::value_type& method, Meta::BaseClassMeta* owner,
         const std::unordered_set<Meta::ProtocolMeta*>& protocols, bool canUseThisType = false);
-    static std::string writeProperty(Meta::PropertyMeta* meta, Meta::BaseClassMeta* owner, bool optOutTypeChecking);
-    static std::string writeFunctionProto(const std::vector<Meta::Type*>& signature);
+    void writeProperty(llvm::raw_ostream& out, Meta::PropertyMeta* meta, Meta::BaseClassMeta* owner, bool optOutTypeChecking);
     static std::string localizeReference(const std::string& jsName, std::string moduleName);
     static std::string localizeReference(const Meta::Meta& meta);
-    static std::string tsifyType(const Meta::Type& type, const bool isParam = false);
-    static std::string computeMethodReturnType(const Meta::Type* retType, const Meta::BaseClassMeta* owner, bool canUseThisType = false);
-    std::string getTypeArgumentsStringOrEmpty(const clang::ObjCObjectType* objectType);
+    void tsifyType(llvm::raw_ostream& out, const Meta::Type& type, const bool isParam = false);
+    std::string tsifyType(const Meta::Type& type, const bool isParam = false);
+    void writeMethodReturnType(llvm::raw_ostream& out, const Meta::Type* retType, const Meta::BaseClassMeta* owner, bool canUseThisType = false);
 
     static bool hasClosedGenerics(const Meta::Type& type);
 
     std::pair<clang::Module*, std::vector<Meta::Meta*> >& _module;
-    Meta::TypeFactory& _typeFactory;
-    DocSetManager _docSet;
+    Context& _context;
+    DocSetManager& _docSet;
     std::unordered_set<std::string> _importedModules;
-    std::ostringstream _buffer;
+    llvm::raw_ostream& _out;
+};
+
+/*
+ * \class DefinitionWriter::Context
+ * \brief The caches of a single TypeScript generation run, shared by the writers of all its modules.
+ * They are keyed by the addresses of metas and types, so a context must not outlive the metas it was used with.
+ */
+class DefinitionWriter::Context {
+public:
+    Context() = default;
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    /*
+     * \brief Renders in parallel the TypeScript representation of all types used by the given symbols.
+     * Writing these types afterwards is a lookup in the rendered types cache.
+     * \param metas The top level symbols which will be written.
+     */
+    void prerenderTypes(const std::vector<Meta::Meta*>& metas);
+
+private:
+    friend class DefinitionWriter;
+
+    /*
+     * \brief Returns the members inherited by an interface from its base classes (and their protocols). Computed once per interface.
+     */
+    const ResolvedMembers& getInheritedMembers(Meta::InterfaceMeta* interface);
+
+    /*
+     * \brief Returns the members of a protocol and of all protocols it conforms to. Computed once per protocol.
+     */
+    const ResolvedMembers& getProtocolMembers(Meta::ProtocolMeta* protocol);
+
+    const std::string& getRenderedType(const Meta::Type& type, const bool isParam);
+    void renderType(llvm::raw_ostream& out, const Meta::Type& type, const bool isParam);
+    void writeFunctionProto(llvm::raw_ostream& out, const std::vector<Meta::Type*>& signature);
+
+    std::unordered_map<Meta::InterfaceMeta*, ResolvedMembers> _inheritedMembersCache;
+    std::unordered_map<Meta::ProtocolMeta*, ResolvedMembers> _protocolMembersCache;
+
+    // Rendered TypeScript types, indexed by whether the type is rendered as a function parameter
+    std::mutex _renderedTypesMutex;
+    std::unordered_map<const Meta::Type*, std::string> _renderedTypes[2];
 };
 }
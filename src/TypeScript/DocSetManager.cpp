@@ -3,9 +3,14 @@
 //
 
 #include "DocSetManager.h"
+#include <fstream>
+#include <libxml/parser.h>
 #include <libxml/xpath.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ThreadPool.h>
 #include <sstream>
 #include <unistd.h>
+#include <unordered_set>
 
 namespace {
 using namespace std;
@@ -44,11 +49,9 @@ void findAndReplaceIn(string& str, string searchFor, string replaceBy)
     };
 }
 
-xmlNodeSetPtr all(const xmlChar* xpath, xmlDocPtr doc, xmlXPathObjectPtr& result)
+xmlNodeSetPtr all(const xmlChar* xpath, xmlXPathContextPtr context, xmlXPathObjectPtr& result)
 {
-    xmlXPathContextPtr context = xmlXPathNewContext(doc);
     result = xmlXPathEvalExpression(xpath, context);
-    xmlXPathFreeContext(context);
     if (xmlXPathNodeSetIsEmpty(result->nodesetval)) {
         xmlXPathFreeObject(result);
         result = nullptr;
@@ -57,9 +60,9 @@ xmlNodeSetPtr all(const xmlChar* xpath, xmlDocPtr doc, xmlXPathObjectPtr& result
     return result->nodesetval;
 }
 
-xmlNodePtr first(const xmlChar* xpath, xmlDocPtr doc, xmlXPathObjectPtr& result)
+xmlNodePtr first(const xmlChar* xpath, xmlXPathContextPtr context, xmlXPathObjectPtr& result)
 {
-    xmlNodeSetPtr nodes = all(xpath, doc, result);
+    xmlNodeSetPtr nodes = all(xpath, context, result);
     if (nodes && nodes->nodeNr > 0)
         return nodes->nodeTab[0];
     return nullptr;
@@ -83,6 +86,65 @@ vector<string> innerTextOf(xmlNodeSetPtr xmlNodes, xmlDocPtr doc)
     }
     return result;
 }
+
+const char* CacheFileHeader = "docset-comments";
+
+// Comments are cached one per line, so tabs, new lines and backslashes are escaped
+void writeEscaped(std::ostream& out, const string& str)
+{
+    for (char ch : str) {
+        switch (ch) {
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        default:
+            out << ch;
+        }
+    }
+}
+
+vector<string> splitEscaped(const string& line)
+{
+    vector<string> result(1);
+    for (size_t i = 0; i < line.size(); i++) {
+        char ch = line[i];
+        if (ch == '\t') {
+            result.push_back(string());
+        } else if (ch == '\\' && i + 1 < line.size()) {
+            char next = line[++i];
+            result.back().push_back(next == 't' ? '\t' : next == 'n' ? '\n' : next);
+        } else {
+            result.back().push_back(ch);
+        }
+    }
+    return result;
+}
+
+string getCommentKey(const string& name, Meta::MetaType type, const string& parentName, Meta::MetaType parentType)
+{
+    return to_string((int)type) + ":" + to_string((int)parentType) + ":" + parentName + ":" + name;
+}
+
+struct CommentRequest {
+    string name;
+    Meta::MetaType type;
+    string parentName;
+    Meta::MetaType parentType;
+};
+
+void addCommentRequest(vector<CommentRequest>& requests, unordered_set<string>& keys, Meta::Meta* meta, Meta::Meta* parent)
+{
+    CommentRequest request = { meta->name, meta->type, parent ? parent->name : "", parent ? parent->type : Meta::MetaType::Undefined };
+    if (keys.insert(getCommentKey(request.name, request.type, request.parentName, request.parentType)).second) {
+        requests.push_back(request);
+    }
+}
 }
 
 namespace TypeScript {
@@ -108,19 +170,190 @@ std::string TSComment::toString(std::string linePrefix)
     return result.str();
 }
 
+DocSetManager::DocSetManager(std::string docsetPath, bool useIndex)
+    : docsetPath(docsetPath)
+    , tokensPath(docsetPath + "/Contents/Resources/Tokens")
+    , useIndex(useIndex)
+{
+    // Initializes the global state of libxml2 before documents are parsed on multiple threads
+    xmlInitParser();
+    if (this->useIndex && !this->docsetPath.empty()) {
+        this->buildIndex();
+    }
+}
+
 TSComment DocSetManager::getCommentFor(Meta::Meta* meta, Meta::Meta* parent)
 {
     return (parent == nullptr) ? getCommentFor(meta->name, meta->type) : getCommentFor(meta->name, meta->type, parent->name, parent->type);
 }
 
 TSComment DocSetManager::getCommentFor(std::string name, Meta::MetaType type, std::string parentName, Meta::MetaType parentType)
+{
+    if (this->docsetPath.empty()) {
+        return TSComment();
+    }
+
+    std::string key = getCommentKey(name, type, parentName, parentType);
+    {
+        std::lock_guard<std::mutex> lock(this->commentsMutex);
+        std::unordered_map<std::string, TSComment>::iterator it = this->comments.find(key);
+        if (it != this->comments.end()) {
+            return it->second;
+        }
+    }
+
+    TSComment comment = this->createCommentFor(name, type, parentName, parentType);
+
+    std::lock_guard<std::mutex> lock(this->commentsMutex);
+    return this->comments.insert(std::make_pair(key, comment)).first->second;
+}
+
+void DocSetManager::preload(const std::vector<Meta::Meta*>& metas)
+{
+    if (this->docsetPath.empty()) {
+        return;
+    }
+
+    std::vector<CommentRequest> requests;
+    std::unordered_set<std::string> keys;
+    for (Meta::Meta* meta : metas) {
+        addCommentRequest(requests, keys, meta, nullptr);
+        if (meta->is(Meta::MetaType::Interface) || meta->is(Meta::MetaType::Protocol) || meta->is(Meta::MetaType::Category)) {
+            Meta::BaseClassMeta& baseClass = meta->as<Meta::BaseClassMeta>();
+            for (Meta::MethodMeta* method : baseClass.staticMethods) {
+                addCommentRequest(requests, keys, method, meta);
+            }
+            for (Meta::MethodMeta* method : baseClass.instanceMethods) {
+                addCommentRequest(requests, keys, method, meta);
+            }
+            for (Meta::PropertyMeta* property : baseClass.staticProperties) {
+                addCommentRequest(requests, keys, property, meta);
+            }
+            for (Meta::PropertyMeta* property : baseClass.instanceProperties) {
+                addCommentRequest(requests, keys, property, meta);
+            }
+        } else if (meta->is(Meta::MetaType::Enum)) {
+            for (Meta::EnumField& field : meta->as<Meta::EnumMeta>().fullNameFields) {
+                CommentRequest request = { field.name, Meta::MetaType::EnumConstant, "", Meta::MetaType::Undefined };
+                if (keys.insert(getCommentKey(request.name, request.type, request.parentName, request.parentType)).second) {
+                    requests.push_back(request);
+                }
+            }
+        }
+    }
+
+    llvm::ThreadPool pool;
+    for (CommentRequest& request : requests) {
+        pool.async([this, &request]() {
+            this->getCommentFor(request.name, request.type, request.parentName, request.parentType);
+        });
+    }
+    pool.wait();
+}
+
+bool DocSetManager::loadCache(const std::string& cachePath)
+{
+    std::ifstream file(cachePath);
+    if (!file) {
+        return false;
+    }
+
+    std::string version = this->getDocSetVersion();
+    std::string line;
+    if (version.empty() || !std::getline(file, line) || line != std::string(CacheFileHeader) + "\t" + version) {
+        return false;
+    }
+
+    std::unordered_map<std::string, TSComment> loadedComments;
+    while (std::getline(file, line)) {
+        // key, description, params count, (param name, param description)..., fields count, field description...
+        std::vector<std::string> parts = splitEscaped(line);
+        if (parts.size() < 4) {
+            return false;
+        }
+
+        TSComment comment;
+        comment.description = parts[1];
+        size_t index = 2;
+        size_t paramsCount = std::strtoul(parts[index++].c_str(), nullptr, 10);
+        if (parts.size() < index + paramsCount * 2 + 1) {
+            return false;
+        }
+        for (size_t i = 0; i < paramsCount; i++, index += 2) {
+            comment.params.push_back(std::make_pair(parts[index], parts[index + 1]));
+        }
+        size_t fieldsCount = std::strtoul(parts[index++].c_str(), nullptr, 10);
+        if (parts.size() != index + fieldsCount) {
+            return false;
+        }
+        for (size_t i = 0; i < fieldsCount; i++) {
+            TSComment fieldComment;
+            fieldComment.description = parts[index++];
+            comment.fields.push_back(fieldComment);
+        }
+        loadedComments[parts[0]] = comment;
+    }
+
+    std::lock_guard<std::mutex> lock(this->commentsMutex);
+    this->comments.insert(loadedComments.begin(), loadedComments.end());
+    return true;
+}
+
+void DocSetManager::saveCache(const std::string& cachePath)
+{
+    std::string version = this->getDocSetVersion();
+    if (version.empty()) {
+        return;
+    }
+
+    std::ostringstream file;
+    file << CacheFileHeader << "\t" << version << std::endl;
+
+    std::lock_guard<std::mutex> lock(this->commentsMutex);
+    for (std::pair<const std::string, TSComment>& pair : this->comments) {
+        TSComment& comment = pair.second;
+        writeEscaped(file, pair.first);
+        file << "\t";
+        writeEscaped(file, comment.description);
+        file << "\t" << comment.params.size();
+        for (std::pair<std::string, std::string>& param : comment.params) {
+            file << "\t";
+            writeEscaped(file, param.first);
+            file << "\t";
+            writeEscaped(file, param.second);
+        }
+        file << "\t" << comment.fields.size();
+        for (TSComment& field : comment.fields) {
+            file << "\t";
+            writeEscaped(file, field.description);
+        }
+        file << std::endl;
+    }
+
+    // The cache is also an input of the generation, so its modification time changes only with its contents
+    std::ifstream existingFile(cachePath);
+    std::string existingContents((std::istreambuf_iterator<char>(existingFile)), std::istreambuf_iterator<char>());
+    if (!existingFile || existingContents != file.str()) {
+        std::ofstream(cachePath) << file.str();
+    }
+}
+
+std::vector<std::string> DocSetManager::getReadFiles()
+{
+    std::lock_guard<std::mutex> lock(this->readFilesMutex);
+    return std::vector<std::string>(this->readFiles.begin(), this->readFiles.end());
+}
+
+TSComment DocSetManager::createCommentFor(const std::string& name, Meta::MetaType type, const std::string& parentName, Meta::MetaType parentType)
 {
     xmlDocPtr doc = getXmlDocFileFor(name, type, parentName, parentType);
 
     TSComment comment;
     if (doc) {
+        // A single XPath context is used for all queries against the document
+        xmlXPathContextPtr context = xmlXPathNewContext(doc);
         xmlXPathObjectPtr abstractNodeResult = nullptr;
-        xmlNodePtr abstractNode = first(reinterpret_cast<const xmlChar*>("/*/Abstract"), doc, abstractNodeResult);
+        xmlNodePtr abstractNode = first(reinterpret_cast<const xmlChar*>("/*/Abstract"), context, abstractNodeResult);
         if (abstractNode != nullptr) {
             std::string description = innerTextOf(abstractNode, doc);
             comment.description = trim(description);
@@ -130,10 +363,10 @@ TSComment DocSetManager::getCommentFor(std::string name, Meta::MetaType type, st
         case Meta::MetaType::Method:
         case Meta::MetaType::Function: {
             xmlXPathObjectPtr termNodesResult = nullptr;
-            std::vector<string> paramNames = innerTextOf(all(reinterpret_cast<const xmlChar*>("/*/Parameters/Parameter/Term"), doc, termNodesResult), doc);
+            std::vector<string> paramNames = innerTextOf(all(reinterpret_cast<const xmlChar*>("/*/Parameters/Parameter/Term"), context, termNodesResult), doc);
             if (paramNames.size() > 0) {
                 xmlXPathObjectPtr discussionNodesResult = nullptr;
-                std::vector<string> paramDescs = innerTextOf(all(reinterpret_cast<const xmlChar*>("/*/Parameters/Parameter/Discussion"), doc, discussionNodesResult), doc);
+                std::vector<string> paramDescs = innerTextOf(all(reinterpret_cast<const xmlChar*>("/*/Parameters/Parameter/Discussion"), context, discussionNodesResult), doc);
                 assert(paramNames.size() == paramDescs.size());
 
                 for (size_t i = 0; i < paramNames.size(); i++) {
@@ -147,7 +380,7 @@ TSComment DocSetManager::getCommentFor(std::string name, Meta::MetaType type, st
         case Meta::MetaType::Struct:
         case Meta::MetaType::Union: {
             xmlXPathObjectPtr discussionNodesResult = nullptr;
-            std::vector<string> fieldsDescs = innerTextOf(all(reinterpret_cast<const xmlChar*>("/*/Fields/Field/Discussion"), doc, discussionNodesResult), doc);
+            std::vector<string> fieldsDescs = innerTextOf(all(reinterpret_cast<const xmlChar*>("/*/Fields/Field/Discussion"), context, discussionNodesResult), doc);
             if (fieldsDescs.size() > 0) {
                 for (size_t i = 0; i < fieldsDescs.size(); i++) {
                     TSComment fieldComment;
@@ -163,72 +396,136 @@ TSComment DocSetManager::getCommentFor(std::string name, Meta::MetaType type, st
         }
         }
         xmlXPathFreeObject(abstractNodeResult);
+        xmlXPathFreeContext(context);
     }
 
     xmlFreeDoc(doc);
     return comment;
 }
 
-xmlDocPtr DocSetManager::getXmlDocFileFor(std::string name, Meta::MetaType type, std::string parentName, Meta::MetaType parentType)
+std::vector<std::string> DocSetManager::getXmlDocFileCandidatesFor(const std::string& name, Meta::MetaType type, const std::string& parentName, Meta::MetaType parentType)
 {
     std::string parent = (parentName == "") ? "-" : parentName;
     std::vector<std::string> xmlPathCandidates;
     switch (type) {
     case Meta::MetaType::Struct: {
-        xmlPathCandidates.push_back(this->tokensPath + "/c/tdef/" + parent + "/" + name + ".xml");
-        xmlPathCandidates.push_back(this->tokensPath + "/c/tag/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("c/tdef/" + parent + "/" + name);
+        xmlPathCandidates.push_back("c/tag/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Function: {
-        xmlPathCandidates.push_back(this->tokensPath + "/c/func/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("c/func/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Enum: {
-        xmlPathCandidates.push_back(this->tokensPath + "/c/tdef/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("c/tdef/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::EnumConstant: {
-        xmlPathCandidates.push_back(this->tokensPath + "/c/econst/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("c/econst/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Var: {
-        xmlPathCandidates.push_back(this->tokensPath + "/c/data/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("c/data/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Interface: {
-        xmlPathCandidates.push_back(this->tokensPath + "/Objective-C/cl/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("Objective-C/cl/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Protocol: {
-        xmlPathCandidates.push_back(this->tokensPath + "/Objective-C/intf/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("Objective-C/intf/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Category: {
-        xmlPathCandidates.push_back(this->tokensPath + "/Objective-C/cat/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("Objective-C/cat/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Method: {
         std::string type1 = (parentType == Meta::MetaType::Interface) ? "instm" : "intfm";
         std::string type2 = (parentType == Meta::MetaType::Interface) ? "clm" : "intfcm";
-        xmlPathCandidates.push_back(this->tokensPath + "/Objective-C/" + type1 + "/" + parent + "/" + name + ".xml");
-        xmlPathCandidates.push_back(this->tokensPath + "/Objective-C/" + type2 + "/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("Objective-C/" + type1 + "/" + parent + "/" + name);
+        xmlPathCandidates.push_back("Objective-C/" + type2 + "/" + parent + "/" + name);
         break;
     }
     case Meta::MetaType::Property: {
         std::string type = (parentType == Meta::MetaType::Interface) ? "instp" : "intfp";
-        xmlPathCandidates.push_back(this->tokensPath + "/Objective-C/" + type + "/" + parent + "/" + name + ".xml");
+        xmlPathCandidates.push_back("Objective-C/" + type + "/" + parent + "/" + name);
         break;
     }
     default: {
         break;
     }
     }
+    return xmlPathCandidates;
+}
 
-    for (string& path : xmlPathCandidates) {
-        if (access(path.c_str(), F_OK) == 0) {
+xmlDocPtr DocSetManager::getXmlDocFileFor(const std::string& name, Meta::MetaType type, const std::string& parentName, Meta::MetaType parentType)
+{
+    for (string& candidate : getXmlDocFileCandidatesFor(name, type, parentName, parentType)) {
+        std::string path;
+        if (this->useIndex) {
+            std::unordered_map<std::string, std::string>::const_iterator it = this->index.find(candidate);
+            if (it != this->index.end()) {
+                path = it->second;
+            }
+        } else {
+            path = this->tokensPath + "/" + candidate + ".xml";
+            if (access(path.c_str(), F_OK) != 0) {
+                path.clear();
+            }
+        }
+        if (!path.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(this->readFilesMutex);
+                this->readFiles.insert(path);
+            }
             return xmlReadFile(path.c_str(), nullptr, 0);
         }
     }
     return nullptr;
 }
+
+void DocSetManager::buildIndex()
+{
+    // The Tokens folder is laid out as <language>/<token type>/<parent>/<name>.xml
+    std::error_code error;
+    for (llvm::sys::fs::recursive_directory_iterator it(this->tokensPath, error), end; it != end && !error; it.increment(error)) {
+        llvm::StringRef path = it->path();
+        if (path.endswith(".xml") && path.size() > this->tokensPath.size() + 1) {
+            llvm::StringRef key = path.drop_front(this->tokensPath.size() + 1).drop_back(4);
+            this->index[key.str()] = path.str();
+        }
+    }
+}
+
+std::string DocSetManager::getDocSetVersion()
+{
+    std::string infoPlistPath = this->docsetPath + "/Contents/Info.plist";
+    if (this->docsetPath.empty() || access(infoPlistPath.c_str(), F_OK) != 0) {
+        return std::string();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->readFilesMutex);
+        this->readFiles.insert(infoPlistPath);
+    }
+    xmlDocPtr doc = xmlReadFile(infoPlistPath.c_str(), nullptr, 0);
+    if (!doc) {
+        return std::string();
+    }
+
+    std::string version;
+    xmlXPathContextPtr context = xmlXPathNewContext(doc);
+    xmlXPathObjectPtr versionNodeResult = nullptr;
+    xmlNodePtr versionNode = first(reinterpret_cast<const xmlChar*>("/plist/dict/key[text()='CFBundleVersion']/following-sibling::*[1]"), context, versionNodeResult);
+    if (versionNode != nullptr) {
+        version = innerTextOf(versionNode, doc);
+        trim(version);
+    }
+    xmlXPathFreeObject(versionNodeResult);
+    xmlXPathFreeContext(context);
+    xmlFreeDoc(doc);
+    return version;
+}
 }
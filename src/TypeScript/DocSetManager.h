@@ -6,6 +6,9 @@
 #define METADATAGENERATOR_DOCSETPARSER_H
 
 #include <Meta/MetaEntities.h>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 struct _xmlDoc;
 
@@ -44,11 +47,12 @@ struct TSComment {
  */
 class DocSetManager {
 public:
-    DocSetManager(std::string docsetPath)
-        : docsetPath(docsetPath)
-        , tokensPath(docsetPath + "/Contents/Resources/Tokens")
-    {
-    }
+    /*
+     * \brief Creates a manager for the given docset.
+     * \param docsetPath The path to the .docset package. If empty, no comments are generated.
+     * \param useIndex If true, the Tokens tree of the docset is scanned once into an in-memory index which replaces the per-symbol filesystem lookups.
+     */
+    DocSetManager(std::string docsetPath, bool useIndex = false);
 
     /*
      * \brief Retrieves a TypeScript comment for a given symbol. If the symbol is a member (e.g. method or property) a parent must be supplied, too.
@@ -59,18 +63,61 @@ public:
 
     TSComment getCommentFor(std::string name, Meta::MetaType type, std::string parentName = "", Meta::MetaType parentType = Meta::MetaType::Undefined);
 
+    /*
+     * \brief Parses in parallel the documentation of the given symbols and their members and caches the resulting comments.
+     * \param metas The top level symbols which will be queried later.
+     */
+    void preload(const std::vector<Meta::Meta*>& metas);
+
+    /*
+     * \brief Loads previously cached comments. The cache is ignored if it was saved for a different docset version.
+     * \param cachePath The path of the cache file.
+     * \return true if the cache was loaded.
+     */
+    bool loadCache(const std::string& cachePath);
+
+    /*
+     * \brief Saves all comments retrieved so far, keyed by the version of the docset. An unchanged cache file isn't rewritten.
+     * \param cachePath The path of the cache file.
+     */
+    void saveCache(const std::string& cachePath);
+
+    /*
+     * \brief Returns the paths of the docset files which have been read so far - the Info.plist and the XML documentation files.
+     */
+    std::vector<std::string> getReadFiles();
+
 private:
     /*
-     * \brief Tries to find the location and parses the XML documentation file for a symbol with the given name and type. Null is returned if unable to find a doc file.
+     * \brief Returns the paths, relative to the Tokens folder and without extension, at which the XML documentation file of a symbol can be located.
      * \param name The name of the symbol.
      * \param type The type of the symbol. Depending on the type, different foldeers will be examined.
      * \param parentName If the symbol is method or property, a parent (the containing Interface or Protocol) must be passed, too, in order to find the correct XML file location.
      * \param parentType The type of the parent symbol.
      */
-    _xmlDoc* getXmlDocFileFor(std::string name, Meta::MetaType type, std::string parentName = "", Meta::MetaType parentType = Meta::MetaType::Undefined);
+    std::vector<std::string> getXmlDocFileCandidatesFor(const std::string& name, Meta::MetaType type, const std::string& parentName, Meta::MetaType parentType);
+
+    /*
+     * \brief Tries to find the location and parses the XML documentation file for a symbol with the given name and type. Null is returned if unable to find a doc file.
+     */
+    _xmlDoc* getXmlDocFileFor(const std::string& name, Meta::MetaType type, const std::string& parentName, Meta::MetaType parentType);
+
+    TSComment createCommentFor(const std::string& name, Meta::MetaType type, const std::string& parentName, Meta::MetaType parentType);
+
+    void buildIndex();
+
+    std::string getDocSetVersion();
 
     std::string docsetPath;
     std::string tokensPath;
+    bool useIndex;
+    std::unordered_map<std::string, std::string> index;
+
+    std::mutex commentsMutex;
+    std::unordered_map<std::string, TSComment> comments;
+
+    std::mutex readFilesMutex;
+    std::set<std::string> readFiles;
 };
 }
 
@@ -1,4 +1,6 @@
 #include "memoryStream.h"
+#include <algorithm>
+#include <cassert>
 #include <vector>
 
 unsigned long utils::MemoryStream::size()
@@ -17,6 +19,12 @@ void utils::MemoryStream::push_byte(uint8_t b)
     this->_position++;
 }
 
+void utils::MemoryStream::overwrite(unsigned long position, utils::MemoryStream& bytes)
+{
+    assert(position + bytes.size() <= this->_heap.size());
+    std::copy(bytes.begin(), bytes.end(), this->_heap.begin() + position);
+}
+
 std::vector<uint8_t>::iterator utils::MemoryStream::begin()
 {
     return this->_heap.begin();
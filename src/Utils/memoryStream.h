@@ -30,6 +30,13 @@ public:
          */
     virtual void push_byte(uint8_t b) override;
 
+    /*
+         * \brief Replaces the bytes at the given position with the contents of another stream.
+         *
+         * Unlike \c push_byte, this neither inserts bytes nor moves the current position.
+         */
+    void overwrite(unsigned long position, MemoryStream& bytes);
+
     /*
          * \brief Returns an iterator pointing to the first element in this stream.
          */
@@ -0,0 +1,74 @@
+#include "outputCapture.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <llvm/Support/raw_ostream.h>
+#include <stdexcept>
+#include <unistd.h>
+
+static void flushAll()
+{
+    std::cout.flush();
+    std::cerr.flush();
+    llvm::outs().flush();
+    llvm::errs().flush();
+    std::fflush(stdout);
+    std::fflush(stderr);
+}
+
+utils::OutputCapture::OutputCapture()
+    : _file(std::tmpfile())
+    , _stdout(-1)
+    , _stderr(-1)
+{
+    if (this->_file == nullptr) {
+        throw std::runtime_error(std::string("Unable to create a file for the output: ") + std::strerror(errno));
+    }
+
+    flushAll();
+    this->_stdout = ::dup(STDOUT_FILENO);
+    this->_stderr = ::dup(STDERR_FILENO);
+    if (this->_stdout < 0 || this->_stderr < 0 || ::dup2(::fileno(this->_file), STDOUT_FILENO) < 0 || ::dup2(::fileno(this->_file), STDERR_FILENO) < 0) {
+        std::string error = std::strerror(errno);
+        this->restore();
+        throw std::runtime_error("Unable to redirect the output: " + error);
+    }
+}
+
+utils::OutputCapture::~OutputCapture()
+{
+    this->restore();
+}
+
+void utils::OutputCapture::restore()
+{
+    if (this->_file == nullptr) {
+        return;
+    }
+
+    flushAll();
+    if (this->_stdout >= 0) {
+        ::dup2(this->_stdout, STDOUT_FILENO);
+        ::close(this->_stdout);
+    }
+    if (this->_stderr >= 0) {
+        ::dup2(this->_stderr, STDERR_FILENO);
+        ::close(this->_stderr);
+    }
+    std::fclose(this->_file);
+    this->_file = nullptr;
+}
+
+std::string utils::OutputCapture::finish()
+{
+    flushAll();
+    std::string output;
+    std::rewind(this->_file);
+    char buffer[4096];
+    size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), this->_file)) > 0) {
+        output.append(buffer, size);
+    }
+    this->restore();
+    return output;
+}
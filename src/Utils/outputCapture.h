@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Noncopyable.h"
+#include <cstdio>
+#include <string>
+
+namespace utils {
+/*
+     * \class OutputCapture
+     * \brief Redirects the standard output and the standard error of the process to a temporary file while it exists.
+     *
+     * The descriptors themselves are redirected, so everything written to them is captured: \c std::cout, \c std::cerr,
+     * \c llvm::outs(), \c llvm::errs() and the diagnostics of clang. Failures are reported with \c std::runtime_error.
+     */
+class OutputCapture {
+    MAKE_NONCOPYABLE(OutputCapture);
+
+public:
+    OutputCapture();
+
+    /*
+         * \brief Restores the standard output and the standard error, if \c finish hasn't been called.
+         */
+    ~OutputCapture();
+
+    /*
+         * \brief Restores the standard output and the standard error and returns everything written to them.
+         */
+    std::string finish();
+
+private:
+    void restore();
+
+    std::FILE* _file;
+    int _stdout;
+    int _stderr;
+};
+}
@@ -0,0 +1,141 @@
+#include "unixSocket.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::runtime_error socketError(const std::string& message)
+{
+    return std::runtime_error(message + ": " + std::strerror(errno));
+}
+
+static sockaddr_un createAddress(const std::string& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("The socket path " + path + " is too long.");
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+utils::UnixSocket::~UnixSocket()
+{
+    ::close(this->_descriptor);
+    if (!this->_path.empty()) {
+        ::unlink(this->_path.c_str());
+    }
+}
+
+std::unique_ptr<utils::UnixSocket> utils::UnixSocket::listen(const std::string& path)
+{
+    sockaddr_un address = createAddress(path);
+    int descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor < 0) {
+        throw socketError("Unable to create a socket");
+    }
+    // The socket owns the descriptor from here on
+    std::unique_ptr<UnixSocket> result(new UnixSocket(descriptor, std::string()));
+
+    // A socket left by a previous server is replaced, but any other file at the path is kept
+    struct stat status;
+    if (::lstat(path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            throw std::runtime_error("Unable to listen at " + path + ": the path exists and is not a socket.");
+        }
+        ::unlink(path.c_str());
+    }
+    if (::bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        throw socketError("Unable to bind a socket to " + path);
+    }
+    result->_path = path;
+    if (::listen(descriptor, SOMAXCONN) != 0) {
+        throw socketError("Unable to listen at " + path);
+    }
+    return result;
+}
+
+std::unique_ptr<utils::UnixSocket> utils::UnixSocket::connect(const std::string& path)
+{
+    sockaddr_un address = createAddress(path);
+    int descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor < 0) {
+        throw socketError("Unable to create a socket");
+    }
+    std::unique_ptr<UnixSocket> result(new UnixSocket(descriptor, std::string()));
+
+    if (::connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        throw socketError("Unable to connect to " + path);
+    }
+    return result;
+}
+
+std::unique_ptr<utils::UnixSocket> utils::UnixSocket::accept()
+{
+    int descriptor;
+    do {
+        descriptor = ::accept(this->_descriptor, nullptr, nullptr);
+    } while (descriptor < 0 && errno == EINTR);
+
+    if (descriptor < 0) {
+        throw socketError("Unable to accept a connection at " + this->_path);
+    }
+    return std::unique_ptr<UnixSocket>(new UnixSocket(descriptor, std::string()));
+}
+
+void utils::UnixSocket::sendMessage(const std::vector<std::string>& strings)
+{
+    std::string data;
+    for (const std::string& string : strings) {
+        data.append(string);
+        data.push_back('\0');
+    }
+
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t count = ::write(this->_descriptor, data.data() + sent, data.size() - sent);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            throw socketError("Unable to send a message");
+        }
+        sent += count;
+    }
+    ::shutdown(this->_descriptor, SHUT_WR);
+}
+
+std::vector<std::string> utils::UnixSocket::receiveMessage()
+{
+    std::string data;
+    char buffer[4096];
+    while (true) {
+        ssize_t count = ::read(this->_descriptor, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw socketError("Unable to receive a message");
+        }
+        if (count == 0) {
+            break;
+        }
+        data.append(buffer, count);
+    }
+
+    if (!data.empty() && data.back() != '\0') {
+        throw std::runtime_error("Received an incomplete message.");
+    }
+    std::vector<std::string> strings;
+    for (size_t start = 0; start < data.size();) {
+        size_t end = data.find('\0', start);
+        strings.push_back(data.substr(start, end - start));
+        start = end + 1;
+    }
+    return strings;
+}
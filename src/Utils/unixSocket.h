@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Noncopyable.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utils {
+/*
+     * \class UnixSocket
+     * \brief A stream socket bound to a path in the file system, either listening for connections or connected to a peer.
+     *
+     * Messages are sequences of strings, each one terminated by a null character. The sender of a message closes
+     * its writing side after it, so each connection carries one message in each direction.
+     * Failures are reported with \c std::runtime_error.
+     */
+class UnixSocket {
+    MAKE_NONCOPYABLE(UnixSocket);
+
+public:
+    /*
+         * \brief Closes the socket. A listening socket also removes its path.
+         */
+    ~UnixSocket();
+
+    /*
+         * \brief Creates a socket which listens at the given path. A socket which already exists at the path is replaced, any other file is an error.
+         */
+    static std::unique_ptr<UnixSocket> listen(const std::string& path);
+
+    static std::unique_ptr<UnixSocket> connect(const std::string& path);
+
+    /*
+         * \brief Waits for the next connection to a listening socket.
+         */
+    std::unique_ptr<UnixSocket> accept();
+
+    void sendMessage(const std::vector<std::string>& strings);
+
+    std::vector<std::string> receiveMessage();
+
+private:
+    UnixSocket(int descriptor, const std::string& path)
+        : _descriptor(descriptor)
+        , _path(path)
+    {
+    }
+
+    int _descriptor;
+
+    // The path of a listening socket, empty for connections
+    std::string _path;
+};
+}
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "MetaYamlTraits.h"
+#include <algorithm>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ThreadPool.h>
 #include <string>
+#include <thread>
 
 namespace Yaml {
 class YamlSerializer {
@@ -10,13 +13,82 @@ public:
     template <class T>
     static void serialize(std::string outputFilePath, T& object)
     {
+        std::string error = write(outputFilePath, object);
+        if (!error.empty())
+            throw std::runtime_error(error);
+    }
+
+    /*
+     * \brief Serializes every module of the container in its own <module name>.yaml file in the output folder.
+     * \param jobs The maximum number of files formatted and written at the same time. 0 means one per hardware thread and 1 serializes the modules sequentially.
+     *
+     * The contents of each file are the same regardless of the number of jobs.
+     */
+    template <class Container>
+    static void serializeModules(const std::string& outputFolder, Container& modules, unsigned jobs)
+    {
+        if (jobs == 0) {
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Each module has its own error slot, so the first failure in container order is reported
+        std::vector<std::string> errors(modules.size());
+        auto serializeModule = [&outputFolder, &modules, &errors](size_t i) {
+            std::string filePath = outputFolder + "/" + modules[i].first->getFullModuleName() + ".yaml";
+            errors[i] = write(filePath, modules[i]);
+        };
+
+        if (jobs == 1) {
+            for (size_t i = 0; i < modules.size(); i++) {
+                serializeModule(i);
+            }
+        } else {
+            // The pool bounds the number of formatted files which are held in memory at the same time
+            llvm::ThreadPool pool(jobs);
+            for (size_t i = 0; i < modules.size(); i++) {
+                pool.async(serializeModule, i);
+            }
+            pool.wait();
+        }
+
+        for (const std::string& error : errors) {
+            if (!error.empty())
+                throw std::runtime_error(error);
+        }
+    }
+
+private:
+    static const size_t InitialBufferSize = 1 << 20;
+
+    /*
+     * \brief Formats the object in memory and writes it to the file at once.
+     * \return The error message if the file can't be written, or an empty string.
+     */
+    template <class T>
+    static std::string write(const std::string& outputFilePath, T& object)
+    {
+        std::string contents;
+        contents.reserve(InitialBufferSize);
+        {
+            llvm::raw_string_ostream contentsStream(contents);
+            llvm::yaml::Output output(contentsStream);
+            output << object;
+            contentsStream.flush();
+        }
+
         std::error_code errorCode;
         llvm::raw_fd_ostream fileStream(outputFilePath, errorCode, llvm::sys::fs::OpenFlags::F_None);
         if (errorCode)
-            throw std::runtime_error(std::string("Unable to open file ") + outputFilePath + ".");
-        llvm::yaml::Output output(fileStream);
-        output << object;
+            return std::string("Unable to open file ") + outputFilePath + ".";
+        fileStream.SetUnbuffered();
+        fileStream << contents;
         fileStream.close();
+        if (fileStream.has_error()) {
+            // An unhandled error of raw_fd_ostream is fatal when it's destroyed
+            fileStream.clear_error();
+            return std::string("Unable to write file ") + outputFilePath + ".";
+        }
+        return std::string();
     }
 };
 }
@@ -1,45 +1,497 @@
 #include "Binary/binarySerializer.h"
 #include "HeadersParser/Parser.h"
 #include "Meta/DeclarationConverterVisitor.h"
+#include "Meta/Diagnostics.h"
 #include "Meta/Filters/HandleExceptionalMetasFilter.h"
 #include "Meta/Filters/HandleMethodsAndPropertiesWithSameNameFilter.h"
 #include "Meta/Filters/MergeCategoriesFilter.h"
 #include "Meta/Filters/ModulesBlacklist.h"
 #include "Meta/Filters/RemoveDuplicateMembersFilter.h"
 #include "Meta/Filters/ResolveGlobalNamesCollisionsFilter.h"
+#include "Meta/MetaSnapshot.h"
 #include "TypeScript/DefinitionWriter.h"
 #include "TypeScript/DocSetManager.h"
+#include "Utils/outputCapture.h"
+#include "Utils/unixSocket.h"
 #include "Yaml/YamlSerializer.h"
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Tooling/Tooling.h>
+#include <csignal>
 #include <fstream>
+#include <llvm/ADT/Triple.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/ThreadPool.h>
+#include <map>
 #include <pwd.h>
+#include <set>
 #include <sstream>
+#include <unistd.h>
 
 // Command line parameters
 llvm::cl::opt<bool>   cla_verbose("verbose", llvm::cl::desc("Set verbose output mode"), llvm::cl::value_desc("bool"));
+llvm::cl::opt<Meta::DiagnosticLevel> cla_diagnosticsLevel("diagnostics-level", llvm::cl::desc("Set the level of the logged diagnostics (-verbose is the same as 'verbose')"), llvm::cl::init(Meta::DiagnosticLevel::Warning),
+    llvm::cl::values(clEnumValN(Meta::DiagnosticLevel::Error, "error", "Only errors"),
+                     clEnumValN(Meta::DiagnosticLevel::Warning, "warning", "Errors and warnings"),
+                     clEnumValN(Meta::DiagnosticLevel::Verbose, "verbose", "Also included and blacklisted symbols and failed declarations"),
+                     clEnumValN(Meta::DiagnosticLevel::Debug, "debug", "Also the reasons for skipping unsupported declarations")));
+llvm::cl::opt<string> cla_symbolsReportFile("symbols-report", llvm::cl::desc("Specify a file in which the included, blacklisted and skipped symbols are listed in tab-separated format"), llvm::cl::value_desc("<file_path>"));
 llvm::cl::opt<bool>   cla_strictIncludes("strict-includes", llvm::cl::desc("Set strict include headers for diagnostic purposes (usually when some metadata is not generated due to wrong import or include statement)"), llvm::cl::value_desc("bool"));
 llvm::cl::opt<string> cla_outputUmbrellaHeaderFile("output-umbrella", llvm::cl::desc("Specify the output umbrella header file"), llvm::cl::value_desc("file_path"));
 llvm::cl::opt<string> cla_inputUmbrellaHeaderFile("input-umbrella", llvm::cl::desc("Specify the input umbrella header file"), llvm::cl::value_desc("file_path"));
 llvm::cl::opt<string> cla_outputYamlFolder("output-yaml", llvm::cl::desc("Specify the output yaml folder"), llvm::cl::value_desc("<dir_path>"));
+llvm::cl::opt<unsigned> cla_yamlJobs("yaml-jobs", llvm::cl::desc("Specify the maximum number of YAML files written in parallel (0 - one per CPU core, 1 - sequentially)"), llvm::cl::init(0));
 llvm::cl::opt<string> cla_outputModuleMapsFolder("output-modulemaps", llvm::cl::desc("Specify the fodler where modulemap files of all parsed modules will be dumped"), llvm::cl::value_desc("<dir_path>"));
 llvm::cl::opt<string> cla_outputBinFile("output-bin", llvm::cl::desc("Specify the output binary metadata file"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::opt<binary::BinaryFormatVersion> cla_binaryFormat("binary-format", llvm::cl::desc("Set the version of the binary metadata format"), llvm::cl::init(binary::BinaryFormatLatest),
+    llvm::cl::values(clEnumValN(binary::BinaryFormatLegacy, "legacy", "Every method and property has its own method records and type encodings"),
+                     clEnumValN(binary::BinaryFormatSharedMembers, "shared-members", "Property accessors and equal type encodings are stored once"),
+                     clEnumValN(binary::BinaryFormatMembersIndex, "members-index", "Large interfaces and protocols also have a hash index of their members (default)")));
+llvm::cl::opt<binary::BinaryLayout> cla_binaryLayout("binary-layout", llvm::cl::desc("Set the order of the records in the heap of the binary metadata"), llvm::cl::init(binary::BinaryLayout::Sequential),
+    llvm::cl::values(clEnumValN(binary::BinaryLayout::Sequential, "sequential", "Strings and type encodings are shared by the whole file (default)"),
+                     clEnumValN(binary::BinaryLayout::Clustered, "clustered", "Each symbol is followed by its members, type encodings and strings, so the runtime loads fewer pages")));
+llvm::cl::opt<string> cla_binaryHotModulesFile("binary-hot-modules", llvm::cl::desc("Specify a file with a top level module name on each line. The metadata of the listed modules is written first, in the listed order"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::opt<string> cla_orderFile("order-file", llvm::cl::desc("Specify a file with a JS symbol name on each line, e.g. the symbols resolved by the runtime during the app launch. Their records and global table buckets are written at the beginning of the binary metadata heap, in the listed order"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::opt<unsigned> cla_binaryCompressionBlockSize("binary-compression-block-size", llvm::cl::desc("Specify the size of the independently compressed blocks of the binary metadata heap (0 - uncompressed). The global tables, the module records in the clustered layout and the symbols of the order file stay uncompressed"), llvm::cl::init(0), llvm::cl::value_desc("<bytes>"));
 llvm::cl::opt<string> cla_outputDtsFolder("output-typescript", llvm::cl::desc("Specify the output .d.ts folder"), llvm::cl::value_desc("<dir_path>"));
+llvm::cl::opt<string> cla_outputDtsManifestFile("output-typescript-manifest", llvm::cl::desc("Specify a JSON file in which the MD5 hash of each generated .d.ts file is written, keyed by its path relative to the -output-typescript folder"), llvm::cl::value_desc("<file_path>"));
 llvm::cl::opt<string> cla_docSetFile("docset-path", llvm::cl::desc("Specify the path to the iOS SDK docset package"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::opt<bool>   cla_docSetIndex("docset-index", llvm::cl::desc("Specify whether to index the docset once and parse its documentation files in parallel instead of looking up each symbol on disk"), llvm::cl::init(true));
+llvm::cl::opt<string> cla_docSetCacheFile("docset-cache", llvm::cl::desc("Specify a file in which comments extracted from the docset are cached between runs"), llvm::cl::value_desc("<file_path>"));
 llvm::cl::opt<string> cla_blackListModuleRegexesFile("blacklist-modules-file", llvm::cl::desc("Specify the metadata entries blacklist file containing regexes of module names on each line"), llvm::cl::value_desc("file_path"));
 llvm::cl::opt<string> cla_whiteListModuleRegexesFile("whitelist-modules-file", llvm::cl::desc("Specify the metadata entries whitelist file containing regexes of module names on each line"), llvm::cl::value_desc("file_path"));
 llvm::cl::opt<bool>   cla_applyManualDtsChanges("apply-manual-dts-changes", llvm::cl::desc("Specify whether to disable manual adjustments to generated .d.ts files for specific erroneous cases in the iOS SDK"), llvm::cl::init(true));
+llvm::cl::opt<string> cla_outputSnapshotFile("output-snapshot", llvm::cl::desc("Specify a file in which the filtered metadata is saved, so that the outputs can be regenerated from it with -input-snapshot"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::opt<string> cla_inputSnapshotFile("input-snapshot", llvm::cl::desc("Specify a metadata snapshot from which the outputs are generated instead of parsing the headers (module maps can't be generated from a snapshot)"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::list<string> cla_targetModules("target-modules", llvm::cl::desc("Specify a comma separated list of top level modules for which metadata is generated. Only their headers and the headers they import are parsed"), llvm::cl::CommaSeparated, llvm::cl::value_desc("<module>,..."));
+llvm::cl::opt<string> cla_linkSnapshotFile("link-snapshot", llvm::cl::desc("Specify a snapshot of prebuilt modules (e.g. the SDK, saved with -output-snapshot) whose metadata is written in the binary file along with the generated modules"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::list<string> cla_targetTriples("target-triples", llvm::cl::desc("Specify a comma separated list of target triples, each optionally followed by =<sysroot>, for which the headers are parsed concurrently. The binary metadata, YAML and module maps are written per architecture, and the TypeScript definitions of a module are shared if they are the same for all architectures"), llvm::cl::CommaSeparated, llvm::cl::value_desc("<triple>[=<sysroot>],..."));
+llvm::cl::opt<string> cla_depFile("MF", llvm::cl::desc("Specify a Make-style depfile in which the headers, module maps and other files read by the generator are listed as prerequisites of the -MT target"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::opt<string> cla_depTarget("MT", llvm::cl::desc("Specify the target of the depfile (default - the first of -output-bin, -output-snapshot, -output-typescript-manifest, -output-typescript and -output-yaml, for each architecture with -target-triples)"), llvm::cl::value_desc("<target>"));
+llvm::cl::opt<string> cla_outputDependenciesFile("output-dependencies", llvm::cl::desc("Specify a JSON file in which the files read by the generator are listed with their sizes and modification times"), llvm::cl::value_desc("<file_path>"));
+llvm::cl::opt<string> cla_serverSocket("serve", llvm::cl::desc("Specify a Unix socket at which a server waits for the command lines of -connect clients. The linked snapshot and the metas of the last generation stay loaded, only the modules affected by changed inputs are parsed again"), llvm::cl::value_desc("<socket_path>"));
+llvm::cl::opt<string> cla_connectSocket("connect", llvm::cl::desc("Specify the socket of a server which generates the outputs for this command line"), llvm::cl::value_desc("<socket_path>"));
 llvm::cl::opt<string> cla_clangArgumentsDelimiter(llvm::cl::Positional, llvm::cl::desc("Xclang"), llvm::cl::init("-"));
 llvm::cl::list<string> cla_clangArguments(llvm::cl::ConsumeAfter, llvm::cl::desc("<clang arguments>..."));
 
+// Merges the generated modules with the prebuilt ones. A generated module replaces the prebuilt module with the same name.
+// \param declarationsCount The number of generated declarations. The metas of the linked prebuilt modules are added to it.
+// \param reportCollisions Whether generated symbols with the same name as a prebuilt symbol of another module are reported
+static Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules linkModules(Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& metasByModules, Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& prebuiltMetasByModules, size_t& declarationsCount, bool reportCollisions = true)
+{
+    std::set<std::string> generatedModules;
+    std::list<Meta::Meta*> metas;
+    for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : metasByModules) {
+        generatedModules.insert(modulePair.first->getFullModuleName());
+        metas.insert(metas.end(), modulePair.second.begin(), modulePair.second.end());
+    }
+
+    std::unordered_map<std::string, clang::Module*> prebuiltJsNames;
+    for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : prebuiltMetasByModules) {
+        if (generatedModules.count(modulePair.first->getFullModuleName()) == 0) {
+            metas.insert(metas.end(), modulePair.second.begin(), modulePair.second.end());
+            declarationsCount += modulePair.second.size();
+            for (Meta::Meta* meta : modulePair.second) {
+                prebuiltJsNames.emplace(meta->jsName, modulePair.first);
+            }
+        }
+    }
+
+    // Both sides are already free of collisions within their modules, so they are only reported across them
+    for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : metasByModules) {
+        for (Meta::Meta* meta : modulePair.second) {
+            std::unordered_map<std::string, clang::Module*>::const_iterator it = prebuiltJsNames.find(meta->jsName);
+            if (reportCollisions && it != prebuiltJsNames.end()) {
+                std::cerr << "warning: " << meta->jsName << " from " << modulePair.first->getFullModuleName() << " has the same name as a symbol of the prebuilt " << it->second->getFullModuleName() << " module. Only one of them can be found by name at runtime." << std::endl;
+            }
+        }
+    }
+
+    // The merged metas are grouped and sorted the same way as if all of them were generated in a single run
+    Meta::ResolveGlobalNamesCollisionsFilter filter;
+    filter.filter(metas);
+    return std::move(filter.getResult()->first);
+}
+
+static void writeYaml(Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& metasByModules, const std::string& outputFolder)
+{
+    if (!llvm::sys::fs::exists(outputFolder)) {
+        DEBUG_WITH_TYPE("yaml", llvm::dbgs() << "Creating YAML output directory: " << outputFolder << "\n");
+        llvm::sys::fs::create_directories(outputFolder);
+    }
+
+    DEBUG_WITH_TYPE("yaml", llvm::dbgs() << "Generating " << metasByModules.size() << " YAML files with " << cla_yamlJobs << " jobs\n");
+    Yaml::YamlSerializer::serializeModules(outputFolder, metasByModules, cla_yamlJobs);
+}
+
+// Returns the non-empty lines of a file which aren't # comments
+static std::vector<std::string> readListFile(const std::string& filePath)
+{
+    std::ifstream fs(filePath);
+    if (!fs) {
+        throw std::runtime_error("Unable to open file " + filePath + ".");
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(fs, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+// Moves the modules listed in the hot modules file to the beginning of the binary metadata, so the runtime finds
+// the symbols used at startup in the first pages of the heap. The other modules keep their order.
+static void orderHotModules(Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& metasByModules, const std::string& hotModulesFile)
+{
+    std::map<std::string, size_t> ranks;
+    for (const std::string& moduleName : readListFile(hotModulesFile)) {
+        ranks.emplace(moduleName, ranks.size());
+    }
+
+    auto getRank = [&ranks](const std::pair<clang::Module*, std::vector<Meta::Meta*> >& module) {
+        std::map<std::string, size_t>::const_iterator it = ranks.find(module.first->getTopLevelModule()->getFullModuleName());
+        return it != ranks.end() ? it->second : ranks.size();
+    };
+    std::stable_sort(metasByModules.begin(), metasByModules.end(), [&getRank](const std::pair<clang::Module*, std::vector<Meta::Meta*> >& first, const std::pair<clang::Module*, std::vector<Meta::Meta*> >& second) {
+        return getRank(first) < getRank(second);
+    });
+}
+
+// The metas of the linked snapshot are written only in the binary metadata
+static void writeBinary(Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& metasByModules, size_t declarationsCount, Meta::MetaSnapshot* linkedSnapshot, const std::string& outputFile)
+{
+    Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules binaryMetasByModules;
+    if (linkedSnapshot != nullptr) {
+        binaryMetasByModules = linkModules(metasByModules, linkedSnapshot->getMetasByModules(), declarationsCount);
+    }
+    else {
+        binaryMetasByModules = metasByModules;
+    }
+    if (!cla_binaryHotModulesFile.empty()) {
+        orderHotModules(binaryMetasByModules, cla_binaryHotModulesFile);
+    }
+
+    binary::MetaFile file(declarationsCount / 10, cla_binaryFormat); // Average number of hash collisions: 10 per bucket
+    binary::BinarySerializer serializer(&file, cla_binaryLayout);
+    if (!cla_orderFile.empty()) {
+        serializer.setSymbolsOrder(readListFile(cla_orderFile));
+    }
+    // The buckets are written in the uncompressed beginning of the heap, so lookups don't decompress any block
+    serializer.setReserveAllBuckets(cla_binaryCompressionBlockSize != 0);
+    serializer.serializeContainer(binaryMetasByModules);
+    file.setCompression(cla_binaryCompressionBlockSize, serializer.getOrderedSymbolsEnd());
+    file.save(outputFile);
+}
+
+static std::unique_ptr<TypeScript::DocSetManager> openDocSet()
+{
+    std::string docSetPath = cla_docSetFile.empty() ? "" : cla_docSetFile.getValue();
+    std::unique_ptr<TypeScript::DocSetManager> docSet = llvm::make_unique<TypeScript::DocSetManager>(docSetPath, cla_docSetIndex);
+    if (!cla_docSetCacheFile.empty()) {
+        docSet->loadCache(cla_docSetCacheFile);
+    }
+    return docSet;
+}
+
+// Preloads the documentation of the metas and prerenders their types, so that the modules can be rendered with renderTypeScriptModule
+static void prepareTypeScript(Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& metasByModules, TypeScript::DocSetManager& docSet, TypeScript::DefinitionWriter::Context& context)
+{
+    std::vector<Meta::Meta*> metas;
+    for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : metasByModules) {
+        metas.insert(metas.end(), modulePair.second.begin(), modulePair.second.end());
+    }
+    if (cla_docSetIndex) {
+        docSet.preload(metas);
+    }
+    context.prerenderTypes(metas);
+}
+
+static void renderTypeScriptModule(std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair, TypeScript::DefinitionWriter::Context& context, TypeScript::DocSetManager& docSet, llvm::raw_ostream& output)
+{
+    TypeScript::DefinitionWriter definitionWriter(modulePair, context, docSet, output);
+    definitionWriter.write();
+}
+
+static std::string getTypeScriptFileName(clang::Module* module)
+{
+    return "objc!" + module->getFullModuleName() + ".d.ts";
+}
+
+static bool writeFile(const std::string& path, const std::string& contents)
+{
+    std::error_code error;
+    llvm::raw_fd_ostream file(path, error, llvm::sys::fs::F_Text);
+    if (error) {
+        std::cout << error.message();
+        return false;
+    }
+    file << contents;
+    file.close();
+    return true;
+}
+
+static std::string quoteJsonString(const std::string& value)
+{
+    static const char* hexDigits = "0123456789abcdef";
+    std::string result = "\"";
+    for (char c : value) {
+        switch (c) {
+        case '"':
+        case '\\':
+            result += '\\';
+            result += c;
+            break;
+        case '\b':
+            result += "\\b";
+            break;
+        case '\f':
+            result += "\\f";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\r':
+            result += "\\r";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                result += std::string("\\u00") + hexDigits[(unsigned char)c >> 4] + hexDigits[c & 0xf];
+            } else {
+                result += c;
+            }
+        }
+    }
+    return result + "\"";
+}
+
+static bool haveSameContents(const std::string& firstPath, const std::string& secondPath)
+{
+    // Only files of the same size are read and compared
+    uint64_t firstSize = 0;
+    uint64_t secondSize = 0;
+    if (llvm::sys::fs::file_size(firstPath, firstSize) || llvm::sys::fs::file_size(secondPath, secondSize) || firstSize != secondSize) {
+        return false;
+    }
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > firstFile = llvm::MemoryBuffer::getFile(firstPath, -1, false);
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > secondFile = llvm::MemoryBuffer::getFile(secondPath, -1, false);
+    return firstFile && secondFile && firstFile.get()->getBuffer() == secondFile.get()->getBuffer();
+}
+
+// Passes the written data to another stream and computes its MD5 hash
+class HashingOstream : public llvm::raw_ostream {
+public:
+    HashingOstream(llvm::raw_ostream& output)
+        : _output(output)
+    {
+    }
+
+    ~HashingOstream() override
+    {
+        flush();
+    }
+
+    std::string getHexHash()
+    {
+        flush();
+        llvm::MD5::MD5Result result;
+        _hash.final(result);
+        llvm::SmallString<32> hexHash;
+        llvm::MD5::stringifyResult(result, hexHash);
+        return hexHash.str().str();
+    }
+
+private:
+    void write_impl(const char* ptr, size_t size) override
+    {
+        _hash.update(llvm::StringRef(ptr, size));
+        _output.write(ptr, size);
+        _position += size;
+    }
+
+    uint64_t current_pos() const override
+    {
+        return _position;
+    }
+
+    llvm::raw_ostream& _output;
+    llvm::MD5 _hash;
+    uint64_t _position = 0;
+};
+
+// Writes the TypeScript definitions in the output folder. Files whose contents haven't changed aren't rewritten,
+// so their modification times stay the same and incremental TypeScript builds and watchers don't process them again.
+class TypeScriptFilesWriter {
+public:
+    TypeScriptFilesWriter(const std::string& outputFolder)
+        : _outputFolder(outputFolder)
+    {
+        llvm::sys::fs::create_directories(outputFolder);
+    }
+
+    // Streams the contents rendered by the given function into a temporary file, which replaces the file only if they differ
+    template <class RenderFunction>
+    bool writeRendered(const std::string& relativePath, RenderFunction render)
+    {
+        llvm::SmallString<128> path(_outputFolder);
+        llvm::sys::path::append(path, relativePath);
+        llvm::sys::fs::create_directories(llvm::sys::path::parent_path(path));
+        std::string tempPath = path.str().str() + ".tmp";
+
+        {
+            std::error_code error;
+            llvm::raw_fd_ostream file(tempPath, error, llvm::sys::fs::F_Text);
+            if (error) {
+                std::cout << error.message();
+                return false;
+            }
+            HashingOstream output(file);
+            render(output);
+            _hashes[relativePath] = output.getHexHash();
+        }
+
+        if (haveSameContents(path.str().str(), tempPath)) {
+            llvm::sys::fs::remove(tempPath);
+            _unchangedFilesCount++;
+            return true;
+        }
+        if (std::error_code error = llvm::sys::fs::rename(tempPath, path)) {
+            std::cout << error.message();
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const std::string& relativePath, const std::string& contents)
+    {
+        return writeRendered(relativePath, [&contents](llvm::raw_ostream& output) {
+            output << contents;
+        });
+    }
+
+    void writeManifest(const std::string& manifestFile)
+    {
+        std::string manifest = "{\n  \"algorithm\": \"md5\",\n  \"files\": {";
+        for (std::map<std::string, std::string>::const_iterator it = _hashes.begin(); it != _hashes.end(); ++it) {
+            manifest += (it == _hashes.begin() ? "\n    " : ",\n    ") + quoteJsonString(it->first) + ": \"" + it->second + "\"";
+        }
+        manifest += "\n  }\n}\n";
+        writeFile(manifestFile, manifest);
+    }
+
+    size_t filesCount() const
+    {
+        return _hashes.size();
+    }
+
+    size_t unchangedFilesCount() const
+    {
+        return _unchangedFilesCount;
+    }
+
+private:
+    std::string _outputFolder;
+    // The hashes of the written files, keyed by their paths relative to the output folder
+    std::map<std::string, std::string> _hashes;
+    size_t _unchangedFilesCount = 0;
+};
+
+// The docset package is a folder whose modification time doesn't change with its documents, so the files read from it are the inputs
+static void addDocSetInputFiles(TypeScript::DocSetManager& docSet, std::vector<InputFile>* inputFiles)
+{
+    if (inputFiles != nullptr) {
+        for (const std::string& path : docSet.getReadFiles()) {
+            addInputFile(path, *inputFiles);
+        }
+    }
+}
+
+// Generates the requested outputs from the filtered metas, either parsed from the headers or loaded from a snapshot.
+// \param inputFiles If set, the docset files read for the TypeScript definitions are appended to it
+static void writeOutputs(Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& metasByModules, size_t declarationsCount, Meta::MetaSnapshot* linkedSnapshot, std::vector<InputFile>* inputFiles)
+{
+    // Serialize Meta objects to Yaml
+    if (!cla_outputYamlFolder.empty()) {
+        writeYaml(metasByModules, cla_outputYamlFolder);
+    }
+
+    // Serialize Meta objects to binary metadata
+    if (!cla_outputBinFile.empty()) {
+        writeBinary(metasByModules, declarationsCount, linkedSnapshot, cla_outputBinFile);
+    }
+
+    // Generate TypeScript definitions
+    if (!cla_outputDtsFolder.empty()) {
+        TypeScriptFilesWriter filesWriter(cla_outputDtsFolder);
+        std::unique_ptr<TypeScript::DocSetManager> docSet = openDocSet();
+        TypeScript::DefinitionWriter::Context context;
+        prepareTypeScript(metasByModules, *docSet, context);
+        for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : metasByModules) {
+            bool isWritten = filesWriter.writeRendered(getTypeScriptFileName(modulePair.first), [&](llvm::raw_ostream& output) {
+                renderTypeScriptModule(modulePair, context, *docSet, output);
+            });
+            if (!isWritten) {
+                return;
+            }
+        }
+        std::cout << "TypeScript definitions of " << filesWriter.unchangedFilesCount() << " of " << filesWriter.filesCount() << " modules are unchanged" << std::endl;
+        if (!cla_outputDtsManifestFile.empty()) {
+            filesWriter.writeManifest(cla_outputDtsManifestFile);
+        }
+
+        if (!cla_docSetCacheFile.empty()) {
+            docSet->saveCache(cla_docSetCacheFile);
+        }
+        addDocSetInputFiles(*docSet, inputFiles);
+    }
+}
+
+// The settings and the results of a single parse of an umbrella header
+struct ParseOptions {
+    // The prebuilt modules which are linked in the binary metadata
+    Meta::MetaSnapshot* linkedSnapshot = nullptr;
+
+    // If set, the files read by the parser are appended to it
+    std::vector<InputFile>* inputFiles = nullptr;
+
+    // If set, the filtered metas are saved in it as a snapshot instead of generating the outputs
+    std::string* snapshotContents = nullptr;
+
+    // The folder in which the module maps of all parsed modules are dumped, if any
+    std::string moduleMapsFolder;
+
+    // The top level modules whose declarations are converted. All modules are converted if it is empty.
+    std::vector<std::string> targetModules;
+
+    // The metas of modules which aren't parsed again. They are merged with the parsed modules before the outputs are written.
+    Meta::MetaSnapshot* unchangedModules = nullptr;
+
+    // If set, the metas written in the outputs are also saved in it as a snapshot
+    std::string* outputSnapshotContents = nullptr;
+
+    // If set, the modules of the parsed headers and the dependencies between the modules are added to it
+    ModuleDependencies* moduleDependencies = nullptr;
+};
+
 class MetaGenerationConsumer : public clang::ASTConsumer {
 public:
-    explicit MetaGenerationConsumer(clang::SourceManager& sourceManager, clang::HeaderSearch& headerSearch, Meta::ModulesBlacklist& modulesBlacklist)
+    explicit MetaGenerationConsumer(clang::SourceManager& sourceManager, clang::HeaderSearch& headerSearch, Meta::Diagnostics& diagnostics, Meta::ModulesBlacklist& modulesBlacklist, const ParseOptions& options)
         : _headerSearch(headerSearch)
-        , _visitor(sourceManager, _headerSearch, cla_verbose, modulesBlacklist)
+        , _visitor(sourceManager, _headerSearch, diagnostics, modulesBlacklist)
+        , _options(options)
     {
+        // Only the declarations of the target modules are converted, the modules they import are expected to be linked from a snapshot
+        _visitor.setTargetModules(options.targetModules);
     }
 
     virtual void HandleTranslationUnit(clang::ASTContext& Context) override
@@ -48,6 +500,14 @@ public:
         llvm::SmallVector<clang::Module*, 64> modules;
         _headerSearch.collectAllModules(modules);
         std::list<Meta::Meta*>& metaContainer = _visitor.generateMetadata(Context.getTranslationUnitDecl());
+        if (_options.inputFiles != nullptr) {
+            collectInputFiles(Context.getSourceManager(), *_options.inputFiles);
+        }
+
+        if (_options.moduleDependencies != nullptr) {
+            collectModuleDependencies(Context.getSourceManager(), _headerSearch, modules, *_options.moduleDependencies);
+            addCategoryDependencies(metaContainer, *_options.moduleDependencies);
+        }
 
         // Filters
         Meta::HandleExceptionalMetasFilter().filter(metaContainer);
@@ -59,16 +519,19 @@ public:
         std::unique_ptr<std::pair<Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules, Meta::ResolveGlobalNamesCollisionsFilter::InterfacesByName> > result = filter.getResult();
         Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& metasByModules = result->first;
         Meta::ResolveGlobalNamesCollisionsFilter::InterfacesByName& interfacesByName = result->second;
+        if (!_options.targetModules.empty()) {
+            addImportedInterfaces(interfacesByName);
+        }
         _visitor.getMetaFactory().getTypeFactory().resolveCachedBridgedInterfaceTypes(interfacesByName);
 
         // Log statistic for parsed Meta objects
         std::cout << "Result: " << metaContainer.size() << " declarations from " << metasByModules.size() << " top level modules" << std::endl;
 
         // Dump module maps
-        if (!cla_outputModuleMapsFolder.empty()) {
-            llvm::sys::fs::create_directories(cla_outputModuleMapsFolder);
+        if (!_options.moduleMapsFolder.empty()) {
+            llvm::sys::fs::create_directories(_options.moduleMapsFolder);
             for (clang::Module*& module : modules) {
-                std::string filePath = std::string(cla_outputModuleMapsFolder) + std::string("/") + module->getFullModuleName() + ".modulemap";
+                std::string filePath = _options.moduleMapsFolder + std::string("/") + module->getFullModuleName() + ".modulemap";
                 std::error_code error;
                 llvm::raw_fd_ostream file(filePath, error, llvm::sys::fs::F_Text);
                 if (error) {
@@ -80,59 +543,91 @@ public:
             }
         }
 
-        // Serialize Meta objects to Yaml
-        if (!cla_outputYamlFolder.empty()) {
-            if (!llvm::sys::fs::exists(cla_outputYamlFolder)) {
-                DEBUG_WITH_TYPE("yaml", llvm::dbgs() << "Creating YAML output directory: " << cla_outputYamlFolder << "\n");
-                llvm::sys::fs::create_directories(cla_outputYamlFolder);
-            }
+        if (_options.snapshotContents != nullptr) {
+            *_options.snapshotContents = Meta::MetaSnapshot::saveToString(metasByModules, metaContainer.size());
+            return;
+        }
 
-            for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : metasByModules) {
-                std::string yamlFileName = modulePair.first->getFullModuleName() + ".yaml";
-                DEBUG_WITH_TYPE("yaml", llvm::dbgs() << "Generating: " << yamlFileName << "\n");
-                Yaml::YamlSerializer::serialize<std::pair<clang::Module*, std::vector<Meta::Meta*> > >(cla_outputYamlFolder + "/" + yamlFileName, modulePair);
+        // The outputs contain all modules, whether they have been parsed again or not
+        size_t declarationsCount = metaContainer.size();
+        Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules mergedMetasByModules;
+        if (_options.unchangedModules != nullptr) {
+            // The parsed modules replace their previous metas, even the ones which have no declarations left
+            Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules unchangedMetasByModules;
+            for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : _options.unchangedModules->getMetasByModules()) {
+                if (std::find(_options.targetModules.begin(), _options.targetModules.end(), modulePair.first->Name) == _options.targetModules.end()) {
+                    unchangedMetasByModules.push_back(modulePair);
+                }
             }
+            mergedMetasByModules = linkModules(metasByModules, unchangedMetasByModules, declarationsCount, /*reportCollisions*/ false);
         }
+        Meta::ResolveGlobalNamesCollisionsFilter::MetasByModules& outputMetasByModules = _options.unchangedModules != nullptr ? mergedMetasByModules : metasByModules;
 
-        // Serialize Meta objects to binary metadata
-        if (!cla_outputBinFile.empty()) {
-            binary::MetaFile file(metaContainer.size() / 10); // Average number of hash collisions: 10 per bucket
-            binary::BinarySerializer serializer(&file);
-            serializer.serializeContainer(metasByModules);
-            file.save(cla_outputBinFile);
+        if (!cla_outputSnapshotFile.empty()) {
+            Meta::MetaSnapshot::save(cla_outputSnapshotFile, outputMetasByModules, declarationsCount);
+        }
+        if (_options.outputSnapshotContents != nullptr) {
+            *_options.outputSnapshotContents = Meta::MetaSnapshot::saveToString(outputMetasByModules, declarationsCount);
         }
 
-        // Generate TypeScript definitions
-        if (!cla_outputDtsFolder.empty()) {
-            llvm::sys::fs::create_directories(cla_outputDtsFolder);
-            std::string docSetPath = cla_docSetFile.empty() ? "" : cla_docSetFile.getValue();
-            for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : metasByModules) {
-                TypeScript::DefinitionWriter definitionWriter(modulePair, _visitor.getMetaFactory().getTypeFactory(), docSetPath);
+        writeOutputs(outputMetasByModules, declarationsCount, _options.linkedSnapshot, _options.inputFiles);
+    }
 
-                llvm::SmallString<128> path;
-                llvm::sys::path::append(path, cla_outputDtsFolder, "objc!" + modulePair.first->getFullModuleName() + ".d.ts");
-                std::error_code error;
-                llvm::raw_fd_ostream file(path.str(), error, llvm::sys::fs::F_Text);
-                if (error) {
-                    std::cout << error.message();
-                    return;
+private:
+    // A category changes the interface it extends, so the module of the interface depends on the module of the category
+    static void addCategoryDependencies(const std::list<Meta::Meta*>& metaContainer, ModuleDependencies& dependencies)
+    {
+        for (Meta::Meta* meta : metaContainer) {
+            if (!meta->is(Meta::MetaType::Category)) {
+                continue;
+            }
+            Meta::CategoryMeta& category = meta->as<Meta::CategoryMeta>();
+            if (category.module != nullptr && category.extendedInterface != nullptr && category.extendedInterface->module != nullptr) {
+                const std::string& categoryModule = category.module->getTopLevelModule()->Name;
+                const std::string& interfaceModule = category.extendedInterface->module->getTopLevelModule()->Name;
+                if (categoryModule != interfaceModule) {
+                    dependencies.dependentModules[categoryModule].insert(interfaceModule);
                 }
+            }
+        }
+    }
 
-                file << definitionWriter.write();
-                file.close();
+    // The interfaces of the imported modules aren't in the container when only the target modules are converted.
+    // Bridged types are resolved with the ones created as dependencies, or else with the ones of the unchanged or prebuilt modules.
+    void addImportedInterfaces(Meta::ResolveGlobalNamesCollisionsFilter::InterfacesByName& interfacesByName)
+    {
+        for (Meta::Cache::value_type& cached : _visitor.getMetaFactory().getCache()) {
+            Meta::Meta* meta = cached.second.first.get();
+            if (meta != nullptr && cached.second.second == nullptr && meta->is(Meta::MetaType::Interface)) {
+                interfacesByName.emplace(meta->name, &meta->as<Meta::InterfaceMeta>());
+            }
+        }
+
+        for (Meta::MetaSnapshot* snapshot : { _options.unchangedModules, _options.linkedSnapshot }) {
+            if (snapshot == nullptr) {
+                continue;
+            }
+            for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : snapshot->getMetasByModules()) {
+                for (Meta::Meta* meta : modulePair.second) {
+                    if (meta->is(Meta::MetaType::Interface)) {
+                        interfacesByName.emplace(meta->name, &meta->as<Meta::InterfaceMeta>());
+                    }
+                }
             }
         }
     }
 
-private:
     clang::HeaderSearch& _headerSearch;
     Meta::DeclarationConverterVisitor _visitor;
+    ParseOptions _options;
 };
 
 class MetaGenerationFrontendAction : public clang::ASTFrontendAction {
 public:
-    MetaGenerationFrontendAction(Meta::ModulesBlacklist& modulesBlacklist)
-        : _modulesBlacklist(modulesBlacklist)
+    MetaGenerationFrontendAction(Meta::Diagnostics& diagnostics, Meta::ModulesBlacklist& modulesBlacklist, const ParseOptions& options)
+        : _diagnostics(diagnostics)
+        , _modulesBlacklist(modulesBlacklist)
+        , _options(options)
     {
     }
 
@@ -143,11 +638,13 @@ public:
         // here we set this explicitly in order to keep the same behavior
         Compiler.getPreprocessor().SetSuppressIncludeNotFoundError(!cla_strictIncludes);
 
-        return std::unique_ptr<clang::ASTConsumer>(new MetaGenerationConsumer(Compiler.getASTContext().getSourceManager(), Compiler.getPreprocessor().getHeaderSearchInfo(), _modulesBlacklist));
+        return std::unique_ptr<clang::ASTConsumer>(new MetaGenerationConsumer(Compiler.getASTContext().getSourceManager(), Compiler.getPreprocessor().getHeaderSearchInfo(), _diagnostics, _modulesBlacklist, _options));
     }
 
 private:
+    Meta::Diagnostics& _diagnostics;
     Meta::ModulesBlacklist& _modulesBlacklist;
+    ParseOptions _options;
 };
 
 std::string replaceString(std::string subject, const std::string& search, const std::string& replace)
@@ -169,74 +666,657 @@ static void dumpArgs(std::ostream& os, int argc, const char **argv) {
     os << std::endl;
 }
 
-int main(int argc, const char** argv)
+static void printRunningTime(std::clock_t begin)
 {
-    try {
-        std::clock_t begin = clock();
+    std::clock_t end = clock();
+    double elapsed_secs = double(end - begin) / CLOCKS_PER_SEC;
+    std::cout << "Done! Running time: " << elapsed_secs << " sec " << std::endl;
+}
 
-        llvm::cl::ParseCommandLineOptions(argc, argv);
-        assert(cla_clangArgumentsDelimiter.getValue() == "Xclang");
+static bool areDependenciesRequested()
+{
+    return !cla_depFile.empty() || !cla_outputDependenciesFile.empty();
+}
 
-        // Log Metadata Genrator Arguments
-        dumpArgs(std::cout, argc, argv);
-        dumpArgs(std::cerr, argc, argv);
+// Appends the files given by the command line options which affect the outputs
+static void addOptionInputFiles(std::vector<InputFile>& inputFiles)
+{
+    for (const std::string& file : { cla_inputUmbrellaHeaderFile.getValue(), cla_whiteListModuleRegexesFile.getValue(), cla_blackListModuleRegexesFile.getValue(),
+             cla_docSetCacheFile.getValue(), cla_inputSnapshotFile.getValue(), cla_linkSnapshotFile.getValue(), cla_orderFile.getValue(), cla_binaryHotModulesFile.getValue() }) {
+        addInputFile(file, inputFiles);
+    }
+}
 
-        TypeScript::DefinitionWriter::applyManualChanges = cla_applyManualDtsChanges;
+static std::string escapeDepFilePath(const std::string& path)
+{
+    std::string result;
+    for (char c : path) {
+        if (c == ' ' || c == '#' || c == ':' || c == '\\') {
+            result += '\\';
+        } else if (c == '$') {
+            result += '$';
+        }
+        result += c;
+    }
+    return result;
+}
 
-        std::vector<std::string> clangArgs{
-            "-v",
-            "-x", "objective-c",
-            "-fno-objc-arc", "-fmodule-maps", "-ferror-limit=0",
-            "-Wno-unknown-pragmas", "-Wno-ignored-attributes", "-Wno-nullability-completeness", "-Wno-expansion-to-defined",
-            "-D__NATIVESCRIPT_METADATA_GENERATOR=1"
-        };
+// Writes the depfile and the JSON list of the input files, if they are requested
+// \param defaultTargets The targets of the depfile if -MT isn't given, e.g. the outputs of each architecture
+static void writeDependencies(std::vector<InputFile>& inputFiles, const std::vector<std::string>& defaultTargets)
+{
+    std::sort(inputFiles.begin(), inputFiles.end(), [](const InputFile& first, const InputFile& second) {
+        return first.path < second.path;
+    });
+    inputFiles.erase(std::unique(inputFiles.begin(), inputFiles.end(), [](const InputFile& first, const InputFile& second) {
+        return first.path == second.path;
+    }), inputFiles.end());
 
-        // merge with hardcoded clang arguments
-        clangArgs.insert(clangArgs.end(), cla_clangArguments.begin(), cla_clangArguments.end());
+    if (!cla_depFile.empty()) {
+        std::vector<std::string> targets;
+        for (const std::string& target : cla_depTarget.empty() ? defaultTargets : std::vector<std::string>{ cla_depTarget.getValue() }) {
+            if (!target.empty() && std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                targets.push_back(target);
+            }
+        }
+        if (targets.empty()) {
+            throw std::runtime_error("The target of the depfile can't be determined, specify it with -MT.");
+        }
+        std::string contents;
+        for (const std::string& target : targets) {
+            contents += (contents.empty() ? "" : " ") + escapeDepFilePath(target);
+        }
+        contents += ":";
+        for (const InputFile& file : inputFiles) {
+            contents += " \\\n  " + escapeDepFilePath(file.path);
+        }
+        writeFile(cla_depFile, contents + "\n");
+    }
+
+    if (!cla_outputDependenciesFile.empty()) {
+        std::string contents = "{\n  \"inputs\": [";
+        for (size_t i = 0; i < inputFiles.size(); i++) {
+            contents += std::string(i == 0 ? "\n" : ",\n") + "    { \"path\": " + quoteJsonString(inputFiles[i].path) + ", \"size\": " + std::to_string(inputFiles[i].size)
+                + ", \"modificationTime\": " + std::to_string(inputFiles[i].modificationTime) + " }";
+        }
+        contents += "\n  ]\n}\n";
+        writeFile(cla_outputDependenciesFile, contents);
+    }
+}
+
+// The last generation with the same arguments, kept by the server so that only the modules affected by the changed inputs are parsed again
+struct CachedGeneration {
+    std::string umbrellaContent;
+    std::vector<InputFile> inputFiles;
+
+    // The metas written in the last outputs. The parsed modules are merged with them.
+    std::unique_ptr<Meta::MetaSnapshot> metas;
+    ModuleDependencies moduleDependencies;
+};
+
+// Returns the top level modules whose metadata depends on the changed files, i.e. the modules of the changed headers and
+// the modules which depend on them. It is empty if a changed file doesn't belong to a module, e.g. a module map or an option file.
+static std::set<std::string> getAffectedModules(const std::vector<std::string>& changedFiles, const ModuleDependencies& dependencies)
+{
+    std::vector<std::string> pendingModules;
+    for (const std::string& file : changedFiles) {
+        std::map<std::string, std::string>::const_iterator it = dependencies.headerModules.find(file);
+        if (it == dependencies.headerModules.end()) {
+            return std::set<std::string>();
+        }
+        pendingModules.push_back(it->second);
+    }
 
-        // Log Clang Arguments
-        std::cout << "Clang Arguments: \n";
-        for (const std::string& arg : clangArgs) {
-            std::cout << "\"" << arg << "\","
-                      << " ";
+    std::set<std::string> affectedModules;
+    while (!pendingModules.empty()) {
+        std::string module = pendingModules.back();
+        pendingModules.pop_back();
+        if (!affectedModules.insert(module).second) {
+            continue;
+        }
+        std::map<std::string, std::set<std::string> >::const_iterator it = dependencies.dependentModules.find(module);
+        if (it != dependencies.dependentModules.end()) {
+            pendingModules.insert(pendingModules.end(), it->second.begin(), it->second.end());
         }
-        std::cout << std::endl;
+    }
+    return affectedModules;
+}
 
-        std::string isysroot;
-        std::vector<string>::const_iterator it = std::find(clangArgs.begin(), clangArgs.end(), "-isysroot");
-        if (it != clangArgs.end() && ++it != clangArgs.end()) {
-            isysroot = *it;
+static bool areOutputsPresent()
+{
+    for (const std::string& output : { cla_outputBinFile.getValue(), cla_outputDtsFolder.getValue(), cla_outputYamlFolder.getValue() }) {
+        if (!output.empty() && !llvm::sys::fs::exists(output)) {
+            return false;
         }
+    }
+    return true;
+}
+
+static std::vector<std::string> getClangArgs()
+{
+    std::vector<std::string> clangArgs{
+        "-v",
+        "-x", "objective-c",
+        "-fno-objc-arc", "-fmodule-maps", "-ferror-limit=0",
+        "-Wno-unknown-pragmas", "-Wno-ignored-attributes", "-Wno-nullability-completeness", "-Wno-expansion-to-defined",
+        "-D__NATIVESCRIPT_METADATA_GENERATOR=1"
+    };
+
+    // merge with hardcoded clang arguments
+    clangArgs.insert(clangArgs.end(), cla_clangArguments.begin(), cla_clangArguments.end());
+
+    // Log Clang Arguments
+    std::cout << "Clang Arguments: \n";
+    for (const std::string& arg : clangArgs) {
+        std::cout << "\"" << arg << "\","
+                  << " ";
+    }
+    std::cout << std::endl;
+    return clangArgs;
+}
+
+// Creates the umbrella header and adds the include paths of the modules to the clang arguments
+static std::string createUmbrellaContent(std::vector<std::string>& clangArgs, const std::string& outputUmbrellaHeaderFile)
+{
+    std::vector<std::string> includePaths;
+    std::vector<std::string> targetModules(cla_targetModules.begin(), cla_targetModules.end());
+    std::string umbrellaContent = CreateUmbrellaHeader(clangArgs, includePaths, targetModules);
+
+    if (!cla_inputUmbrellaHeaderFile.empty()) {
+        std::ifstream fs(cla_inputUmbrellaHeaderFile);
+        umbrellaContent = std::string((std::istreambuf_iterator<char>(fs)),
+                                      std::istreambuf_iterator<char>());
+    }
 
-        std::vector<std::string> includePaths;
-        std::string umbrellaContent = CreateUmbrellaHeader(clangArgs, includePaths);
+    clangArgs.insert(clangArgs.end(), includePaths.begin(), includePaths.end());
 
-        if (!cla_inputUmbrellaHeaderFile.empty()) {
-            std::ifstream fs(cla_inputUmbrellaHeaderFile);
-            umbrellaContent = std::string((std::istreambuf_iterator<char>(fs)),
-                                          std::istreambuf_iterator<char>());
+    // Save the umbrella file
+    if (!outputUmbrellaHeaderFile.empty()) {
+        std::error_code errorCode;
+        llvm::raw_fd_ostream umbrellaFileStream(outputUmbrellaHeaderFile, errorCode, llvm::sys::fs::OpenFlags::F_None);
+        if (!errorCode) {
+            umbrellaFileStream << umbrellaContent;
+            umbrellaFileStream.close();
         }
+    }
+    return umbrellaContent;
+}
+
+static void parseUmbrella(const std::string& umbrellaContent, const std::vector<std::string>& clangArgs, const std::string& symbolsReportFile, const ParseOptions& options)
+{
+    Meta::Diagnostics diagnostics(cla_verbose ? std::max(cla_diagnosticsLevel.getValue(), Meta::DiagnosticLevel::Verbose) : cla_diagnosticsLevel.getValue());
+    if (!symbolsReportFile.empty()) {
+        diagnostics.openReport(symbolsReportFile);
+    }
+
+    // generate metadata for the intermediate sdk header
+    Meta::ModulesBlacklist modulesBlacklist(cla_whiteListModuleRegexesFile, cla_blackListModuleRegexesFile);
+    clang::tooling::runToolOnCodeWithArgs(new MetaGenerationFrontendAction(/*r*/diagnostics, /*r*/modulesBlacklist, options), umbrellaContent, clangArgs, "umbrella.h", "objc-metadata-generator");
+}
+
+// Inserts the architecture before the extension of a file, e.g. metadata.bin -> metadata-arm64.bin
+static std::string getArchitecturePath(const std::string& path, const std::string& architecture)
+{
+    llvm::SmallString<128> result(path);
+    llvm::sys::path::replace_extension(result, "");
+    result += "-" + architecture;
+    result += llvm::sys::path::extension(path);
+    return result.str().str();
+}
 
-        clangArgs.insert(clangArgs.end(), includePaths.begin(), includePaths.end());
+static std::string getArchitectureFolder(const std::string& folder, const std::string& architecture)
+{
+    llvm::SmallString<128> result(folder);
+    llvm::sys::path::append(result, architecture);
+    return result.str().str();
+}
 
-        // Save the umbrella file
-        if (!cla_outputUmbrellaHeaderFile.empty()) {
-            std::error_code errorCode;
-            llvm::raw_fd_ostream umbrellaFileStream(cla_outputUmbrellaHeaderFile, errorCode, llvm::sys::fs::OpenFlags::F_None);
-            if (!errorCode) {
-                umbrellaFileStream << umbrellaContent;
-                umbrellaFileStream.close();
+// Removes all occurrences of an option and its value from the clang arguments
+static void removeClangArgument(std::vector<std::string>& clangArgs, const std::string& option)
+{
+    for (std::vector<std::string>::iterator it = clangArgs.begin(); it != clangArgs.end();) {
+        if (*it == option && it + 1 != clangArgs.end()) {
+            it = clangArgs.erase(it, it + 2);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+// The first output of the generation, used as the target of the depfile
+static std::string getDefaultDependencyTarget(const std::string& architecture)
+{
+    // The binary metadata, the snapshot and the YAML files are written per architecture with -target-triples
+    if (!cla_outputBinFile.empty()) {
+        return architecture.empty() ? cla_outputBinFile.getValue() : getArchitecturePath(cla_outputBinFile, architecture);
+    }
+    if (!cla_outputSnapshotFile.empty()) {
+        return architecture.empty() ? cla_outputSnapshotFile.getValue() : getArchitecturePath(cla_outputSnapshotFile, architecture);
+    }
+    if (!cla_outputDtsManifestFile.empty()) {
+        return cla_outputDtsManifestFile;
+    }
+    if (!cla_outputDtsFolder.empty()) {
+        return cla_outputDtsFolder;
+    }
+    if (!cla_outputYamlFolder.empty()) {
+        return architecture.empty() ? cla_outputYamlFolder.getValue() : getArchitectureFolder(cla_outputYamlFolder, architecture);
+    }
+    return "";
+}
+
+struct TargetGeneration {
+    std::string triple;
+    std::string sysroot;
+
+    // The architecture and the environment of the triple, e.g. arm64 or arm64-simulator
+    std::string architecture;
+
+    std::string snapshotContents;
+    std::vector<InputFile> inputFiles;
+    std::string error;
+};
+
+// Parses the headers for each target triple concurrently and writes the outputs of each architecture.
+// The TypeScript definitions of a module are shared if they are the same for all architectures.
+static int generateForTargets(std::clock_t begin, const std::vector<std::string>& clangArgs)
+{
+    std::vector<TargetGeneration> targets;
+    std::set<std::string> architectures;
+    for (const std::string& target : cla_targetTriples) {
+        TargetGeneration generation;
+        size_t separator = target.find('=');
+        generation.triple = target.substr(0, separator);
+        generation.sysroot = separator == std::string::npos ? "" : target.substr(separator + 1);
+        llvm::Triple triple(generation.triple);
+        generation.architecture = triple.getArchName().str();
+        if (!triple.getEnvironmentName().empty()) {
+            generation.architecture += "-" + triple.getEnvironmentName().str();
+        }
+        if (!architectures.insert(generation.architecture).second) {
+            throw std::runtime_error("The architecture " + generation.architecture + " is targeted more than once.");
+        }
+        targets.push_back(generation);
+    }
+
+    // Each target is parsed by its own compiler instance and its metas are kept as a snapshot,
+    // because they reference the modules of the compiler instance, which is destroyed after the parse
+    {
+        llvm::ThreadPool pool(targets.size());
+        for (TargetGeneration& target : targets) {
+            pool.async([&target, &clangArgs]() {
+                try {
+                    std::vector<std::string> targetArgs = clangArgs;
+                    removeClangArgument(targetArgs, "-arch");
+                    removeClangArgument(targetArgs, "-target");
+                    targetArgs.insert(targetArgs.end(), { "-target", target.triple });
+                    if (!target.sysroot.empty()) {
+                        removeClangArgument(targetArgs, "-isysroot");
+                        targetArgs.insert(targetArgs.end(), { "-isysroot", target.sysroot });
+                    }
+
+                    std::string umbrellaContent = createUmbrellaContent(targetArgs, cla_outputUmbrellaHeaderFile.empty() ? "" : getArchitecturePath(cla_outputUmbrellaHeaderFile, target.architecture));
+                    ParseOptions options;
+                    options.targetModules.assign(cla_targetModules.begin(), cla_targetModules.end());
+                    options.snapshotContents = &target.snapshotContents;
+                    options.inputFiles = areDependenciesRequested() ? &target.inputFiles : nullptr;
+                    if (!cla_outputModuleMapsFolder.empty()) {
+                        options.moduleMapsFolder = getArchitectureFolder(cla_outputModuleMapsFolder, target.architecture);
+                    }
+                    parseUmbrella(umbrellaContent, targetArgs, cla_symbolsReportFile.empty() ? "" : getArchitecturePath(cla_symbolsReportFile, target.architecture), options);
+                    if (target.snapshotContents.empty()) {
+                        target.error = "The headers weren't parsed.";
+                    }
+                } catch (const std::exception& e) {
+                    target.error = e.what();
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    std::vector<std::unique_ptr<Meta::MetaSnapshot> > snapshots;
+    for (TargetGeneration& target : targets) {
+        if (!target.error.empty()) {
+            throw std::runtime_error(target.triple + ": " + target.error);
+        }
+        if (!cla_outputSnapshotFile.empty()) {
+            writeFile(getArchitecturePath(cla_outputSnapshotFile, target.architecture), target.snapshotContents);
+        }
+        snapshots.push_back(Meta::MetaSnapshot::loadFromString(target.snapshotContents));
+        std::string().swap(target.snapshotContents);
+    }
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        if (!cla_outputYamlFolder.empty()) {
+            writeYaml(snapshots[i]->getMetasByModules(), getArchitectureFolder(cla_outputYamlFolder, targets[i].architecture));
+        }
+        if (!cla_outputBinFile.empty()) {
+            writeBinary(snapshots[i]->getMetasByModules(), snapshots[i]->getDeclarationsCount(), nullptr, getArchitecturePath(cla_outputBinFile, targets[i].architecture));
+        }
+    }
+
+    std::vector<InputFile> docSetInputFiles;
+    if (!cla_outputDtsFolder.empty()) {
+        TypeScriptFilesWriter filesWriter(cla_outputDtsFolder);
+        std::unique_ptr<TypeScript::DocSetManager> docSet = openDocSet();
+        std::vector<std::unique_ptr<TypeScript::DefinitionWriter::Context> > contexts;
+        // The modules of each architecture, keyed by the names of their definition files
+        std::vector<std::map<std::string, std::pair<clang::Module*, std::vector<Meta::Meta*> >*> > modules(snapshots.size());
+        std::set<std::string> fileNames;
+        for (size_t i = 0; i < snapshots.size(); i++) {
+            contexts.push_back(llvm::make_unique<TypeScript::DefinitionWriter::Context>());
+            prepareTypeScript(snapshots[i]->getMetasByModules(), *docSet, *contexts.back());
+            for (std::pair<clang::Module*, std::vector<Meta::Meta*> >& modulePair : snapshots[i]->getMetasByModules()) {
+                std::string fileName = getTypeScriptFileName(modulePair.first);
+                modules[i][fileName] = &modulePair;
+                fileNames.insert(fileName);
             }
         }
-        // generate metadata for the intermediate sdk header
-        Meta::ModulesBlacklist modulesBlacklist(cla_whiteListModuleRegexesFile, cla_blackListModuleRegexesFile);
-        clang::tooling::runToolOnCodeWithArgs(new MetaGenerationFrontendAction(/*r*/modulesBlacklist), umbrellaContent, clangArgs, "umbrella.h", "objc-metadata-generator");
 
-        std::clock_t end = clock();
-        double elapsed_secs = double(end - begin) / CLOCKS_PER_SEC;
-        std::cout << "Done! Running time: " << elapsed_secs << " sec " << std::endl;
+        // A module is rendered for all architectures and written before the next one, so only its definitions are kept in memory
+        size_t sharedFilesCount = 0;
+        std::vector<std::string> contents(snapshots.size());
+        for (const std::string& fileName : fileNames) {
+            bool isShared = true;
+            for (size_t i = 0; i < snapshots.size(); i++) {
+                contents[i].clear();
+                std::map<std::string, std::pair<clang::Module*, std::vector<Meta::Meta*> >*>::const_iterator it = modules[i].find(fileName);
+                if (it == modules[i].end()) {
+                    isShared = false;
+                    continue;
+                }
+                llvm::raw_string_ostream output(contents[i]);
+                renderTypeScriptModule(*it->second, *contexts[i], *docSet, output);
+                output.flush();
+                isShared = isShared && contents[i] == contents[0];
+            }
 
+            if (isShared) {
+                filesWriter.write(fileName, contents[0]);
+                sharedFilesCount++;
+                continue;
+            }
+
+            // The definitions of the module differ, so each architecture has its own
+            for (size_t i = 0; i < targets.size(); i++) {
+                if (modules[i].count(fileName) != 0) {
+                    filesWriter.write(getArchitectureFolder(targets[i].architecture, fileName), contents[i]);
+                }
+            }
+        }
+        std::cout << "TypeScript definitions of " << sharedFilesCount << " of " << fileNames.size() << " modules are shared by all architectures, "
+                  << filesWriter.unchangedFilesCount() << " of " << filesWriter.filesCount() << " files are unchanged" << std::endl;
+        if (!cla_outputDtsManifestFile.empty()) {
+            filesWriter.writeManifest(cla_outputDtsManifestFile);
+        }
+
+        if (!cla_docSetCacheFile.empty()) {
+            docSet->saveCache(cla_docSetCacheFile);
+        }
+        addDocSetInputFiles(*docSet, &docSetInputFiles);
+    }
+
+    if (areDependenciesRequested()) {
+        std::vector<InputFile> inputFiles = std::move(docSetInputFiles);
+        std::vector<std::string> dependencyTargets;
+        for (TargetGeneration& target : targets) {
+            inputFiles.insert(inputFiles.end(), target.inputFiles.begin(), target.inputFiles.end());
+            dependencyTargets.push_back(getDefaultDependencyTarget(target.architecture));
+        }
+        addOptionInputFiles(inputFiles);
+        writeDependencies(inputFiles, dependencyTargets);
+    }
+
+    printRunningTime(begin);
+    return 0;
+}
+
+// Generates the outputs requested by the parsed command line options
+static int generate(std::clock_t begin, Meta::MetaSnapshot* linkedSnapshot, CachedGeneration* cachedGeneration)
+{
+    TypeScript::DefinitionWriter::applyManualChanges = cla_applyManualDtsChanges;
+
+    // generate the outputs from a snapshot without parsing the headers
+    if (!cla_inputSnapshotFile.empty()) {
+        std::unique_ptr<Meta::MetaSnapshot> snapshot = Meta::MetaSnapshot::load(cla_inputSnapshotFile);
+        std::cout << "Result: " << snapshot->getDeclarationsCount() << " declarations from " << snapshot->getMetasByModules().size() << " top level modules loaded from " << cla_inputSnapshotFile << std::endl;
+        if (!cla_outputModuleMapsFolder.empty()) {
+            std::cerr << "warning: Module maps can't be generated from a snapshot." << std::endl;
+        }
+        std::vector<InputFile> inputFiles;
+        writeOutputs(snapshot->getMetasByModules(), snapshot->getDeclarationsCount(), linkedSnapshot, &inputFiles);
+        if (areDependenciesRequested()) {
+            addOptionInputFiles(inputFiles);
+            writeDependencies(inputFiles, { getDefaultDependencyTarget("") });
+        }
+
+        printRunningTime(begin);
         return 0;
+    }
+
+    assert(cla_clangArgumentsDelimiter.getValue() == "Xclang");
+
+    std::vector<std::string> clangArgs = getClangArgs();
+    if (!cla_targetTriples.empty()) {
+        if (linkedSnapshot != nullptr) {
+            throw std::runtime_error("A snapshot can't be linked with the metadata of multiple target triples.");
+        }
+        return generateForTargets(begin, clangArgs);
+    }
+
+    std::vector<std::string> moduleClangArgs = clangArgs;
+    std::string umbrellaContent = createUmbrellaContent(clangArgs, cla_outputUmbrellaHeaderFile);
+
+    std::vector<InputFile> inputFiles;
+    ParseOptions options;
+    options.linkedSnapshot = linkedSnapshot;
+    options.inputFiles = cachedGeneration != nullptr || areDependenciesRequested() ? &inputFiles : nullptr;
+    options.moduleMapsFolder = cla_outputModuleMapsFolder;
+    options.targetModules.assign(cla_targetModules.begin(), cla_targetModules.end());
+    std::string parsedUmbrellaContent = umbrellaContent;
+
+    // Forget the previous generation, so that everything is parsed again if this one fails
+    CachedGeneration previousGeneration;
+    std::string snapshotContents;
+    ModuleDependencies moduleDependencies;
+    if (cachedGeneration != nullptr) {
+        std::swap(previousGeneration, *cachedGeneration);
+        options.outputSnapshotContents = &snapshotContents;
+        options.moduleDependencies = &moduleDependencies;
+    }
+
+    // the same headers produce the same outputs, so only the modules which depend on the changed files are parsed again
+    bool isIncremental = false;
+    if (previousGeneration.metas != nullptr && previousGeneration.umbrellaContent == umbrellaContent) {
+        std::vector<std::string> changedFiles = getChangedInputFiles(previousGeneration.inputFiles);
+        if (changedFiles.empty()) {
+            if (!areOutputsPresent()) {
+                writeOutputs(previousGeneration.metas->getMetasByModules(), previousGeneration.metas->getDeclarationsCount(), linkedSnapshot, nullptr);
+            }
+            std::cout << "Result: The parsed files haven't changed since the last generation, the outputs are up to date." << std::endl;
+            std::swap(previousGeneration, *cachedGeneration);
+            printRunningTime(begin);
+            return 0;
+        }
+
+        // The report and a given umbrella header cover all parsed declarations
+        std::set<std::string> affectedModules;
+        if (cla_inputUmbrellaHeaderFile.empty() && cla_symbolsReportFile.empty()) {
+            affectedModules = getAffectedModules(changedFiles, previousGeneration.moduleDependencies);
+        }
+        if (!cla_targetModules.empty()) {
+            std::set<std::string> targetModules(cla_targetModules.begin(), cla_targetModules.end());
+            std::set<std::string> affectedTargetModules;
+            std::set_intersection(affectedModules.begin(), affectedModules.end(), targetModules.begin(), targetModules.end(), std::inserter(affectedTargetModules, affectedTargetModules.end()));
+            affectedModules.swap(affectedTargetModules);
+        }
+
+        if (!affectedModules.empty()) {
+            std::cout << changedFiles.size() << " files have changed since the last generation, parsing the " << affectedModules.size() << " top level modules which depend on them" << std::endl;
+            std::vector<std::string> includePaths;
+            options.targetModules.assign(affectedModules.begin(), affectedModules.end());
+            options.unchangedModules = previousGeneration.metas.get();
+            parsedUmbrellaContent = CreateUmbrellaHeader(moduleClangArgs, includePaths, options.targetModules);
+            isIncremental = true;
+        }
+    }
+
+    parseUmbrella(parsedUmbrellaContent, clangArgs, cla_symbolsReportFile, options);
+
+    // The files which have only been read by the previous generations are still inputs of the merged outputs
+    if (isIncremental) {
+        std::set<std::string> parsedFiles;
+        for (const InputFile& file : inputFiles) {
+            parsedFiles.insert(file.path);
+        }
+        for (const InputFile& file : previousGeneration.inputFiles) {
+            if (parsedFiles.count(file.path) == 0) {
+                inputFiles.push_back(file);
+            }
+        }
+        moduleDependencies.headerModules.insert(previousGeneration.moduleDependencies.headerModules.begin(), previousGeneration.moduleDependencies.headerModules.end());
+        for (std::pair<const std::string, std::set<std::string> >& dependentModules : previousGeneration.moduleDependencies.dependentModules) {
+            moduleDependencies.dependentModules[dependentModules.first].insert(dependentModules.second.begin(), dependentModules.second.end());
+        }
+    }
+
+    if (options.inputFiles != nullptr) {
+        addOptionInputFiles(inputFiles);
+        writeDependencies(inputFiles, { getDefaultDependencyTarget("") });
+    }
+    if (cachedGeneration != nullptr && !snapshotContents.empty()) {
+        cachedGeneration->umbrellaContent = umbrellaContent;
+        cachedGeneration->inputFiles = std::move(inputFiles);
+        cachedGeneration->metas = Meta::MetaSnapshot::loadFromString(snapshotContents);
+        cachedGeneration->moduleDependencies = std::move(moduleDependencies);
+    }
+
+    printRunningTime(begin);
+    return 0;
+}
+
+// Parses the arguments of a client and generates its outputs. The server's linked snapshot stays loaded between requests.
+static int handleRequest(const std::vector<std::string>& request, Meta::MetaSnapshot* linkedSnapshot, const std::string& linkedSnapshotFile, std::map<std::vector<std::string>, CachedGeneration>& cachedGenerations)
+{
+    std::clock_t begin = clock();
+
+    // The request is the working directory of the client followed by its command line
+    if (request.size() < 2) {
+        std::cerr << "error: Invalid request." << std::endl;
+        return 1;
+    }
+    if (::chdir(request[0].c_str()) != 0) {
+        std::cerr << "error: Unable to change the working directory to " << request[0] << "." << std::endl;
+        return 1;
+    }
+
+    std::vector<const char*> argv;
+    for (size_t i = 1; i < request.size(); i++) {
+        argv.push_back(request[i].c_str());
+    }
+    llvm::cl::ResetAllOptionOccurrences();
+    std::string errors;
+    llvm::raw_string_ostream errorsStream(errors);
+    if (!llvm::cl::ParseCommandLineOptions(argv.size(), argv.data(), "", &errorsStream)) {
+        std::cerr << errorsStream.str();
+        return 1;
+    }
+    dumpArgs(std::cout, argv.size(), argv.data());
+
+    if (!cla_linkSnapshotFile.empty() && cla_linkSnapshotFile != linkedSnapshotFile) {
+        std::cerr << "error: The server links with " << (linkedSnapshotFile.empty() ? "no snapshot" : linkedSnapshotFile) << " instead of " << cla_linkSnapshotFile << "." << std::endl;
+        return 1;
+    }
+
+    return generate(begin, linkedSnapshot, &cachedGenerations[request]);
+}
+
+static int runServer(Meta::MetaSnapshot* linkedSnapshot)
+{
+    // The options are parsed again for each request. The working directory changes to the one of each client.
+    llvm::SmallString<256> socketPath(cla_serverSocket.getValue());
+    llvm::sys::fs::make_absolute(socketPath);
+    std::string linkedSnapshotFile = cla_linkSnapshotFile;
+
+    // A client which disconnects before reading its response mustn't stop the server
+    ::signal(SIGPIPE, SIG_IGN);
+    std::unique_ptr<utils::UnixSocket> server = utils::UnixSocket::listen(socketPath.str().str());
+    std::cout << "Listening at " << socketPath.str().str() << std::endl;
+
+    std::map<std::vector<std::string>, CachedGeneration> cachedGenerations;
+    while (true) {
+        std::unique_ptr<utils::UnixSocket> client = server->accept();
+        int exitCode = 1;
+        try {
+            std::vector<std::string> request = client->receiveMessage();
+
+            // The output of the request, including the diagnostics of clang, is sent to the client instead of the server's log
+            utils::OutputCapture output;
+            try {
+                exitCode = handleRequest(request, linkedSnapshot, linkedSnapshotFile, cachedGenerations);
+            } catch (const std::exception& e) {
+                std::cerr << "error: " << e.what() << std::endl;
+            }
+
+            client->sendMessage({ std::to_string(exitCode), output.finish() });
+        } catch (const std::exception& e) {
+            std::cerr << "warning: " << e.what() << std::endl;
+        }
+        std::cout << "Handled a request with exit code " << exitCode << std::endl;
+    }
+}
+
+// Sends the command line to a server and prints its output
+static int runClient(int argc, const char** argv)
+{
+    llvm::SmallString<256> currentPath;
+    if (std::error_code error = llvm::sys::fs::current_path(currentPath)) {
+        throw std::runtime_error("Unable to get the working directory: " + error.message());
+    }
+
+    std::unique_ptr<utils::UnixSocket> socket = utils::UnixSocket::connect(cla_connectSocket);
+    std::vector<std::string> request{ currentPath.str().str() };
+    request.insert(request.end(), argv, argv + argc);
+    socket->sendMessage(request);
+
+    std::vector<std::string> response = socket->receiveMessage();
+    if (response.size() != 2) {
+        throw std::runtime_error("Invalid response from " + cla_connectSocket);
+    }
+    std::cout << response[1];
+    return std::stoi(response[0]);
+}
+
+int main(int argc, const char** argv)
+{
+    try {
+        std::clock_t begin = clock();
+
+        llvm::cl::ParseCommandLineOptions(argc, argv);
+
+        // the server parses the arguments and logs them
+        if (!cla_connectSocket.empty()) {
+            return runClient(argc, argv);
+        }
+
+        // Log Metadata Genrator Arguments
+        dumpArgs(std::cout, argc, argv);
+        dumpArgs(std::cerr, argc, argv);
+
+        // the prebuilt modules are loaded upfront, so that an invalid snapshot is reported before parsing
+        std::unique_ptr<Meta::MetaSnapshot> linkedSnapshot;
+        if (!cla_linkSnapshotFile.empty()) {
+            linkedSnapshot = Meta::MetaSnapshot::load(cla_linkSnapshotFile);
+            std::cout << "Linking with " << linkedSnapshot->getMetasByModules().size() << " prebuilt top level modules from " << cla_linkSnapshotFile << std::endl;
+        }
+
+        if (!cla_serverSocket.empty()) {
+            return runServer(linkedSnapshot.get());
+        }
+
+        return generate(begin, linkedSnapshot.get(), nullptr);
     } catch (const std::exception& e) {
         std::cerr << "error: " << e.what() << std::endl;
         return 1;
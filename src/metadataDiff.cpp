@@ -0,0 +1,319 @@
+#include "Binary/metaFileReader.h"
+#include <array>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <map>
+#include <set>
+
+// Command line parameters
+llvm::cl::opt<std::string> cla_oldFile(llvm::cl::Positional, llvm::cl::desc("<old metadata file>"), llvm::cl::Required);
+llvm::cl::opt<std::string> cla_newFile(llvm::cl::Positional, llvm::cl::desc("<new metadata file>"), llvm::cl::Required);
+llvm::cl::opt<bool>        cla_summaryOnly("summary-only", llvm::cl::desc("Print only the counts of changed symbols and the size deltas per module"), llvm::cl::value_desc("bool"));
+
+struct MetadataContents {
+    size_t fileSize = 0;
+    size_t heapSize = 0;
+    size_t compressedBlocksCount = 0;
+    size_t compressedBucketsCount = 0;
+    uint8_t formatVersion = 0;
+    std::map<std::string, binary::ModuleDescription> modules;
+    std::map<std::string, binary::SymbolDescription> symbols;
+    std::set<std::string> nativeProtocols;
+    std::set<std::string> nativeInterfaces;
+};
+
+struct DiffCounts {
+    size_t added = 0;
+    size_t removed = 0;
+    size_t changed = 0;
+};
+
+static const char* getMetaTypeName(binary::BinaryMetaType type)
+{
+    switch (type) {
+    case binary::BinaryMetaType::Struct:
+        return "struct";
+    case binary::BinaryMetaType::Union:
+        return "union";
+    case binary::BinaryMetaType::Function:
+        return "function";
+    case binary::BinaryMetaType::JsCode:
+        return "jscode";
+    case binary::BinaryMetaType::Var:
+        return "var";
+    case binary::BinaryMetaType::Interface:
+        return "interface";
+    case binary::BinaryMetaType::Protocol:
+        return "protocol";
+    default:
+        return "undefined";
+    }
+}
+
+static bool readContents(const std::string& filename, MetadataContents& contents)
+{
+    try {
+        llvm::ErrorOr<std::unique_ptr<binary::MetaFileReader> > reader = binary::MetaFileReader::open(filename);
+        if (!reader) {
+            llvm::errs() << "error: Unable to open " << filename << ": " << reader.getError().message() << "\n";
+            return false;
+        }
+
+        contents.fileSize = reader.get()->fileSize();
+        contents.heapSize = reader.get()->heapSize();
+        contents.compressedBlocksCount = reader.get()->compressedBlocksCount();
+        contents.compressedBucketsCount = reader.get()->countCompressedBuckets();
+        contents.formatVersion = reader.get()->binaryFormatVersion();
+        reader.get()->readModules(contents.modules);
+        reader.get()->readSymbols(contents.symbols);
+        reader.get()->readNativeNames(contents.nativeProtocols, contents.nativeInterfaces);
+    } catch (const std::exception& e) {
+        llvm::errs() << "error: " << filename << " is not a valid metadata file: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+static void printDelta(llvm::raw_ostream& os, size_t oldValue, size_t newValue)
+{
+    os << oldValue << " -> " << newValue << " (";
+    if (newValue >= oldValue) {
+        os << "+" << (newValue - oldValue);
+    } else {
+        os << "-" << (oldValue - newValue);
+    }
+    os << ")";
+}
+
+// Walks two sorted maps in parallel and calls the callbacks for the keys present in only one or in both of them
+template <class Map, class Removed, class Added, class Common>
+static void diffMaps(const Map& oldMap, const Map& newMap, Removed removed, Added added, Common common)
+{
+    auto oldIt = oldMap.begin();
+    auto newIt = newMap.begin();
+    while (oldIt != oldMap.end() || newIt != newMap.end()) {
+        if (newIt == newMap.end() || (oldIt != oldMap.end() && oldIt->first < newIt->first)) {
+            removed(oldIt->first, oldIt->second);
+            ++oldIt;
+        } else if (oldIt == oldMap.end() || newIt->first < oldIt->first) {
+            added(newIt->first, newIt->second);
+            ++newIt;
+        } else {
+            common(oldIt->first, oldIt->second, newIt->second);
+            ++oldIt;
+            ++newIt;
+        }
+    }
+}
+
+static std::string describeModule(const binary::ModuleDescription& module)
+{
+    std::string libraries;
+    for (const std::string& library : module.libraries) {
+        libraries += (libraries.empty() ? "" : ", ") + library;
+    }
+    return "flags=" + std::to_string(module.flags) + " libraries=[" + libraries + "]";
+}
+
+static DiffCounts diffModules(llvm::raw_ostream& os, const MetadataContents& oldContents, const MetadataContents& newContents)
+{
+    DiffCounts counts;
+    diffMaps(oldContents.modules, newContents.modules,
+        [&](const std::string& name, const binary::ModuleDescription& module) {
+            counts.removed++;
+            if (!cla_summaryOnly)
+                os << "- module " << name << " " << describeModule(module) << "\n";
+        },
+        [&](const std::string& name, const binary::ModuleDescription& module) {
+            counts.added++;
+            if (!cla_summaryOnly)
+                os << "+ module " << name << " " << describeModule(module) << "\n";
+        },
+        [&](const std::string& name, const binary::ModuleDescription& oldModule, const binary::ModuleDescription& newModule) {
+            std::string oldDescription = describeModule(oldModule);
+            std::string newDescription = describeModule(newModule);
+            if (oldDescription != newDescription) {
+                counts.changed++;
+                if (!cla_summaryOnly)
+                    os << "~ module " << name << "\n    " << oldDescription << "\n -> " << newDescription << "\n";
+            }
+        });
+    return counts;
+}
+
+static DiffCounts diffSymbols(llvm::raw_ostream& os, const MetadataContents& oldContents, const MetadataContents& newContents)
+{
+    auto printHeader = [&](char marker, const binary::SymbolDescription& symbol) {
+        os << marker << " " << getMetaTypeName(symbol.type) << " " << symbol.jsName;
+        if (symbol.name != symbol.jsName) {
+            os << " (" << symbol.name << ")";
+        }
+        os << " [" << symbol.module << "]\n";
+    };
+
+    DiffCounts counts;
+    diffMaps(oldContents.symbols, newContents.symbols,
+        [&](const std::string& jsName, const binary::SymbolDescription& symbol) {
+            counts.removed++;
+            if (!cla_summaryOnly)
+                printHeader('-', symbol);
+        },
+        [&](const std::string& jsName, const binary::SymbolDescription& symbol) {
+            counts.added++;
+            if (!cla_summaryOnly)
+                printHeader('+', symbol);
+        },
+        [&](const std::string& jsName, const binary::SymbolDescription& oldSymbol, const binary::SymbolDescription& newSymbol) {
+            bool isChanged = oldSymbol.type != newSymbol.type || oldSymbol.name != newSymbol.name || oldSymbol.module != newSymbol.module
+                || oldSymbol.attributes != newSymbol.attributes || oldSymbol.members != newSymbol.members;
+            if (!isChanged) {
+                return;
+            }
+            counts.changed++;
+            if (cla_summaryOnly) {
+                return;
+            }
+
+            printHeader('~', newSymbol);
+            if (oldSymbol.type != newSymbol.type) {
+                os << "    type: " << getMetaTypeName(oldSymbol.type) << " -> " << getMetaTypeName(newSymbol.type) << "\n";
+            }
+            if (oldSymbol.name != newSymbol.name) {
+                os << "    name: " << oldSymbol.name << " -> " << newSymbol.name << "\n";
+            }
+            if (oldSymbol.module != newSymbol.module) {
+                os << "    module: " << oldSymbol.module << " -> " << newSymbol.module << "\n";
+            }
+            diffMaps(oldSymbol.attributes, newSymbol.attributes,
+                [&](const std::string& key, const std::string& value) { os << "    " << key << ": " << value << " -> (none)\n"; },
+                [&](const std::string& key, const std::string& value) { os << "    " << key << ": (none) -> " << value << "\n"; },
+                [&](const std::string& key, const std::string& oldValue, const std::string& newValue) {
+                    if (oldValue != newValue)
+                        os << "    " << key << ": " << oldValue << " -> " << newValue << "\n";
+                });
+            diffMaps(oldSymbol.members, newSymbol.members,
+                [&](const std::string& key, const std::string& value) { os << "    - " << key << ": " << value << "\n"; },
+                [&](const std::string& key, const std::string& value) { os << "    + " << key << ": " << value << "\n"; },
+                [&](const std::string& key, const std::string& oldValue, const std::string& newValue) {
+                    if (oldValue != newValue)
+                        os << "    ~ " << key << ":\n        " << oldValue << "\n     -> " << newValue << "\n";
+                });
+        });
+    return counts;
+}
+
+static DiffCounts diffNativeNames(llvm::raw_ostream& os, const char* table, const std::set<std::string>& oldNames, const std::set<std::string>& newNames)
+{
+    DiffCounts counts;
+    auto oldIt = oldNames.begin();
+    auto newIt = newNames.begin();
+    while (oldIt != oldNames.end() || newIt != newNames.end()) {
+        if (newIt == newNames.end() || (oldIt != oldNames.end() && *oldIt < *newIt)) {
+            counts.removed++;
+            if (!cla_summaryOnly)
+                os << "- native " << table << " " << *oldIt << "\n";
+            ++oldIt;
+        } else if (oldIt == oldNames.end() || *newIt < *oldIt) {
+            counts.added++;
+            if (!cla_summaryOnly)
+                os << "+ native " << table << " " << *newIt << "\n";
+            ++newIt;
+        } else {
+            ++oldIt;
+            ++newIt;
+        }
+    }
+    return counts;
+}
+
+static void printModuleSizes(llvm::raw_ostream& os, const MetadataContents& oldContents, const MetadataContents& newContents)
+{
+    // module -> (old size, new size, old symbols count, new symbols count)
+    std::map<std::string, std::array<size_t, 4> > sizes;
+    for (const auto& symbol : oldContents.symbols) {
+        std::array<size_t, 4>& moduleSizes = sizes[symbol.second.module];
+        moduleSizes[0] += symbol.second.size;
+        moduleSizes[2]++;
+    }
+    for (const auto& symbol : newContents.symbols) {
+        std::array<size_t, 4>& moduleSizes = sizes[symbol.second.module];
+        moduleSizes[1] += symbol.second.size;
+        moduleSizes[3]++;
+    }
+
+    os << "\nSize per module (bytes reachable from its symbols):\n";
+    for (const auto& module : sizes) {
+        if (module.second[0] == module.second[1] && module.second[2] == module.second[3]) {
+            continue;
+        }
+        os << "  " << module.first << ": ";
+        printDelta(os, module.second[0], module.second[1]);
+        os << " bytes, ";
+        printDelta(os, module.second[2], module.second[3]);
+        os << " symbols\n";
+    }
+}
+
+static void printCounts(llvm::raw_ostream& os, const char* title, const DiffCounts& counts)
+{
+    os << "  " << title << ": " << counts.added << " added, " << counts.removed << " removed, " << counts.changed << " changed\n";
+}
+
+int main(int argc, const char** argv)
+{
+    llvm::cl::ParseCommandLineOptions(argc, argv, "Compares two binary metadata files symbol by symbol\n");
+
+    MetadataContents oldContents, newContents;
+    if (!readContents(cla_oldFile, oldContents) || !readContents(cla_newFile, newContents)) {
+        return 2;
+    }
+
+    llvm::raw_ostream& os = llvm::outs();
+    DiffCounts modules = diffModules(os, oldContents, newContents);
+    DiffCounts symbols = diffSymbols(os, oldContents, newContents);
+    DiffCounts nativeProtocols = diffNativeNames(os, "protocol", oldContents.nativeProtocols, newContents.nativeProtocols);
+    DiffCounts nativeInterfaces = diffNativeNames(os, "interface", oldContents.nativeInterfaces, newContents.nativeInterfaces);
+
+    printModuleSizes(os, oldContents, newContents);
+
+    os << "\nSummary:\n";
+    printCounts(os, "Modules", modules);
+    printCounts(os, "Symbols", symbols);
+    printCounts(os, "Native protocol names", nativeProtocols);
+    printCounts(os, "Native interface names", nativeInterfaces);
+    os << "  File size: ";
+    printDelta(os, oldContents.fileSize, newContents.fileSize);
+    os << " bytes, heap size: ";
+    printDelta(os, oldContents.heapSize, newContents.heapSize);
+    os << " bytes\n";
+    if (oldContents.compressedBlocksCount != 0 || newContents.compressedBlocksCount != 0) {
+        // The heap sizes above are the decompressed ones
+        os << "  Compressed heap blocks: ";
+        printDelta(os, oldContents.compressedBlocksCount, newContents.compressedBlocksCount);
+        os << "\n";
+    }
+    if (oldContents.formatVersion != newContents.formatVersion) {
+        // Shared members change the sizes, but not the decoded symbols
+        os << "  Format version: " << (unsigned)oldContents.formatVersion << " -> " << (unsigned)newContents.formatVersion << "\n";
+    }
+
+    // The buckets of the global tables have to stay uncompressed, so looking up a symbol doesn't decompress a block
+    bool hasCompressedBuckets = false;
+    typedef std::pair<const std::string*, const MetadataContents*> NamedContents;
+    for (const NamedContents& file : { NamedContents(&cla_oldFile.getValue(), &oldContents), NamedContents(&cla_newFile.getValue(), &newContents) }) {
+        if (file.second->compressedBucketsCount != 0) {
+            llvm::errs() << "error: " << *file.first << ": " << file.second->compressedBucketsCount << " buckets of the global tables are in compressed blocks\n";
+            hasCompressedBuckets = true;
+        }
+    }
+    if (hasCompressedBuckets) {
+        return 2;
+    }
+
+    bool isDifferent = false;
+    for (const DiffCounts& counts : { modules, symbols, nativeProtocols, nativeInterfaces }) {
+        isDifferent = isDifferent || counts.added != 0 || counts.removed != 0 || counts.changed != 0;
+    }
+    // Like diff, exit with 1 if the files differ semantically and with 2 on errors
+    return isDifferent ? 1 : 0;
+}
@@ -12,10 +12,21 @@ EOF
     exit 1
 fi
 
+function NormalizeYaml() {
+    OUTDIR=$1
+    # Omit built-in intrinsics module from comparison (contains entities specific to the LLVM version installed on the machine)
+    find $OUTDIR -name _Builtin_intrinsics.yaml -type f -delete
+    # Unify paths to SDK stripping quotes
+    find $OUTDIR -name \*.yaml -type f -exec perl -pi -e "s|(: *)['\"]?.*(/SDKs/.*?)['\"]? *$|\1/...\2|g" {} \;
+    # Remove empty []
+    find $OUTDIR -name \*.yaml -type f -exec perl -pi -e "s|\[\] *||g" {} \;
+}
+
 function GenerateMetadata() {
     MDG=$1
     HEADER=$2
     OUTDIR=$3
+    SNAPSHOT=$4
     (
         cd $(dirname "$MDG")
         SYSROOT=$DEVELOPER_DIR/Platforms/iPhoneSimulator.platform/Developer/SDKs/iPhoneSimulator.sdk
@@ -23,17 +34,27 @@ function GenerateMetadata() {
         # delete old output files
         rm -rf $OUTDIR
         # start metadata generator and save verbose log to file, while stripping "verbose: " prefixed messages from command's output
-        ./$(basename $MDG) -verbose -output-bin $OUTDIR/metadata-x86_64.bin -output-yaml $OUTDIR/metadata-x86_64.yaml -input-umbrella $HEADER \
+        ./$(basename $MDG) -verbose -output-bin $OUTDIR/metadata-x86_64.bin -output-yaml $OUTDIR/metadata-x86_64.yaml -output-snapshot $SNAPSHOT -input-umbrella $HEADER \
         Xclang \
         -isysroot $SYSROOT -arch x86_64 -mios-simulator-version-min=9.0 -std=gnu99 -DDEBUG=1 2>&1 | \
         tee "$(dirname $OUTDIR)/verbose.out" | grep -v "verbose: "
 
-        # Omit built-in intrinsics module from comparison (contains entities specific to the LLVM version installed on the machine)
-        find $OUTDIR -name _Builtin_intrinsics.yaml -type f -delete
-        # Unify paths to SDK stripping quotes
-        find $OUTDIR -name \*.yaml -type f -exec perl -pi -e "s|(: *)['\"]?.*(/SDKs/.*?)['\"]? *$|\1/...\2|g" {} \;
-        # Remove empty []
-        find $OUTDIR -name \*.yaml -type f -exec perl -pi -e "s|\[\] *||g" {} \;
+        NormalizeYaml $OUTDIR
+    )
+}
+
+# Regenerates the outputs from the snapshot of the headers, once uncompressed and once with a compressed heap
+function GenerateMetadataFromSnapshot() {
+    MDG=$1
+    SNAPSHOT=$2
+    OUTDIR=$3
+    (
+        cd $(dirname "$MDG")
+
+        ./$(basename $MDG) -input-snapshot $SNAPSHOT -output-bin $OUTDIR/metadata-x86_64.bin -output-yaml $OUTDIR/metadata-x86_64.yaml > /dev/null
+        ./$(basename $MDG) -input-snapshot $SNAPSHOT -output-bin $OUTDIR/metadata-x86_64-compressed.bin -binary-compression-block-size 16384 > /dev/null
+
+        NormalizeYaml $OUTDIR
     )
 }
 
@@ -46,9 +67,24 @@ if [ ! -d "$EXPECTEDOUTPUTDIR" ]; then
 fi
 
 TESTOUTPUTDIR=$TESTSDIR/TestOutput
+ROUNDTRIPOUTPUTDIR=$TESTSDIR/TestOutputRoundTrip
+METADATADIFF=$(dirname "$MDG")/metadata-diff
 
-GenerateMetadata $MDG $TESTSDIR/AllSystemFrameworks.h $TESTOUTPUTDIR
+rm -rf $ROUNDTRIPOUTPUTDIR
+mkdir -p $ROUNDTRIPOUTPUTDIR
+GenerateMetadata $MDG $TESTSDIR/AllSystemFrameworks.h $TESTOUTPUTDIR $ROUNDTRIPOUTPUTDIR/metadata-x86_64.snapshot
 
 echo "Comparing test outputs..."
 (diff -qwr $EXPECTEDOUTPUTDIR $TESTOUTPUTDIR && echo "Test run successful, no differences encountered.") ||
 (echo "error: Metadata generator didn't produce the expected output. Fix or accept the new one by replacing $EXPECTEDOUTPUTDIR with $TESTOUTPUTDIR" 1>&2 && false)
+
+# The outputs generated from the snapshot have to be the same as the ones generated from the headers.
+# metadata-diff also fails if a lookup in the compressed file has to decompress a block.
+GenerateMetadataFromSnapshot $MDG $ROUNDTRIPOUTPUTDIR/metadata-x86_64.snapshot $ROUNDTRIPOUTPUTDIR/Output
+
+echo "Comparing round trip outputs..."
+(diff -qwr $TESTOUTPUTDIR/metadata-x86_64.yaml $ROUNDTRIPOUTPUTDIR/Output/metadata-x86_64.yaml \
+    && "$METADATADIFF" -summary-only $TESTOUTPUTDIR/metadata-x86_64.bin $ROUNDTRIPOUTPUTDIR/Output/metadata-x86_64.bin > /dev/null \
+    && "$METADATADIFF" -summary-only $TESTOUTPUTDIR/metadata-x86_64.bin $ROUNDTRIPOUTPUTDIR/Output/metadata-x86_64-compressed.bin > /dev/null \
+    && echo "Round trip successful, the snapshot and the compressed metadata have the same contents.") ||
+(echo "error: The outputs generated from the snapshot in $ROUNDTRIPOUTPUTDIR differ from the ones in $TESTOUTPUTDIR" 1>&2 && false)